@@ -0,0 +1,122 @@
+/*
+ * bench.h — zero-dependency single-header benchmark framework for libvtermcpp
+ *
+ * Usage:
+ *   #include "bench.h"
+ *   BENCH(my_bench) { auto input = make_input(); bench_run(state, input); }
+ *
+ * Benchmarks are auto-registered via constructor attribute, like tests.
+ * bench_main.cpp calls bench_run_all() which runs them and prints results.
+ */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <format>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+// --- Benchmark registration ---
+
+struct BenchState;
+
+using bench_fn = void(*)(BenchState& _bench);
+
+struct bench_entry {
+    std::string_view bench_name{};
+    std::string_view bench_file{};
+    bench_fn fn = nullptr;
+};
+
+inline constexpr int32_t BENCH_MAX = 256;
+
+// Global benchmark registry — defined in bench_main.cpp
+extern std::array<bench_entry, BENCH_MAX> g_benches;
+extern int32_t g_bench_count;
+
+#define BENCH(name)                                                         \
+    static void bench_##name([[maybe_unused]] BenchState& _bench);          \
+    __attribute__((constructor)) static void bench_register_##name() {       \
+        g_benches[g_bench_count].bench_name = #name;                        \
+        g_benches[g_bench_count].bench_file = __FILE__;                     \
+        g_benches[g_bench_count].fn = bench_##name;                         \
+        g_bench_count++;                                                    \
+    }                                                                       \
+    static void bench_##name([[maybe_unused]] BenchState& _bench)
+
+// --- Measurement ---
+
+struct BenchState {
+    std::string_view name;
+
+    // Minimum wall time to spend in each measured loop
+    std::chrono::nanoseconds min_time = std::chrono::milliseconds(300);
+};
+
+using bench_clock = std::chrono::steady_clock;
+
+// Run `body` repeatedly until at least min_time has elapsed and report the
+// per-iteration time. `bytes_per_iter` (if non-zero) adds a throughput column;
+// `label` distinguishes several measurements made by one benchmark.
+template<typename Body>
+void bench_measure(BenchState& state, std::string_view label, size_t bytes_per_iter, Body&& body)
+{
+    // Warm-up
+    body();
+
+    int64_t iters = 0;
+    auto start = bench_clock::now();
+    auto elapsed = bench_clock::duration::zero();
+    do {
+        body();
+        iters++;
+        elapsed = bench_clock::now() - start;
+    } while(elapsed < state.min_time);
+
+    double ns_per_iter = std::chrono::duration<double, std::nano>(elapsed).count() / static_cast<double>(iters);
+
+    std::string line = std::format("{:<40} {:<28} {:>14} ns/iter",
+        state.name, label, static_cast<int64_t>(ns_per_iter));
+    if(bytes_per_iter) {
+        double mb_per_s = (static_cast<double>(bytes_per_iter) / (1024.0 * 1024.0)) / (ns_per_iter / 1e9);
+        line += std::format(" {:>10} MB/s", static_cast<int64_t>(mb_per_s));
+    }
+    std::cout << line << "\n";
+}
+
+// Report a non-timing result, such as memory use, in the same layout
+inline void bench_report(const BenchState& state, std::string_view label, std::string_view value)
+{
+    std::cout << std::format("{:<40} {:<28} {}\n", state.name, label, value);
+}
+
+// Keep the optimiser from discarding a computed value
+template<typename T>
+inline void bench_keep(const T& value)
+{
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// --- Runner (called from bench_main.cpp) ---
+
+inline int bench_run_all(int argc, char** argv)
+{
+    std::string_view filter = (argc > 1) ? std::string_view{argv[1]} : std::string_view{};
+
+    for(int32_t i = 0; i < g_bench_count; i++) {
+        if(!filter.empty() && g_benches[i].bench_name.find(filter) == std::string_view::npos)
+            continue;
+
+        BenchState state;
+        state.name = g_benches[i].bench_name;
+        g_benches[i].fn(state);
+    }
+
+    return 0;
+}
+
+#endif // BENCH_H
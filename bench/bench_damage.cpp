@@ -0,0 +1,227 @@
+// bench_damage.cpp — cells repainted under each damage merge mode
+
+#include "bench.h"
+#include "corpus.h"
+
+#include "vterm/vterm.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+using namespace vterm;
+
+namespace {
+
+// A trace is a sequence of frames; the renderer flushes damage after each
+using Trace = std::vector<std::string>;
+
+struct RepaintCounter : ScreenCallbacks {
+    int64_t cells = 0;
+    int64_t rects = 0;
+
+    bool on_damage(Rect rect) override {
+        cells += int64_t{rect.end_row - rect.start_row} * (rect.end_col - rect.start_col);
+        rects++;
+        return true;
+    }
+    // Scrolls are blitted, not repainted
+    bool on_moverect(Rect, Rect) override { return true; }
+};
+
+// The scrollback stress golden files, each row printed as one frame
+std::vector<Trace> golden_traces()
+{
+    std::vector<std::filesystem::path> files;
+    for(const auto& entry : std::filesystem::directory_iterator(BENCH_GOLDEN_DIR))
+        files.push_back(entry.path());
+    std::ranges::sort(files);
+
+    std::vector<Trace> traces;
+    for(const auto& file : files) {
+        std::ifstream in(file);
+        Trace trace;
+        for(std::string line; std::getline(in, line); ) {
+            auto open = line.find('|');
+            auto close = line.rfind('|');
+            if(open == std::string::npos || close == open)
+                continue;
+            trace.push_back(line.substr(open + 1, close - open - 1) + "\r\n");
+        }
+        traces.push_back(std::move(trace));
+    }
+    return traces;
+}
+
+// vttest's cursor movement screen: a border drawn with absolute and
+// relative moves around a DECALN-filled screen
+Trace vttest_movement_trace()
+{
+    Trace trace{"\x1b#8", "\x1b[9;10H\x1b[1J", "\x1b[18;60H\x1b[0J\x1b[1K", "\x1b[9;71H\x1b[0K"};
+    for(int32_t i = 10; i <= 16; i++)
+        trace.push_back(std::format("\x1b[{};10H\x1b[1K\x1b[{};71H\x1b[0K", i, i));
+    trace.push_back("\x1b[17;30H\x1b[2K");
+    for(int32_t i = 1; i <= 80; i++)
+        trace.push_back(std::format("\x1b[24;{}f*\x1b[1;{}f*", i, i));
+    trace.push_back("\x1b[2;2H");
+    for(int32_t i = 0; i < 22; i++)
+        trace.push_back("+\x1b[1D\x1b" "D");
+    trace.push_back("\x1b[23;79H");
+    for(int32_t i = 0; i < 22; i++)
+        trace.push_back("+\x1b[1D\x1bM");
+    for(int32_t i = 2; i <= 23; i++)
+        trace.push_back(std::format("\x1b[{};1H*\x1b[{};80H*", i, i));
+    return trace;
+}
+
+// An editor idling: a clock top right, the cursor cell, and the status line
+Trace status_trace()
+{
+    CorpusRng rng;
+    Trace trace{"\x1b[2J"};
+    for(int32_t i = 0; i < 500; i++)
+        trace.push_back(std::format("\x1b[1;73H{:02}:{:02}:{:02}\x1b[{};{}H{}\x1b[25;1H-- INSERT -- {:>5},{:<3}",
+                                    i / 3600, i / 60 % 60, i % 60,
+                                    2 + rng.below(22), 1 + rng.below(80), static_cast<char>('a' + rng.below(26)),
+                                    rng.below(10000), rng.below(80)));
+    return trace;
+}
+
+// Full-screen TUI redraws, one frame per screen
+Trace tui_trace()
+{
+    std::string input = corpus_build_tui(256 * 1024, 25, 80);
+    Trace trace;
+    for(size_t pos = 0; pos < input.size(); ) {
+        size_t next = input.find("\x1b[?25l", pos + 1);
+        if(next == std::string::npos)
+            next = input.size();
+        trace.push_back(input.substr(pos, next - pos));
+        pos = next;
+    }
+    return trace;
+}
+
+struct Repaint {
+    int64_t cells = 0;
+    int64_t rects = 0;
+};
+
+Repaint replay(const std::vector<Trace>& traces, DamageSize mode)
+{
+    Repaint total;
+    for(const auto& trace : traces) {
+        Terminal vt(25, 80);
+        vt.set_utf8(true);
+        Screen& screen = vt.screen();
+        RepaintCounter counter;
+        screen.set_callbacks(counter);
+        screen.reset(true);
+        screen.set_damage_merge(mode);
+        counter = {};
+        for(const auto& frame : trace) {
+            (void)vt.write(frame);
+            screen.flush_damage();
+        }
+        total.cells += counter.cells;
+        total.rects += counter.rects;
+    }
+    return total;
+}
+
+void bench_modes(BenchState& state, const std::vector<Trace>& traces)
+{
+    static constexpr std::pair<DamageSize, std::string_view> modes[] = {
+        {DamageSize::Row, "row"},
+        {DamageSize::Screen, "screen"},
+        {DamageSize::Region, "region"},
+    };
+    for(auto [mode, name] : modes) {
+        Repaint repaint = replay(traces, mode);
+        bench_report(state, name, std::format("{:>14} cells {:>10} rects", repaint.cells, repaint.rects));
+    }
+
+    size_t bytes = 0;
+    for(const auto& trace : traces)
+        for(const auto& frame : trace)
+            bytes += frame.size();
+    for(auto [mode, name] : modes)
+        bench_measure(state, name, bytes, [&] { bench_keep(replay(traces, mode).cells); });
+}
+
+} // anonymous namespace
+
+BENCH(damage_golden_traces)
+{
+    bench_modes(_bench, golden_traces());
+}
+
+BENCH(damage_vttest_movement)
+{
+    bench_modes(_bench, {vttest_movement_trace()});
+}
+
+BENCH(damage_status_updates)
+{
+    bench_modes(_bench, {status_trace()});
+}
+
+BENCH(damage_tui_redraws)
+{
+    bench_modes(_bench, {tui_trace()});
+}
+
+namespace {
+
+struct CallbackCounter : ScreenCallbacks {
+    int64_t calls = 0;
+    bool on_damage(Rect) override { calls++; return true; }
+    bool on_moverect(Rect, Rect) override { calls++; return true; }
+    bool on_movecursor(Pos, Pos, bool) override { calls++; return true; }
+    bool on_settermprop(Prop, const Value&) override { calls++; return true; }
+};
+
+void bench_batching(BenchState& state, const std::string& input)
+{
+    constexpr size_t read_size = 64 * 1024;
+
+    for(bool batched : {false, true}) {
+        Terminal vt(50, 200);
+        vt.set_utf8(true);
+        Screen& screen = vt.screen();
+        CallbackCounter counter;
+        screen.set_callbacks(counter);
+        screen.reset(true);
+
+        auto run = [&] {
+            for(size_t pos = 0; pos < input.size(); pos += read_size) {
+                if(batched)
+                    vt.begin_batch();
+                (void)vt.write(std::string_view(input).substr(pos, read_size));
+                if(batched)
+                    vt.end_batch();
+            }
+        };
+
+        counter.calls = 0;
+        run();
+        std::string_view label = batched ? "batched" : "per event";
+        bench_report(state, label, std::format("{:>14} callbacks", counter.calls));
+        bench_measure(state, label, input.size(), run);
+    }
+}
+
+} // anonymous namespace
+
+// 64 KB pty reads, each delivered per event or as one batch
+BENCH(damage_batch_log)
+{
+    bench_batching(_bench, corpus_build_log(4 * 1024 * 1024));
+}
+
+BENCH(damage_batch_tui)
+{
+    bench_batching(_bench, corpus_build_tui(4 * 1024 * 1024));
+}
@@ -0,0 +1,63 @@
+// bench_encoding.cpp — UTF-8 decoder benchmarks
+
+#include "bench.h"
+#include "corpus.h"
+
+#include "internal.h"
+
+#include <vector>
+
+using namespace vterm;
+
+namespace {
+
+constexpr size_t corpus_size = 4 * 1024 * 1024;
+
+// Decode the whole input the way State::on_text does: up to 1024 codepoints
+// per call, stopping at C0 controls (which are skipped here)
+void measure_decode(BenchState& state, const std::string& input)
+{
+    auto utf8 = create_encoding(EncodingType::UTF8, 'u');
+    std::vector<uint32_t> codepoints(1024);
+
+    bench_measure(state, "UTF8Encoding::decode", input.size(), [&] {
+        utf8->init();
+        size_t pos = 0;
+        int32_t produced = 0;
+        while(pos < input.size()) {
+            auto result = utf8->decode(codepoints, std::span{input}.subspan(pos));
+            produced += result.codepoints_produced;
+            pos += result.bytes_consumed;
+            if(result.codepoints_produced == 0 && result.bytes_consumed == 0)
+                pos++;
+        }
+        bench_keep(produced);
+    });
+}
+
+} // anonymous namespace
+
+BENCH(utf8_decode_ascii_log)
+{
+    measure_decode(_bench, corpus_build_log(corpus_size));
+}
+
+BENCH(utf8_decode_mixed_cjk)
+{
+    measure_decode(_bench, corpus_build_mixed_cjk(corpus_size));
+}
+
+// The same mixed CJK log through the full pipeline
+BENCH(terminal_mixed_cjk_log)
+{
+    std::string input = corpus_build_mixed_cjk(corpus_size);
+
+    Terminal vt(50, 200);
+    vt.set_utf8(true);
+    Screen& screen = vt.screen();
+    screen.reset(true);
+
+    bench_measure(_bench, "parser+state+screen", input.size(), [&] {
+        bench_keep(vt.write(input));
+    });
+}
@@ -0,0 +1,10 @@
+// bench_main.cpp — benchmark runner for libvtermcpp
+
+#include "bench.h"
+
+std::array<bench_entry, BENCH_MAX> g_benches{};
+int32_t g_bench_count = 0;
+
+int main(int argc, char** argv) {
+    return bench_run_all(argc, argv);
+}
@@ -0,0 +1,130 @@
+// bench_parser.cpp — parser throughput benchmarks
+
+#include "bench.h"
+#include "corpus.h"
+
+#include "vterm/vterm.h"
+
+#include <span>
+
+using namespace vterm;
+
+namespace {
+
+constexpr size_t corpus_size = 4 * 1024 * 1024;
+
+// Consumes each text run whole. The parser passes the run followed by the
+// byte that ended it (if any), so only the final byte needs inspecting.
+struct NullParserCallbacks : ParserCallbacks {
+    int32_t on_text(std::span<const char> bytes) override {
+        size_t len = bytes.size();
+        uint8_t last = static_cast<uint8_t>(bytes[len - 1]);
+        if(last < 0x20 || last == 0x7f)
+            len--;
+        return static_cast<int32_t>(len);
+    }
+    bool on_control(uint8_t) override { return true; }
+    bool on_csi(std::string_view, std::span<const int64_t>, std::string_view, char) override { return true; }
+};
+
+void bench_parser_only(BenchState& state, const std::string& input, ParserEngine engine, std::string_view label)
+{
+    Terminal vt(50, 200);
+    vt.set_utf8(true);
+    vt.set_parser_engine(engine);
+    NullParserCallbacks cbs;
+    vt.parser_set_callbacks(cbs);
+
+    bench_measure(state, label, input.size(), [&] {
+        bench_keep(vt.write(input));
+    });
+}
+
+} // anonymous namespace
+
+// Raw parser with a trivial sink — isolates the byte dispatch loop
+BENCH(parser_ascii_build_log)
+{
+    std::string input = corpus_build_log(corpus_size);
+    bench_parser_only(_bench, input, ParserEngine::Switch, "parser only, switch");
+    bench_parser_only(_bench, input, ParserEngine::Table, "parser only, table");
+}
+
+// Escape-heavy full-screen redraws
+BENCH(parser_escape_heavy_tui)
+{
+    std::string input = corpus_build_tui(corpus_size);
+    bench_parser_only(_bench, input, ParserEngine::Switch, "parser only, switch");
+    bench_parser_only(_bench, input, ParserEngine::Table, "parser only, table");
+}
+
+// Full pipeline: parser, state and screen
+BENCH(terminal_ascii_build_log)
+{
+    std::string input = corpus_build_log(corpus_size);
+
+    Terminal vt(50, 200);
+    vt.set_utf8(true);
+    Screen& screen = vt.screen();
+    screen.reset(true);
+
+    bench_measure(_bench, "parser+state+screen", input.size(), [&] {
+        bench_keep(vt.write(input));
+    });
+}
+
+// Plain log lines a page at a time (cursor home rather than scrolling), so
+// glyph placement rather than scrolling dominates
+BENCH(terminal_ascii_log_pages)
+{
+    std::string log = corpus_build_log(corpus_size);
+    std::string input;
+    input.reserve(log.size() + log.size() / 64);
+    int32_t line = 0;
+    for(size_t start = 0; start < log.size(); ) {
+        size_t end = log.find('\n', start) + 1;
+        if(line++ % 20 == 0)
+            input += "\x1b[H";
+        input.append(log, start, end - start);
+        start = end;
+    }
+
+    Terminal vt(50, 200);
+    vt.set_utf8(true);
+    Screen& screen = vt.screen();
+    screen.reset(true);
+
+    bench_measure(_bench, "parser+state+screen", input.size(), [&] {
+        bench_keep(vt.write(input));
+    });
+}
+
+// `tail -f` on a tall terminal: every line feed scrolls the whole screen
+BENCH(terminal_tail_300_rows)
+{
+    std::string input = corpus_build_log(corpus_size);
+
+    Terminal vt(300, 120);
+    vt.set_utf8(true);
+    Screen& screen = vt.screen();
+    screen.reset(true);
+
+    bench_measure(_bench, "parser+state+screen", input.size(), [&] {
+        bench_keep(vt.write(input));
+    });
+}
+
+// The same inside a DECSTBM region, as under a status line
+BENCH(terminal_tail_300_rows_region)
+{
+    std::string input = "\x1b[1;299r\x1b[299;1H" + corpus_build_log(corpus_size);
+
+    Terminal vt(300, 120);
+    vt.set_utf8(true);
+    Screen& screen = vt.screen();
+    screen.reset(true);
+
+    bench_measure(_bench, "parser+state+screen", input.size(), [&] {
+        bench_keep(vt.write(input));
+    });
+}
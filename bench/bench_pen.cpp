@@ -0,0 +1,79 @@
+// bench_pen.cpp — SGR / pen update benchmarks
+
+#include "bench.h"
+#include "corpus.h"
+
+#include "vterm/vterm.h"
+
+using namespace vterm;
+
+namespace {
+
+constexpr size_t corpus_size = 4 * 1024 * 1024;
+
+} // anonymous namespace
+
+// SGR-heavy colourised listings through the full pipeline
+BENCH(terminal_colorized_output)
+{
+    std::string input = corpus_build_colorized(corpus_size);
+
+    Terminal vt(50, 200);
+    vt.set_utf8(true);
+    Screen& screen = vt.screen();
+    screen.reset(true);
+
+    bench_measure(_bench, "parser+state+screen", input.size(), [&] {
+        bench_keep(vt.write(input));
+    });
+}
+
+namespace {
+
+struct BatchedPenCallbacks : StateCallbacks {
+    Pen last{};
+    bool on_setpen(const Pen& pen, AttrMask) override { last = pen; return true; }
+};
+
+struct PerAttrPenCallbacks : StateCallbacks {
+    int32_t count = 0;
+    bool on_setpenattr(Attr, const Value&) override { count++; return true; }
+};
+
+// Truecolor SGR sequences only, e.g. ESC[0;1;38;2;r;g;b;48;2;r;g;bm
+std::string sgr_only_corpus(size_t target_bytes)
+{
+    CorpusRng rng;
+    std::string out;
+    while(out.size() < target_bytes) {
+        out += "\x1b[0;1;38;2;" + std::to_string(rng.below(256)) + ";" + std::to_string(rng.below(256)) + ";"
+             + std::to_string(rng.below(256)) + ";48;2;" + std::to_string(rng.below(256)) + ";"
+             + std::to_string(rng.below(256)) + ";" + std::to_string(rng.below(256)) + "m";
+    }
+    return out;
+}
+
+} // anonymous namespace
+
+// Cost of SGR handling in State, batched versus per-attribute delivery
+BENCH(state_sgr_truecolor)
+{
+    std::string input = sgr_only_corpus(corpus_size / 4);
+
+    {
+        Terminal vt(50, 200);
+        BatchedPenCallbacks cbs;
+        vt.state().set_callbacks(cbs);
+        bench_measure(_bench, "on_setpen", input.size(), [&] {
+            bench_keep(vt.write(input));
+        });
+    }
+    {
+        Terminal vt(50, 200);
+        PerAttrPenCallbacks cbs;
+        vt.state().set_callbacks(cbs);
+        bench_measure(_bench, "on_setpenattr fallback", input.size(), [&] {
+            bench_keep(vt.write(input));
+        });
+    }
+}
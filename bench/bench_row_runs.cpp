@@ -0,0 +1,71 @@
+// bench_row_runs.cpp — redrawing a screen cell by cell vs as attribute runs
+
+#include "bench.h"
+#include "corpus.h"
+
+#include "vterm/vterm.h"
+
+using namespace vterm;
+
+namespace {
+
+constexpr int32_t rows = 100;
+constexpr int32_t cols = 300;
+
+struct RunCounter : RunSink {
+    size_t runs = 0;
+    size_t bytes = 0;
+    bool on_run(const ScreenRun& run) override {
+        runs++;
+        bytes += run.text.size();
+        return true;
+    }
+};
+
+void bench_redraw(BenchState& state, const std::string& input)
+{
+    Terminal vt(rows, cols);
+    vt.set_utf8(true);
+    Screen& screen = vt.screen();
+    screen.reset(true);
+    (void)vt.write(input);
+
+    // What a renderer does without runs: every cell, then the extent of its run
+    bench_measure(state, "get_cell + extent", 0, [&] {
+        size_t runs = 0;
+        ScreenCell cell{};
+        for(int32_t row = 0; row < rows; row++)
+            for(int32_t col = 0; col < cols; ) {
+                Rect extent = {.start_col = col, .end_col = -1};
+                (void)screen.get_attrs_extent(extent, {.row = row, .col = col}, AttrMask::All);
+                for(; col < extent.end_col; col++)
+                    (void)screen.get_cell({.row = row, .col = col}, cell);
+                runs++;
+            }
+        bench_keep(runs);
+        bench_keep(cell);
+    });
+
+    RunCounter counter;
+    for(int32_t row = 0; row < rows; row++)
+        (void)screen.get_row_runs(row, counter);
+    bench_report(state, "runs per screen", std::format("{:>14}", counter.runs));
+
+    bench_measure(state, "get_row_runs", 0, [&] {
+        for(int32_t row = 0; row < rows; row++)
+            (void)screen.get_row_runs(row, counter);
+        bench_keep(counter.runs);
+    });
+}
+
+} // anonymous namespace
+
+BENCH(row_runs_colorized)
+{
+    bench_redraw(_bench, corpus_build_colorized(1024 * 1024));
+}
+
+BENCH(row_runs_tui)
+{
+    bench_redraw(_bench, corpus_build_tui(1024 * 1024, rows, cols));
+}
@@ -0,0 +1,75 @@
+// bench_screen_text.cpp — text extraction, end-of-line queries, reflow and clears
+
+#include "bench.h"
+#include "corpus.h"
+
+#include "vterm/vterm.h"
+
+#include <vector>
+
+using namespace vterm;
+
+namespace {
+
+constexpr int32_t rows = 100;
+constexpr int32_t cols = 300;
+
+void bench_text(BenchState& state, const std::string& input)
+{
+    Terminal vt(rows, cols);
+    vt.set_utf8(true);
+    Screen& screen = vt.screen();
+    screen.enable_reflow(true);
+    screen.reset(true);
+    (void)vt.write(input);
+
+    std::vector<char> text(static_cast<size_t>(rows) * cols * 4);
+    Rect all{.start_row = 0, .end_row = rows, .start_col = 0, .end_col = cols};
+    size_t len = screen.get_text(text, all);
+    bench_measure(state, "get_text screen", len, [&] {
+        bench_keep(screen.get_text(text, all));
+    });
+
+    // A selection snapping its end to the end of each line
+    bench_measure(state, "is_eol every cell", 0, [&] {
+        int32_t eol = 0;
+        for(int32_t row = 0; row < rows; row++)
+            for(int32_t col = 0; col < cols; col++)
+                eol += screen.is_eol({.row = row, .col = col});
+        bench_keep(eol);
+    });
+
+    // Window drag: one column narrower and back, reflowing each time
+    bench_measure(state, "reflow resize", 0, [&] {
+        vt.set_size(rows, cols - 1);
+        vt.set_size(rows, cols);
+    });
+}
+
+} // anonymous namespace
+
+BENCH(screen_text_ascii_log)
+{
+    bench_text(_bench, corpus_build_log(1024 * 1024));
+}
+
+BENCH(screen_text_colorized)
+{
+    bench_text(_bench, corpus_build_colorized(1024 * 1024));
+}
+
+// A TUI at 60 Hz on a large terminal: clear the screen, redraw a status line
+BENCH(screen_clear_frames)
+{
+    constexpr int32_t clear_rows = 120;
+    constexpr int32_t clear_cols = 400;
+
+    Terminal vt(clear_rows, clear_cols);
+    vt.set_utf8(true);
+    vt.screen().reset(true);
+
+    std::string frame = "\x1b[44m\x1b[2J\x1b[H\x1b[1mstatus\x1b[m\x1b[120;1H-- INSERT --";
+    bench_measure(_bench, "ED 2 + status", frame.size(), [&] {
+        (void)vt.write(frame);
+    });
+}
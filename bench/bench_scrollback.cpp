@@ -0,0 +1,334 @@
+// bench_scrollback.cpp — scrollback storage memory and push throughput
+
+#include "bench.h"
+#include "corpus.h"
+
+#include "vterm/vterm.h"
+#include "scrollback_impl.h"
+
+#include <deque>
+#include <vector>
+
+using namespace vterm;
+
+namespace {
+
+constexpr int32_t sb_cols = 200;
+
+// Rows as the screen pushes them: build logs and colourised listings at 200
+// columns, with the listings' cursor homing turned into scrolling
+std::vector<std::vector<ScreenCell>> sample_rows()
+{
+    struct Capture : ScreenCallbacks {
+        std::vector<std::vector<ScreenCell>> rows;
+        bool on_sb_pushline(std::span<const ScreenCell> cells, bool) override {
+            rows.emplace_back(cells.begin(), cells.end());
+            return true;
+        }
+    } capture;
+
+    Terminal vt(50, sb_cols);
+    vt.set_utf8(true);
+    Screen& screen = vt.screen();
+    screen.set_callbacks(capture);
+    screen.reset(true);
+    std::string colorized = corpus_build_colorized(256 * 1024);
+    for(size_t pos = 0; (pos = colorized.find("\x1b[H", pos)) != std::string::npos; )
+        colorized.replace(pos, 3, "\r\n");
+    (void)vt.write(corpus_build_log(128 * 1024));
+    (void)vt.write(colorized);
+
+    capture.rows.resize(std::min<size_t>(capture.rows.size(), 1024));
+    return capture.rows;
+}
+
+// The previous storage: one heap-allocated vector of cells per line
+struct DequeScrollback {
+    std::deque<Scrollback::Line> lines;
+    size_t capacity = 0;
+
+    void push_line(std::span<const ScreenCell> cells, bool continuation) {
+        lines.push_back({.cells = {cells.begin(), cells.end()}, .continuation = continuation});
+        while(lines.size() > capacity)
+            lines.pop_front();
+    }
+
+    [[nodiscard]] size_t memory_usage() const {
+        size_t bytes = 0;
+        for(const auto& line : lines)
+            bytes += sizeof(line) + line.cells.capacity() * sizeof(ScreenCell);
+        return bytes;
+    }
+};
+
+template<typename Store>
+void bench_push(BenchState& state, std::string_view label, const std::vector<std::vector<ScreenCell>>& rows, size_t nlines)
+{
+    size_t memory = 0;
+    bench_measure(state, label, nlines * sb_cols * sizeof(ScreenCell), [&] {
+        Store store;
+        store.capacity = nlines;
+        for(size_t i = 0; i < nlines; i++)
+            store.push_line(rows[i % rows.size()], false);
+        if constexpr(requires { store.store; })
+            memory = store.store.memory_usage();
+        else
+            memory = store.memory_usage();
+        bench_keep(memory);
+    });
+    bench_report(state, label, std::format("{:>14} bytes {:>10.1f} B/line", memory,
+                                           static_cast<double>(memory) / static_cast<double>(nlines)));
+}
+
+} // anonymous namespace
+
+// Filling a scrollback of N 200-column lines; throughput is of unpacked cells
+BENCH(scrollback_push_10k)
+{
+    auto rows = sample_rows();
+    bench_push<DequeScrollback>(_bench, "deque", rows, 10'000);
+    bench_push<Scrollback::Impl>(_bench, "packed", rows, 10'000);
+}
+
+BENCH(scrollback_push_100k)
+{
+    auto rows = sample_rows();
+    bench_push<DequeScrollback>(_bench, "deque", rows, 100'000);
+    bench_push<Scrollback::Impl>(_bench, "packed", rows, 100'000);
+}
+
+// The deque would need ~8 GB here; report its size without allocating it
+BENCH(scrollback_push_1m)
+{
+    auto rows = sample_rows();
+    size_t deque_bytes = 1'000'000 * (sizeof(Scrollback::Line) + sb_cols * sizeof(ScreenCell));
+    bench_report(_bench, "deque (computed)", std::format("{:>14} bytes {:>10.1f} B/line", deque_bytes,
+                                                         static_cast<double>(deque_bytes) / 1e6));
+    bench_push<Scrollback::Impl>(_bench, "packed", rows, 1'000'000);
+}
+
+// Steady state at capacity: every push evicts the oldest line
+BENCH(scrollback_push_at_capacity)
+{
+    auto rows = sample_rows();
+    constexpr size_t nlines = 10'000;
+
+    DequeScrollback deque;
+    deque.capacity = nlines;
+    Scrollback::Impl packed;
+    packed.capacity = nlines;
+    for(size_t i = 0; i < nlines; i++) {
+        deque.push_line(rows[i % rows.size()], false);
+        packed.push_line(rows[i % rows.size()], false);
+    }
+
+    size_t next = 0;
+    bench_measure(_bench, "deque", rows.size() * sb_cols * sizeof(ScreenCell), [&] {
+        for(size_t i = 0; i < rows.size(); i++)
+            deque.push_line(rows[next++ % rows.size()], false);
+    });
+    bench_measure(_bench, "packed", rows.size() * sb_cols * sizeof(ScreenCell), [&] {
+        for(size_t i = 0; i < rows.size(); i++)
+            packed.push_line(rows[next++ % rows.size()], false);
+    });
+}
+
+// `cat build.log`: 4 MB of plain text in 64 KB writes into a 50x200 screen
+// with a 10k-line scrollback, through the parser or straight into scrollback
+BENCH(scrollback_cat_log)
+{
+    const std::string input = corpus_build_log(4 * 1024 * 1024);
+    constexpr size_t read_size = 64 * 1024;
+
+    for(bool direct : {false, true}) {
+        Terminal vt(50, sb_cols);
+        vt.set_utf8(true);
+        Screen& screen = vt.screen();
+        screen.enable_direct_scrollback(direct);
+        screen.reset(true);
+        vt.scrollback().set_capacity(10'000);
+
+        bench_measure(_bench, direct ? "direct" : "parsed", input.size(), [&] {
+            for(size_t pos = 0; pos < input.size(); pos += read_size)
+                (void)vt.write(std::string_view(input).substr(pos, read_size));
+        });
+    }
+}
+
+// A 500-row screenful scrolled off at once (`CSI 500 S`, or a resize that
+// drops 500 rows): pushed row by row or as one block, into a full scrollback
+BENCH(scrollback_push_block)
+{
+    auto rows = sample_rows();
+    constexpr size_t block_rows = 500;
+    std::vector<PushedLine> block;
+    for(size_t i = 0; i < block_rows; i++)
+        block.push_back({.cells = rows[i % rows.size()], .continuation = false});
+
+    for(size_t capacity : {size_t{10'000}, size_t{100}}) {
+        Scrollback::Impl single;
+        Scrollback::Impl bulk;
+        for(Scrollback::Impl* impl : {&single, &bulk}) {
+            impl->capacity = capacity;
+            for(size_t i = 0; i < capacity; i++)
+                impl->push_line(rows[i % rows.size()], false);
+        }
+
+        const size_t bytes = block_rows * sb_cols * sizeof(ScreenCell);
+        bench_measure(_bench, std::format("per-row cap {}", capacity), bytes, [&] {
+            for(const PushedLine& line : block)
+                single.push_line(line.cells, line.continuation);
+        });
+        bench_measure(_bench, std::format("block cap {}", capacity), bytes, [&] {
+            bulk.push_lines(block);
+        });
+    }
+}
+
+// `CSI 500 S` on a 500x200 screen filled by DECALN, into a 10k-line scrollback
+BENCH(scrollback_scroll_screenful)
+{
+    Terminal vt(500, sb_cols);
+    vt.set_utf8(true);
+    Screen& screen = vt.screen();
+    screen.reset(true);
+    vt.scrollback().set_capacity(10'000);
+
+    bench_measure(_bench, "scroll", 500 * sb_cols * sizeof(ScreenCell), [&] {
+        (void)vt.write("\x1b#8\x1b[500S");
+    });
+}
+
+// Width changes with 100k lines of scrollback, each followed by reading the 50
+// rows of a view scrolled halfway back
+BENCH(scrollback_reflow_100k)
+{
+    constexpr size_t nlines = 100'000;
+    Terminal vt(50, 120);
+    vt.set_utf8(true);
+    Screen& screen = vt.screen();
+    screen.enable_reflow(true);
+    screen.enable_direct_scrollback(true);
+    screen.reset(true);
+    Scrollback& sb = vt.scrollback();
+    sb.set_capacity(nlines);
+    const std::string log = corpus_build_log(64 * 1024);
+    while(sb.size() < nlines)
+        (void)vt.write(log);
+
+    std::vector<ScreenCell> cells(120);
+    auto read_view = [&] {
+        for(size_t i = 0; i < 50; i++) {
+            bool continuation = false;
+            bench_keep(sb.read_line(sb.size() / 2 + i, cells, continuation));
+        }
+    };
+    bench_measure(_bench, "resize + view", 0, [&] {
+        vt.set_size(50, 100);
+        read_view();
+        vt.set_size(50, 120);
+        read_view();
+    });
+    bench_report(_bench, "lines", std::format("{}", sb.size()));
+}
+
+// Width changes with 100k lines of wide-character scrollback, each followed
+// by reading a view scrolled halfway back. With background reflow the view is
+// read at the old width while the worker runs; "to done" also waits for it.
+BENCH(scrollback_reflow_wide_100k)
+{
+    constexpr size_t nlines = 100'000;
+    std::string text;
+    for(int i = 0; i < 200; i++) {
+        for(int j = 0; j < 20 + i % 40; j++)
+            text += "\xe6\x97\xa5\xe6\x9c\xac";
+        text += "\r\n";
+    }
+
+    for(int mode = 0; mode < 3; mode++) {
+        Terminal vt(50, 120);
+        vt.set_utf8(true);
+        Screen& screen = vt.screen();
+        screen.enable_reflow(true);
+        screen.enable_direct_scrollback(true);
+        screen.reset(true);
+        Scrollback& sb = vt.scrollback();
+        sb.set_capacity(nlines);
+        while(sb.size() < nlines)
+            (void)vt.write(text);
+        sb.enable_background_reflow(mode > 0);
+
+        std::vector<ScreenCell> cells(120);
+        auto resize = [&](int32_t cols) {
+            vt.set_size(50, cols);
+            for(size_t i = 0; i < 50; i++) {
+                bool continuation = false;
+                bench_keep(sb.read_line(sb.size() / 2 + i, cells, continuation));
+            }
+            if(mode == 2)
+                sb.wait_reflow();
+        };
+        const char* label = mode == 0 ? "sync" : mode == 1 ? "background" : "background, to done";
+        bench_measure(_bench, label, 0, [&] {
+            resize(100);
+            resize(120);
+        });
+        sb.wait_reflow();
+    }
+}
+
+// An interactive window drag: 60 set_size calls per sweep, each sweep from
+// one end of the drag to the other and back. Deferred mode commits once at
+// the end of each sweep.
+BENCH(scrollback_resize_drag)
+{
+    constexpr size_t nlines = 10'000;
+    constexpr int32_t steps = 60;
+    const std::string log = corpus_build_log(64 * 1024);
+
+    for(bool deferred : {false, true}) {
+        Terminal vt(50, 120);
+        vt.set_utf8(true);
+        Screen& screen = vt.screen();
+        screen.enable_reflow(true);
+        screen.enable_direct_scrollback(true);
+        screen.reset(true);
+        Scrollback& sb = vt.scrollback();
+        sb.set_capacity(nlines);
+        while(sb.size() < nlines)
+            (void)vt.write(log);
+        vt.enable_deferred_resize(deferred);
+
+        auto sweep = [&](int32_t from, int32_t to) {
+            for(int32_t i = 1; i <= steps; i++) {
+                int32_t t = from + (to - from) * i / steps;
+                vt.set_size(30 + t / 6, t);
+            }
+            vt.commit_resize();
+        };
+        bench_measure(_bench, deferred ? "deferred" : "immediate", 0, [&] {
+            sweep(120, 80);
+            sweep(80, 120);
+        });
+    }
+}
+
+// A split pane growing and shrinking by 3 rows at a fixed width, over a
+// full screen of wrapped text with scrollback to pop from
+BENCH(screen_resize_rows)
+{
+    Terminal vt(50, 200);
+    vt.set_utf8(true);
+    Screen& screen = vt.screen();
+    screen.enable_reflow(true);
+    screen.reset(true);
+    Scrollback& sb = vt.scrollback();
+    sb.set_capacity(1000);
+    (void)vt.write(corpus_build_log(256 * 1024));
+
+    bench_measure(_bench, "+3 / -3 rows", 0, [&] {
+        vt.set_size(53, 200);
+        vt.set_size(50, 200);
+    });
+    bench_report(_bench, "screen", "50x200");
+}
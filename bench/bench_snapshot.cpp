@@ -0,0 +1,71 @@
+// bench_snapshot.cpp — cost of handing frames to a render thread
+
+#include "bench.h"
+#include "corpus.h"
+
+#include "vterm/vterm.h"
+
+#include <vector>
+
+using namespace vterm;
+
+namespace {
+
+constexpr size_t corpus_size = 4 * 1024 * 1024;
+constexpr size_t frame_bytes = 4 * 1024;
+
+// Writes `input` a frame at a time, calling `frame` after each
+template<typename Frame>
+void write_frames(Terminal& vt, std::string_view input, Frame&& frame)
+{
+    for(size_t pos = 0; pos < input.size(); pos += frame_bytes) {
+        (void)vt.write(input.substr(pos, frame_bytes));
+        frame();
+    }
+}
+
+void bench_frames(BenchState& state, const std::string& input)
+{
+    Terminal vt(60, 240);
+    vt.set_utf8(true);
+    Screen& screen = vt.screen();
+    screen.reset(true);
+
+    bench_measure(state, "no render", input.size(), [&] {
+        write_frames(vt, input, [] {});
+    });
+
+    // What a render thread needs today: a full copy taken under the lock
+    std::vector<ScreenCell> copy(static_cast<size_t>(60 * 240));
+    bench_measure(state, "full copy per frame", input.size(), [&] {
+        write_frames(vt, input, [&] {
+            for(int32_t row = 0; row < 60; row++)
+                for(int32_t col = 0; col < 240; col++)
+                    (void)screen.get_cell({.row = row, .col = col}, copy[row * 240 + col]);
+        });
+        bench_keep(copy[0]);
+    });
+
+    // The renderer still holds the previous frame while the next is taken
+    ScreenSnapshot drawing;
+    bench_measure(state, "snapshot per frame", input.size(), [&] {
+        write_frames(vt, input, [&] {
+            drawing = screen.snapshot();
+        });
+        bench_keep(drawing);
+    });
+}
+
+} // anonymous namespace
+
+// Scrolling output: every row changes between frames
+BENCH(snapshot_log_output)
+{
+    bench_frames(_bench, corpus_build_log(corpus_size));
+}
+
+// Full-screen TUI: redrawn in place, a few rows per frame
+BENCH(snapshot_tui_output)
+{
+    bench_frames(_bench, corpus_build_tui(corpus_size, 60, 240));
+}
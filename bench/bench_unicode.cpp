@@ -0,0 +1,84 @@
+// bench_unicode.cpp — codepoint width / combining lookup benchmarks
+
+#include "bench.h"
+#include "corpus.h"
+
+#include "internal.h"
+
+#include <vector>
+
+using namespace vterm;
+
+namespace {
+
+constexpr size_t corpus_codepoints = 1024 * 1024;
+
+// Random codepoints drawn from the given ranges, with ASCII spaces mixed in
+std::vector<uint32_t> codepoint_corpus(std::span<const UnicodeInterval> ranges, int32_t space_every)
+{
+    CorpusRng rng;
+    std::vector<uint32_t> out;
+    out.reserve(corpus_codepoints);
+    while(out.size() < corpus_codepoints) {
+        if(rng.below(space_every) == 0) {
+            out.push_back(' ');
+            continue;
+        }
+        const UnicodeInterval& range = ranges[rng.below(static_cast<uint32_t>(ranges.size()))];
+        out.push_back(range.first + rng.below(range.last - range.first + 1));
+    }
+    return out;
+}
+
+// Han, Hiragana, Katakana and Hangul syllables
+constexpr auto cjk_ranges = std::to_array<UnicodeInterval>({
+    { 0x4E00, 0x9FFF }, { 0x3041, 0x3096 }, { 0x30A1, 0x30FA }, { 0xAC00, 0xD7A3 },
+});
+
+// Emoji blocks, with VS16 and ZWJ as the common combining companions
+constexpr auto emoji_ranges = std::to_array<UnicodeInterval>({
+    { 0x1F300, 0x1F5FF }, { 0x1F600, 0x1F64F }, { 0x1F680, 0x1F6FF }, { 0x1F900, 0x1F9FF },
+    { 0x2600, 0x26FF }, { 0xFE0F, 0xFE0F }, { 0x200D, 0x200D },
+});
+
+// Latin letters plus combining diacritics
+constexpr auto latin_ranges = std::to_array<UnicodeInterval>({
+    { 0x41, 0x5A }, { 0x61, 0x7A }, { 0xC0, 0x17F }, { 0x1E00, 0x1EFF },
+    { 0x300, 0x36F },
+});
+
+void measure_lookups(BenchState& state, std::span<const uint32_t> input)
+{
+    size_t bytes = input.size() * sizeof(uint32_t);
+
+    bench_measure(state, "table", bytes, [&] {
+        int32_t sum = 0;
+        for(uint32_t c : input)
+            sum += unicode_width(c) + unicode_is_combining(c);
+        bench_keep(sum);
+    });
+
+    bench_measure(state, "bisearch", bytes, [&] {
+        int32_t sum = 0;
+        for(uint32_t c : input)
+            sum += unicode_interval_width(c) + unicode_interval_is_combining(c);
+        bench_keep(sum);
+    });
+}
+
+} // anonymous namespace
+
+BENCH(unicode_width_cjk)
+{
+    measure_lookups(_bench, codepoint_corpus(cjk_ranges, 8));
+}
+
+BENCH(unicode_width_emoji)
+{
+    measure_lookups(_bench, codepoint_corpus(emoji_ranges, 4));
+}
+
+BENCH(unicode_width_latin_diacritics)
+{
+    measure_lookups(_bench, codepoint_corpus(latin_ranges, 6));
+}
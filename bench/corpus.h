@@ -0,0 +1,174 @@
+/*
+ * corpus.h — deterministic synthetic input streams for libvtermcpp benchmarks
+ *
+ * Every generator is seeded, so the same corpus is produced on every run and
+ * results are comparable between builds.
+ */
+
+#ifndef CORPUS_H
+#define CORPUS_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Small linear congruential generator — quality is irrelevant, determinism is not
+struct CorpusRng {
+    uint64_t state = 0x2545F4914F6CDD1DULL;
+
+    uint32_t next() {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        return static_cast<uint32_t>(state >> 33);
+    }
+    uint32_t below(uint32_t n) { return next() % n; }
+};
+
+// Compiler-style build log: long lines of printable ASCII separated by CRLF
+inline std::string corpus_build_log(size_t target_bytes)
+{
+    static constexpr std::string_view words[] = {
+        "g++", "-O2", "-std=c++20", "-Wall", "-Wextra", "-c", "src/parser.cpp", "-o",
+        "CMakeFiles/vtermcpp.dir/src/parser.cpp.o", "[ 42%]", "Building", "CXX", "object",
+        "warning:", "unused", "variable", "'pos'", "[-Wunused-variable]", "note:", "in",
+        "instantiation", "of", "template", "Linking", "static", "library", "libvtermcpp.a",
+    };
+
+    CorpusRng rng;
+    std::string out;
+    out.reserve(target_bytes + 256);
+    while(out.size() < target_bytes) {
+        int32_t nwords = 4 + static_cast<int32_t>(rng.below(20));
+        for(int32_t i = 0; i < nwords; i++) {
+            if(i) out += ' ';
+            out += words[rng.below(std::size(words))];
+        }
+        out += "\r\n";
+    }
+    return out;
+}
+
+// Full-screen TUI redraws (htop, tmux status line, ncurses): short runs of
+// text between cursor positioning, SGR colour changes and line erases
+inline std::string corpus_build_tui(size_t target_bytes, int32_t rows = 50, int32_t cols = 200)
+{
+    static constexpr std::string_view labels[] = {
+        "CPU", "Mem", "Swp", "PID", "USER", "PRI", "NI", "VIRT", "RES", "S", "%CPU",
+        "bash", "vim", "0:00.42", "R", "S", "||||||||", "[", "]", "1.5G/15.6G", " ",
+    };
+
+    CorpusRng rng;
+    std::string out;
+    out.reserve(target_bytes + 256);
+    while(out.size() < target_bytes) {
+        out += "\x1b[?25l";
+        for(int32_t row = 1; row <= rows && out.size() < target_bytes; row++) {
+            out += "\x1b[" + std::to_string(row) + ";1H";
+            int32_t col = 0;
+            while(col < cols - 12) {
+                switch(rng.below(4)) {
+                case 0: out += "\x1b[38;5;" + std::to_string(rng.below(256)) + "m"; break;
+                case 1: out += "\x1b[1;3" + std::to_string(rng.below(8)) + ";4" + std::to_string(rng.below(8)) + "m"; break;
+                case 2: out += "\x1b[0m"; break;
+                default: out += "\x1b[" + std::to_string(row) + ";" + std::to_string(col + 1) + "H"; break;
+                }
+                std::string_view label = labels[rng.below(std::size(labels))];
+                out += label;
+                col += static_cast<int32_t>(label.size());
+            }
+            out += "\x1b[K";
+        }
+        // tmux-style status line and window title
+        out += "\x1b[" + std::to_string(rows) + ";1H\x1b[30;42m[0] 0:bash* 1:vim-\x1b[K\x1b[0m";
+        out += "\x1b]2;htop\x07\x1b[?25h";
+    }
+    return out;
+}
+
+// Colourised listings as produced by `ls --color`, `bat` and `delta`, shown a
+// page at a time as a pager would (cursor home rather than scrolling)
+inline std::string corpus_build_colorized(size_t target_bytes, int32_t rows = 50)
+{
+    static constexpr std::string_view names[] = {
+        "src", "include", "parser.cpp", "screen.cpp", "README.md", "build.sh",
+        "CMakeLists.txt", "libvtermcpp.a", "test", "golden", ".gitignore",
+    };
+    static constexpr std::string_view code[] = {
+        "if", "(", "pos", "<", "data.size", "())", "{", "return", "nullptr", ";",
+        "static_cast<uint8_t>", "for", "auto&", "cell", ":", "row", "}", "//", "TODO",
+    };
+    static constexpr std::string_view ls_colors[] = {
+        "\x1b[01;34m", "\x1b[01;32m", "\x1b[00m", "\x1b[01;31m", "\x1b[01;36m", "\x1b[00;33m",
+    };
+
+    CorpusRng rng;
+    std::string out;
+    out.reserve(target_bytes + 256);
+    auto truecolor = [&](int32_t sgr) {
+        out += "\x1b[" + std::to_string(sgr) + ";2;" + std::to_string(rng.below(256)) + ";"
+             + std::to_string(rng.below(256)) + ";" + std::to_string(rng.below(256)) + "m";
+    };
+
+    while(out.size() < target_bytes) {
+        out += "\x1b[H";
+        for(int32_t row = 0; row < rows - 1; row++) {
+            switch(rng.below(3)) {
+            case 0: // ls --color
+                for(int32_t i = 0; i < 6; i++) {
+                    out += ls_colors[rng.below(std::size(ls_colors))];
+                    out += names[rng.below(std::size(names))];
+                    out += "\x1b[0m  ";
+                }
+                break;
+            case 1: // bat: truecolor foreground per token, line number gutter
+                out += "\x1b[38;2;98;114;164m" + std::to_string(row + 1) + "\x1b[0m \x1b[38;2;68;71;90m\u2502\x1b[0m ";
+                for(int32_t i = 0; i < 10; i++) {
+                    truecolor(38);
+                    out += code[rng.below(std::size(code))];
+                    out += ' ';
+                }
+                out += "\x1b[0m";
+                break;
+            default: // delta: reset, bold, foreground and background in one SGR
+                out += "\x1b[0;1;38;2;" + std::to_string(rng.below(256)) + ";80;80;48;2;63;0;1m-";
+                for(int32_t i = 0; i < 8; i++) {
+                    truecolor(i & 1 ? 48 : 38);
+                    out += code[rng.below(std::size(code))];
+                }
+                out += "\x1b[0m\x1b[K";
+                break;
+            }
+            out += "\r\n";
+        }
+    }
+    return out;
+}
+
+// Build log from a localised toolchain: ASCII paths and flags mixed with CJK
+// messages, accented Latin and the odd emoji (2, 3 and 4 byte UTF-8)
+inline std::string corpus_build_mixed_cjk(size_t target_bytes, int32_t rows = 50)
+{
+    static constexpr std::string_view words[] = {
+        "g++", "-O2", "src/parser.cpp", "[ 42%]", "warning:", "'pos'", "[-Wunused-variable]",
+        "\u8b66\u544a", "\u672a\u4f7f\u7528\u306e\u5909\u6570", "\u30d3\u30eb\u30c9\u4e2d",
+        "\u7f16\u8bd1\u5b8c\u6210", "\uc624\ub958", "\u9519\u8bef\uff1a", "d\u00e9j\u00e0",
+        "\u00fcbersetzt", "\u2705", "\U0001f680",
+    };
+
+    CorpusRng rng;
+    std::string out;
+    out.reserve(target_bytes + 256);
+    int32_t line = 0;
+    while(out.size() < target_bytes) {
+        if(line++ % (rows - 1) == 0)
+            out += "\x1b[H";
+        int32_t nwords = 4 + static_cast<int32_t>(rng.below(12));
+        for(int32_t i = 0; i < nwords; i++) {
+            if(i) out += ' ';
+            out += words[rng.below(std::size(words))];
+        }
+        out += "\r\n";
+    }
+    return out;
+}
+
+#endif // CORPUS_H
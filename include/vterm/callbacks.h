@@ -25,12 +25,14 @@ struct ParserCallbacks {
 struct StateCallbacks {
     virtual ~StateCallbacks() = default;
     virtual bool on_putglyph(const GlyphInfo& info, Pos pos) { return false; }
+    virtual bool on_putglyphs(std::span<const uint32_t> chars, Pos pos) { return false; }
     virtual bool on_movecursor(Pos pos, Pos oldpos, bool visible) { return false; }
     virtual bool on_scrollrect(Rect rect, int32_t downward, int32_t rightward) { return false; }
     virtual bool on_moverect(Rect dest, Rect src) { return false; }
     virtual bool on_erase(Rect rect, bool selective) { return false; }
     virtual bool on_initpen() { return false; }
     virtual bool on_setpenattr(Attr attr, const Value& val) { return false; }
+    virtual bool on_setpen(const Pen& pen, AttrMask changed) { return false; }
     virtual bool on_settermprop(Prop prop, const Value& val) { return false; }
     virtual bool on_bell() { return false; }
     virtual bool on_resize(int32_t rows, int32_t cols, StateFields& fields) { return false; }
@@ -53,16 +55,26 @@ struct StateFallbacks {
 struct ScreenCallbacks {
     virtual ~ScreenCallbacks() = default;
     virtual bool on_damage(Rect rect) { return false; }
+    // DamageSize::Region flush; return false to get each rect via on_damage
+    virtual bool on_damage_batch(std::span<const Rect> rects) { return false; }
     virtual bool on_moverect(Rect dest, Rect src) { return false; }
     virtual bool on_movecursor(Pos pos, Pos oldpos, bool visible) { return false; }
     virtual bool on_settermprop(Prop prop, const Value& val) { return false; }
     virtual bool on_bell() { return false; }
     virtual bool on_resize(int32_t rows, int32_t cols) { return false; }
     virtual bool on_sb_pushline(std::span<const ScreenCell> cells, bool continuation) { return false; }
+    // Rows scrolled off together; return false to get each via on_sb_pushline
+    virtual bool on_sb_pushlines(std::span<const PushedLine> lines) { return false; }
     virtual bool on_sb_popline(std::span<ScreenCell> cells, bool& continuation) { return false; }
     virtual bool on_sb_clear() { return false; }
 };
 
+// Receives Screen::get_row_runs() output left to right; return false to stop
+struct RunSink {
+    virtual ~RunSink() = default;
+    virtual bool on_run(const ScreenRun& run) = 0;
+};
+
 struct SelectionCallbacks {
     virtual ~SelectionCallbacks() = default;
     virtual bool on_set(SelectionMask mask, StringFragment frag) { return false; }
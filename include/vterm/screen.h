@@ -4,30 +4,89 @@
 #include "types.h"
 #include "callbacks.h"
 
+#include <chrono>
+#include <memory>
 #include <span>
 
 namespace vterm {
 
 class Terminal;
 
+// Immutable copy of the visible screen, taken by Screen::snapshot(). Copies
+// share one refcounted image and may be read from any thread while the
+// terminal keeps writing. A default-constructed snapshot is empty.
+class ScreenSnapshot {
+public:
+    [[nodiscard]] bool empty() const { return !impl_; }
+    [[nodiscard]] int32_t rows() const;
+    [[nodiscard]] int32_t cols() const;
+
+    [[nodiscard]] bool get_cell(Pos pos, ScreenCell& cell) const;
+    [[nodiscard]] std::span<const ScreenCell> get_row(int32_t row) const;
+    [[nodiscard]] LineInfo get_lineinfo(int32_t row) const;
+
+    [[nodiscard]] Pos cursor_pos() const;
+    [[nodiscard]] bool cursor_visible() const;
+    [[nodiscard]] bool cursor_blink() const;
+    [[nodiscard]] CursorShape cursor_shape() const;
+
+    // Resolves against the palette as it was when the snapshot was taken
+    void convert_color_to_rgb(Color& col) const;
+
+    struct Impl;
+
+private:
+    friend class Screen;
+    std::shared_ptr<const Impl> impl_;
+};
+
 class Screen {
 public:
+    struct DirtyRows {
+        size_t count = 0;         // rows changed; only the first rows.size() are written
+        uint64_t generation = 0;  // pass as since_generation on the next call
+    };
+
     void set_callbacks(ScreenCallbacks& cb);
     void clear_callbacks();
     void set_fallbacks(StateFallbacks& fb);
     void clear_fallbacks();
     void enable_altscreen(bool enabled);
     void enable_reflow(bool enabled);
+    // Lets write() build lines of plain text that will have scrolled off the
+    // screen by the time it returns straight into scrollback. Such a write
+    // reports one damage rect for the screen in place of its scrolls.
+    void enable_direct_scrollback(bool enabled);
     void set_damage_merge(DamageSize size);
     void flush_damage();
+
+    // While an application holds DEC mode 2026 (synchronized output), screen
+    // callbacks are held as by Terminal::begin_batch(). A frame that runs past
+    // `max_bytes` or `timeout` is released early; 0 means no limit.
+    void set_sync_output_budget(size_t max_bytes, std::chrono::milliseconds timeout);
     void reset(bool hard);
 
     [[nodiscard]] bool get_cell(Pos pos, ScreenCell& cell) const;
+    [[nodiscard]] bool get_cell_glyph(Pos pos, uint32_t& glyph) const;
+    // Codepoints of a glyph_cluster_flag glyph; valid until the next write()
+    [[nodiscard]] std::span<const uint32_t> get_cluster(uint32_t glyph) const;
     [[nodiscard]] size_t get_chars(std::span<uint32_t> chars, Rect rect) const;
     [[nodiscard]] size_t get_text(std::span<char> str, Rect rect) const;
     [[nodiscard]] bool get_attrs_extent(Rect& extent, Pos pos, AttrMask attrs) const;
     [[nodiscard]] bool is_eol(Pos pos) const;
 
+    // Delivers `row` as runs of cells with equal attributes and colours, in
+    // one pass; false if the row is out of range
+    [[nodiscard]] bool get_row_runs(int32_t row, RunSink& sink);
+
+    // Rows changed after `since_generation` (0 = all), in ascending order.
+    // For renderers that poll instead of handling on_damage; does not allocate.
+    [[nodiscard]] DirtyRows collect_dirty_rows(uint64_t since_generation, std::span<int32_t> rows);
+
+    // Copies rows changed since the previous snapshot; unchanged rows are
+    // shared with it
+    [[nodiscard]] ScreenSnapshot snapshot();
+
     void convert_color_to_rgb(Color& col) const;
     void set_default_colors(const Color& fg, const Color& bg);
 
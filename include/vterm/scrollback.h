@@ -2,6 +2,7 @@
 #define VTERM_SCROLLBACK_H
 
 #include "types.h"
+#include <span>
 #include <vector>
 
 namespace vterm {
@@ -21,11 +22,23 @@ public:
     [[nodiscard]] size_t size() const;
     [[nodiscard]] bool empty() const;
 
-    // Line access (0 = oldest, size()-1 = newest)
-    [[nodiscard]] const Line& line(size_t index) const;
+    // Line access (0 = oldest, size()-1 = newest). Lines are stored packed
+    // and decoded on access.
+    [[nodiscard]] Line line(size_t index) const;
+    // Decodes a line into `cells` without allocating, padding with blanks;
+    // returns the line's width
+    size_t read_line(size_t index, std::span<ScreenCell> cells, bool& continuation) const;
 
     void clear();
 
+    // Wrap the stored lines for a width change on a worker thread. Until it is
+    // done, line() and read_line() show them as before the change; the result
+    // is shown from the next size(), reflow_pending() or Terminal::write().
+    void enable_background_reflow(bool enabled);
+    [[nodiscard]] bool reflow_pending() const;
+    // Blocks until a pending reflow is done and shown
+    void wait_reflow();
+
     struct Impl;
 
 private:
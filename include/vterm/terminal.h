@@ -27,11 +27,27 @@ public:
     [[nodiscard]] int32_t cols() const;
     void set_size(int32_t rows, int32_t cols);
 
+    // Deferred resize: set_size() only records the target, and the resize
+    // runs once from the last committed geometry at the next write() or
+    // commit_resize(). rows()/cols() report the committed size. Disabling
+    // commits any pending size.
+    void enable_deferred_resize(bool enabled);
+    void commit_resize();
+
     [[nodiscard]] bool utf8() const;
     void set_utf8(bool enabled);
 
+    [[nodiscard]] ParserEngine parser_engine() const;
+    void set_parser_engine(ParserEngine engine);
+
     [[nodiscard]] size_t write(std::span<const char> data);
 
+    // Hold screen damage, scrolls, cursor moves and termprops until the
+    // matching end_batch(), then deliver them once. Scrolls collapse into a
+    // net shift. Batches nest.
+    void begin_batch();
+    void end_batch();
+
     void set_output_callback(std::function<void(std::span<const char>)> cb);
 
     void keyboard_unichar(uint32_t c, Modifier mod);
@@ -25,6 +25,12 @@ inline constexpr int32_t version_patch = 3;
 
 inline constexpr int32_t max_chars_per_cell = 6;
 
+// Raw cell glyphs, as returned by Screen::get_cell_glyph(): a codepoint, 0
+// for an erased cell, glyph_continuation for the right half of a wide glyph,
+// or glyph_cluster_flag | id for a multi-codepoint glyph
+inline constexpr uint32_t glyph_cluster_flag = 0x80000000;
+inline constexpr uint32_t glyph_continuation = 0xFFFFFFFF;
+
 // --- Modifier / Key enums ---
 
 enum class Modifier : uint8_t {
@@ -257,6 +263,7 @@ enum class Prop {
     CursorShape,
     Mouse,
     FocusReport,
+    SyncOutput,
 
     NProps,
 };
@@ -348,6 +355,49 @@ struct ScreenCell {
     Color     fg{}, bg{};
 };
 
+// Columns of one row sharing attributes and colours. `text` is UTF-8 with a
+// space per erased cell and nothing for the right half of a wide char; it is
+// only valid during the RunSink call.
+struct ScreenRun {
+    int32_t   start_col = 0;
+    int32_t   cols = 0;
+    CellAttrs attrs{};
+    Color     fg{}, bg{};
+    std::string_view text;
+};
+
+// One row scrolled off the top of the screen, oldest first in a block. The
+// cells are only valid during the on_sb_pushlines call.
+struct PushedLine {
+    std::span<const ScreenCell> cells;
+    bool continuation = false;
+};
+
+// --- Pen ---
+
+// Drawing attributes applied to newly written cells, as set by SGR
+struct Pen {
+    Color fg{};
+    Color bg{};
+    uint32_t bold      : 1 = 0;
+    Underline underline : 2 = Underline::Off;
+    uint32_t italic    : 1 = 0;
+    uint32_t blink     : 1 = 0;
+    uint32_t reverse   : 1 = 0;
+    uint32_t conceal   : 1 = 0;
+    uint32_t strike    : 1 = 0;
+    uint32_t font      : 4 = 0;
+    uint32_t small     : 1 = 0;
+    Baseline baseline   : 2 = Baseline::Normal;
+};
+
+// --- Parser engine ---
+
+enum class ParserEngine : uint8_t {
+    Switch, // hand-written state machine
+    Table,  // table-driven DFA
+};
+
 // --- Damage ---
 
 enum class DamageSize {
@@ -355,6 +405,7 @@ enum class DamageSize {
     Row,
     Screen,
     Scroll,
+    Region,  // up to 16 disjoint rects, delivered by flush_damage()
 
     NDamages,
 };
@@ -384,6 +435,9 @@ constexpr AttrMask operator|(AttrMask a, AttrMask b) noexcept {
 constexpr AttrMask operator&(AttrMask a, AttrMask b) noexcept {
     return static_cast<AttrMask>(to_underlying(a) & to_underlying(b));
 }
+constexpr AttrMask& operator|=(AttrMask& a, AttrMask b) noexcept {
+    return a = a | b;
+}
 constexpr bool operator!(AttrMask m) noexcept { return to_underlying(m) == 0; }
 
 // --- CSI arg helpers ---
@@ -436,6 +490,7 @@ inline constexpr std::array<ValueType, static_cast<size_t>(Prop::NProps)> prop_t
     ValueType::Int,    // CursorShape
     ValueType::Int,    // Mouse
     ValueType::Bool,   // FocusReport
+    ValueType::Bool,   // SyncOutput
 }};
 
 static_assert(prop_type_table.size() == static_cast<size_t>(Prop::NProps),
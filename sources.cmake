@@ -2,6 +2,7 @@ set(LIBVTERMCPP_SOURCES
     terminal.cpp
     parser.cpp
     encoding.cpp
+    unicode.cpp
     pen.cpp
     state.cpp
     screen.cpp
@@ -1,4 +1,5 @@
 #include "internal.h"
+#include "simd.h"
 #include "utf8.h"
 
 namespace vterm {
@@ -27,6 +28,43 @@ constexpr uint8_t decode_invalid_start      = 0xfe;
 constexpr int32_t surrogate_start = 0xD800;
 constexpr int32_t surrogate_end   = 0xDFFF;
 
+// Replace overlong encodings, surrogates and the U+FFFE/U+FFFF
+// noncharacters in a fully decoded sequence of `len` bytes
+[[nodiscard]] constexpr int32_t checked_codepoint(int32_t cp, int32_t len) {
+    switch(len) {
+    case 2: if(cp < utf8_max_1byte)  return unicode_invalid; break;
+    case 3: if(cp < utf8_max_2byte)  return unicode_invalid; break;
+    case 4: if(cp < utf8_max_3byte)  return unicode_invalid; break;
+    case 5: if(cp < utf8_max_4byte)  return unicode_invalid; break;
+    case 6: if(cp < utf8_max_5byte)  return unicode_invalid; break;
+    }
+    if((cp >= surrogate_start && cp <= surrogate_end) ||
+       cp == unicode_nonchar_fffe || cp == unicode_nonchar_ffff)
+        return unicode_invalid;
+    return cp;
+}
+
+// Decode a complete, well-formed 2-4 byte sequence at the start of `bytes`.
+// Returns its length, or 0 if it is truncated or a continuation byte is
+// missing; the byte-at-a-time path then handles it.
+[[nodiscard]] inline int32_t decode_sequence(std::span<const char> bytes, uint32_t& codepoint) {
+    uint8_t lead = static_cast<uint8_t>(bytes[0]);
+    int32_t len = lead < decode_3byte_start ? 2 : lead < decode_4byte_start ? 3 : 4;
+    if(bytes.size() < static_cast<size_t>(len))
+        return 0;
+
+    int32_t cp = lead & utf8_lead_mask[len];
+    for(int32_t i = 1; i < len; i++) {
+        uint8_t c = static_cast<uint8_t>(bytes[i]);
+        if(c < decode_continuation_start || c >= decode_continuation_end)
+            return 0;
+        cp = (cp << 6) | (c & utf8_continuation_mask);
+    }
+
+    codepoint = checked_codepoint(cp, len);
+    return len;
+}
+
 // --- UTF-8 encoding ---
 
 struct UTF8Encoding : EncodingInstance {
@@ -39,6 +77,8 @@ struct UTF8Encoding : EncodingInstance {
         bytes_total     = 0;
     }
 
+    [[nodiscard]] bool ascii_identity() const override { return bytes_remaining == 0; }
+
     DecodeResult decode(std::span<uint32_t> output, std::span<const char> input) override
     {
         size_t ipos = 0;
@@ -48,6 +88,24 @@ struct UTF8Encoding : EncodingInstance {
         for(; ipos < input.size() && opos < cplen; ipos++) {
             uint8_t c = input[ipos];
 
+            // Fast paths between sequences: printable ASCII runs, then whole
+            // multibyte sequences
+            if(bytes_remaining == 0) {
+                if(c >= decode_c0_end && c < decode_ascii_end) {
+                    size_t n = widen_printable_ascii(input.subspan(ipos), output.subspan(opos));
+                    ipos += n - 1;
+                    opos += static_cast<int32_t>(n);
+                    continue;
+                }
+                if(c >= decode_2byte_start && c < decode_5byte_start) {
+                    if(int32_t len = decode_sequence(input.subspan(ipos), output[opos])) {
+                        ipos += len - 1;
+                        opos++;
+                        continue;
+                    }
+                }
+            }
+
             if(c < decode_c0_end) { // C0
                 if(bytes_remaining != 0) {
                     output[opos++] = unicode_invalid;
@@ -85,19 +143,8 @@ struct UTF8Encoding : EncodingInstance {
                 this_cp |= c & utf8_continuation_mask;
                 bytes_remaining--;
 
-                if(bytes_remaining == 0) {
-                    switch(bytes_total) {
-                    case 2: if(this_cp < utf8_max_1byte)  this_cp = unicode_invalid; break;
-                    case 3: if(this_cp < utf8_max_2byte)  this_cp = unicode_invalid; break;
-                    case 4: if(this_cp < utf8_max_3byte)  this_cp = unicode_invalid; break;
-                    case 5: if(this_cp < utf8_max_4byte)  this_cp = unicode_invalid; break;
-                    case 6: if(this_cp < utf8_max_5byte)  this_cp = unicode_invalid; break;
-                    }
-                    if((this_cp >= surrogate_start && this_cp <= surrogate_end) ||
-                       this_cp == unicode_nonchar_fffe || this_cp == unicode_nonchar_ffff)
-                        this_cp = unicode_invalid;
-                    output[opos++] = this_cp;
-                }
+                if(bytes_remaining == 0)
+                    output[opos++] = checked_codepoint(this_cp, bytes_total);
             }
 
             else if(c >= decode_2byte_start && c < decode_3byte_start) {
@@ -149,7 +196,12 @@ struct UTF8Encoding : EncodingInstance {
 struct TableEncoding : EncodingInstance {
     std::span<const uint32_t> chars;
 
-    explicit TableEncoding(std::span<const uint32_t> table) : chars(table) {}
+    bool identity;
+
+    explicit TableEncoding(std::span<const uint32_t> table)
+        : chars(table), identity(std::ranges::all_of(table, [](uint32_t c) { return c == 0; })) {}
+
+    [[nodiscard]] bool ascii_identity() const override { return identity; }
 
     DecodeResult decode(std::span<uint32_t> output, std::span<const char> input) override
     {
@@ -99,27 +99,12 @@ struct EncodingInstance {
     EncodingInstance() = default;
     virtual void init() {}
     virtual DecodeResult decode(std::span<uint32_t> output, std::span<const char> input) = 0;
+    // True while printable ASCII decodes to itself, one byte per codepoint
+    [[nodiscard]] virtual bool ascii_identity() const { return false; }
 };
 
 [[nodiscard]] std::unique_ptr<EncodingInstance> create_encoding(EncodingType type, char designation);
 
-// --- Pen (internal) ---
-
-struct Pen {
-    Color fg{};
-    Color bg{};
-    uint32_t bold      : 1 = 0;
-    Underline underline : 2 = Underline::Off;
-    uint32_t italic    : 1 = 0;
-    uint32_t blink     : 1 = 0;
-    uint32_t reverse   : 1 = 0;
-    uint32_t conceal   : 1 = 0;
-    uint32_t strike    : 1 = 0;
-    uint32_t font      : 4 = 0;
-    uint32_t small     : 1 = 0;
-    Baseline baseline   : 2 = Baseline::Normal;
-};
-
 // --- C0 control codes ---
 
 inline constexpr uint8_t ctrl_nul = 0x00;
@@ -281,6 +266,7 @@ struct State::Impl {
         uint32_t leftrightmargin: 1 = 0;
         uint32_t bracketpaste  : 1 = 0;
         uint32_t report_focus  : 1 = 0;
+        uint32_t sync_output   : 1 = 0;
     } mode{};
 
     std::array<std::unique_ptr<EncodingInstance>, 4> encoding;
@@ -288,6 +274,7 @@ struct State::Impl {
     int32_t gl_set = 0, gr_set = 0, gsingle_set = 0;
 
     Pen pen = {};
+    AttrMask pen_changed{}; // attributes touched since the last flush_pen()
 
     Color default_fg{};
     Color default_bg{};
@@ -341,14 +328,14 @@ struct State::Impl {
     [[nodiscard]] bool lookup_colour_ansi(int64_t index, Color& col) const;
     [[nodiscard]] bool lookup_colour_palette(int64_t index, Color& col) const;
     [[nodiscard]] int32_t lookup_colour(int32_t palette, std::span<const int64_t> args, Color& col) const;
-    void setpenattr(Attr attr, ValueType type, const Value& val);
-    void setpenattr_bool(Attr attr, bool boolean);
-    void setpenattr_int(Attr attr, int32_t number);
-    void setpenattr_col(Attr attr, Color color);
+    [[nodiscard]] bool get_penattr(Attr attr, Value& val) const;
+    void flush_pen();
+    void reset_pen_fields();
     void set_pen_col_ansi(Attr attr, int64_t col);
 
     // State callbacks (defined in state.cpp)
     void putglyph(std::span<const uint32_t> chars, int32_t width, Pos pos);
+    void putglyphs(std::span<const uint32_t> chars, Pos pos);
     void updatecursor(const Pos& oldpos, bool cancel_phantom);
     void erase(Rect rect, bool selective);
     void scroll(Rect rect, int32_t downward, int32_t rightward);
@@ -400,6 +387,11 @@ struct Terminal::Impl {
     int32_t rows = 0;
     int32_t cols = 0;
 
+    // Deferred resize target; 0 when nothing is pending
+    bool defer_resize = false;
+    int32_t pending_rows = 0;
+    int32_t pending_cols = 0;
+
     struct {
         uint32_t utf8     : 1 = 0;
         uint32_t ctrl8bit : 1 = 0;
@@ -433,6 +425,7 @@ struct Terminal::Impl {
 
         bool string_initial = false;
         bool emit_nul = false;
+        ParserEngine engine = ParserEngine::Switch;
     } parser;
 
     std::function<void(std::span<const char>)> outfunc;
@@ -498,8 +491,16 @@ struct Terminal::Impl {
         push_output_bytes(s);
     }
 
+    void apply_size(int32_t new_rows, int32_t new_cols);
+    void commit_pending_size();
+
     // Parser
     size_t input_write(std::span<const char> bytes);
+    void sync_output_wrote(size_t bytes); // defined in screen.cpp (needs complete Screen::Impl)
+    size_t write_direct(std::span<const char> bytes, size_t& parse); // defined in screen.cpp
+    size_t input_write_switch(std::span<const char> bytes);
+    size_t input_write_table(std::span<const char> bytes);
+    size_t emit_text(std::span<const char> bytes);
     void do_control(uint8_t control);
     void do_csi(char command);
     void do_escape(char command);
@@ -620,16 +621,72 @@ inline constexpr auto unicode_fullwidth = std::to_array<UnicodeInterval>({
     return 1;
 }
 
-[[nodiscard]] constexpr int32_t unicode_width(uint32_t codepoint) {
+// Reference lookups over the interval tables; unicode.cpp builds the
+// constant-time table below from these
+[[nodiscard]] constexpr int32_t unicode_interval_width(uint32_t codepoint) {
     if(unicode_bisearch(codepoint, unicode_fullwidth))
         return 2;
     return unicode_mk_wcwidth(codepoint);
 }
 
-[[nodiscard]] constexpr bool unicode_is_combining(uint32_t codepoint) {
+[[nodiscard]] constexpr bool unicode_interval_is_combining(uint32_t codepoint) {
     return unicode_bisearch(codepoint, unicode_combining);
 }
 
+// Three-stage lookup table. The top bits of a codepoint select a block of
+// leaf ids, the middle bits a leaf within it and the low bits an entry in
+// that leaf. Identical blocks and leaves are shared.
+// Each entry holds width + 1 in its low bits plus a combining flag.
+inline constexpr uint32_t unicode_table_end  = 0x110000;
+inline constexpr int32_t  unicode_leaf_bits  = 6;
+inline constexpr int32_t  unicode_block_bits = 6;
+inline constexpr int32_t  unicode_stage1_shift = unicode_leaf_bits + unicode_block_bits;
+inline constexpr uint32_t unicode_leaf_size  = 1u << unicode_leaf_bits;
+inline constexpr uint32_t unicode_block_size = 1u << unicode_block_bits;
+
+inline constexpr uint8_t unicode_entry_width_mask = 0x03;
+inline constexpr uint8_t unicode_entry_combining  = 0x04;
+
+struct UnicodeTable {
+    std::array<uint8_t, (unicode_table_end >> unicode_stage1_shift)> stage1; // block ids
+    const uint8_t* stage2; // leaf ids, unicode_block_size per block
+    const uint8_t* leaves; // entries, unicode_leaf_size per leaf
+};
+
+extern const UnicodeTable unicode_table;
+
+[[nodiscard]] inline uint8_t unicode_table_entry(uint32_t codepoint) {
+    if(codepoint >= unicode_table_end)
+        return 2; // width 1, not combining
+    uint32_t block = unicode_table.stage1[codepoint >> unicode_stage1_shift];
+    uint32_t leaf  = unicode_table.stage2[(block << unicode_block_bits) | ((codepoint >> unicode_leaf_bits) & (unicode_block_size - 1))];
+    return unicode_table.leaves[(leaf << unicode_leaf_bits) | (codepoint & (unicode_leaf_size - 1))];
+}
+
+[[nodiscard]] inline int32_t unicode_width(uint32_t codepoint) {
+    return (unicode_table_entry(codepoint) & unicode_entry_width_mask) - 1;
+}
+
+[[nodiscard]] inline bool unicode_is_combining(uint32_t codepoint) {
+    return (unicode_table_entry(codepoint) & unicode_entry_combining) != 0;
+}
+
+// Printable codepoints below the first combining character (U+0300): always
+// one cell wide and never combining, so no table lookup is needed
+inline constexpr uint32_t unicode_simple_end = 0x300;
+
+[[nodiscard]] constexpr bool unicode_is_simple_narrow(uint32_t codepoint) {
+    return (codepoint >= c0_end && codepoint < ctrl_del) ||
+           (codepoint >= c1_end && codepoint < unicode_simple_end);
+}
+
+static_assert([] {
+    for(uint32_t c = 0; c < unicode_simple_end; c++)
+        if(unicode_is_simple_narrow(c) && (unicode_interval_width(c) != 1 || unicode_interval_is_combining(c)))
+            return false;
+    return true;
+}(), "unicode_is_simple_narrow() must agree with the width tables");
+
 // --- scroll_rect / copy_cells templates ---
 
 template<typename MoveRect, typename EraseRect>
@@ -1,4 +1,6 @@
 #include "internal.h"
+#include "parser_table.h"
+#include "simd.h"
 
 #include <limits>
 
@@ -28,6 +30,33 @@ constexpr uint8_t final_end       = 0x7e;
     return c >= intermed_start && c <= intermed_end;
 }
 
+[[nodiscard]] constexpr bool is_digit(uint8_t c) {
+    return c >= '0' && c <= '9';
+}
+
+// Marks "no string fragment in progress" for input_write's string_start
+constexpr size_t no_string = std::numeric_limits<size_t>::max();
+
+// Strings carry on from the start of the next write; commands do not
+[[nodiscard]] constexpr size_t initial_string_start(ParserState state) {
+    switch(state) {
+    case ParserState::OSC:
+    case ParserState::DCS:
+    case ParserState::APC:
+    case ParserState::PM:
+    case ParserState::SOS:
+        return 0;
+    case ParserState::Normal:
+    case ParserState::CSILeader:
+    case ParserState::CSIArgs:
+    case ParserState::CSIIntermed:
+    case ParserState::OSCCommand:
+    case ParserState::DCSCommand:
+        break;
+    }
+    return no_string;
+}
+
 } // anonymous namespace
 
 void Terminal::Impl::do_control(uint8_t control) {
@@ -109,32 +138,40 @@ void Terminal::Impl::string_fragment(std::span<const char> str, bool final_) {
     parser.string_initial = false;
 }
 
+size_t Terminal::Impl::emit_text(std::span<const char> data) {
+    // Hand the whole run of plain text to the callback in one go.
+    // The byte that ended the run (if any) is included so that
+    // decoders can see a control interrupting a partial sequence.
+    size_t run = scan_plain_text(data, !mode.utf8);
+    if(run == 0)
+        run = 1;
+    size_t span_len = std::min(run + 1, data.size());
+
+    size_t eaten = 0;
+    if(parser.callbacks)
+        eaten = parser.callbacks->on_text(data.first(span_len));
+
+    if(eaten == 0) {
+        DEBUG_LOG("libvterm: Text callback did not consume any input\n");
+        eaten = 1;
+    }
+
+    return eaten;
+}
+
 bool Terminal::Impl::is_string_state() const {
     return parser.state >= ParserState::OSCCommand;
 }
 
 size_t Terminal::Impl::input_write(std::span<const char> data) {
-    static constexpr size_t no_string = std::numeric_limits<size_t>::max();
-    size_t pos = 0;
-    size_t string_start;
+    if(parser.engine == ParserEngine::Table)
+        return input_write_table(data);
+    return input_write_switch(data);
+}
 
-    switch(parser.state) {
-    case ParserState::Normal:
-    case ParserState::CSILeader:
-    case ParserState::CSIArgs:
-    case ParserState::CSIIntermed:
-    case ParserState::OSCCommand:
-    case ParserState::DCSCommand:
-        string_start = no_string;
-        break;
-    case ParserState::OSC:
-    case ParserState::DCS:
-    case ParserState::APC:
-    case ParserState::PM:
-    case ParserState::SOS:
-        string_start = 0;
-        break;
-    }
+size_t Terminal::Impl::input_write_switch(std::span<const char> data) {
+    size_t pos = 0;
+    size_t string_start = initial_string_start(parser.state);
 
     auto enter_state = [&](ParserState st) { parser.state = st; string_start = no_string; };
     auto enter_normal_state = [&]() { enter_state(ParserState::Normal); };
@@ -363,21 +400,231 @@ size_t Terminal::Impl::input_write(std::span<const char> data) {
                 }
             }
             else {
-                size_t eaten = 0;
-                if(parser.callbacks)
-                    eaten = parser.callbacks->on_text(data.subspan(pos));
+                pos += emit_text(data.subspan(pos)) - 1; // we'll ++ it again in a moment
+            }
+            break;
+        }
+    }
 
-                if(eaten == 0) {
-                    DEBUG_LOG("libvterm: Text callback did not consume any input\n");
-                    eaten = 1;
-                }
+    if(string_start != no_string) {
+        size_t string_len = pos - string_start;
+        if(parser.in_esc && string_len > 0)
+            string_len -= 1;
+        string_fragment(data.subspan(string_start, string_len), false);
+    }
+
+    return data.size();
+}
+
+size_t Terminal::Impl::input_write_table(std::span<const char> data) {
+    const ByteClassTable& classes = parser_byte_classes[mode.utf8];
+
+    DfaState st = dfa_state_for(parser.state, parser.in_esc, parser.intermedlen > 0);
+    size_t string_start = initial_string_start(parser.state);
+    size_t pos = 0;
+
+    // string_fragment() dispatches on parser.state, which is only brought up
+    // to date here and at the end of the write
+    auto fragment = [&](size_t len, bool final_) {
+        parser.state = parser_state_of(st);
+        string_fragment(data.subspan(string_start, len), final_);
+    };
+
+    for( ; pos < data.size(); pos++) {
+        uint8_t c = static_cast<uint8_t>(data[pos]);
+        const Transition& t = parser_transition(st, classes[c]);
+
+        if(t.pre & pre_csi_begin_args) {
+            parser.v.csi.leader[parser.v.csi.leaderlen] = 0;
+            parser.v.csi.argi = 0;
+            parser.v.csi.args[0] = csi_arg_missing;
+        }
+        if(t.pre & pre_csi_end_args) {
+            parser.v.csi.argi++;
+            parser.intermedlen = 0;
+        }
+
+        switch(t.action) {
+        case ParseAction::None:
+            break;
 
-                pos += (eaten - 1); // we'll ++ it again in a moment
+        case ParseAction::IgnoreString:
+            if(string_start != no_string) {
+                fragment(pos - string_start, false);
+                string_start = pos + 1;
+            }
+            [[fallthrough]];
+        case ParseAction::Ignore:
+            if(parser.emit_nul)
+                do_control(c);
+            break;
+
+        case ParseAction::Cancel:
+            string_start = no_string;
+            if(parser.emit_nul)
+                do_control(c);
+            break;
+
+        case ParseAction::Escape:
+            parser.intermedlen = 0;
+            break;
+
+        case ParseAction::ExecuteString:
+            if(string_start != no_string)
+                fragment(pos - string_start, false);
+            do_control(c);
+            string_start = pos + 1;
+            break;
+
+        case ParseAction::Execute:
+        case ParseAction::C1Control:
+            do_control(c);
+            break;
+
+        case ParseAction::EscC1Control:
+            do_control(c + c1_esc_offset);
+            break;
+
+        case ParseAction::Print:
+            pos += emit_text(data.subspan(pos)) - 1; // we'll ++ it again in a moment
+            break;
+
+        case ParseAction::EscCollect:
+            string_start = no_string;
+            if(parser.intermedlen < intermed_max - 1)
+                parser.intermed[parser.intermedlen++] = c;
+            break;
+
+        case ParseAction::EscDispatch:
+            string_start = no_string;
+            do_escape(c);
+            break;
+
+        case ParseAction::EscUnhandled:
+            string_start = no_string;
+            DEBUG_LOG("TODO: Unhandled byte {:02x} in Escape\n", c);
+            break;
+
+        case ParseAction::EnterDcs:
+            parser.string_initial = true;
+            parser.v.dcs.commandlen = 0;
+            string_start = no_string;
+            break;
+
+        case ParseAction::EnterCsi:
+            parser.v.csi.leaderlen = 0;
+            string_start = no_string;
+            break;
+
+        case ParseAction::EnterOsc:
+            parser.v.osc.command = -1;
+            parser.string_initial = true;
+            string_start = no_string;
+            break;
+
+        case ParseAction::EnterSos:
+        case ParseAction::EnterPm:
+        case ParseAction::EnterApc:
+            parser.string_initial = true;
+            string_start = pos + 1;
+            break;
+
+        case ParseAction::CsiCollectLeader:
+            if(parser.v.csi.leaderlen < csi_leader_max - 1)
+                parser.v.csi.leader[parser.v.csi.leaderlen++] = c;
+            break;
+
+        case ParseAction::CsiParam: {
+            // Take the rest of the number in one go
+            int64_t& arg = parser.v.csi.args[parser.v.csi.argi];
+            if(arg == csi_arg_missing)
+                arg = 0;
+            for(;;) {
+                if(arg <= arg_overflow_limit)
+                    arg = arg * 10 + (c - '0');
+                if(pos + 1 == data.size() || !is_digit(static_cast<uint8_t>(data[pos + 1])))
+                    break;
+                c = static_cast<uint8_t>(data[++pos]);
             }
             break;
         }
+
+        case ParseAction::CsiSubParam:
+            parser.v.csi.args[parser.v.csi.argi] |= csi_arg_flag_more;
+            [[fallthrough]];
+        case ParseAction::CsiSeparator:
+            if(parser.v.csi.argi < csi_args_max - 1) {
+                parser.v.csi.argi++;
+                parser.v.csi.args[parser.v.csi.argi] = csi_arg_missing;
+            }
+            break;
+
+        case ParseAction::CsiCollect:
+            if(parser.intermedlen < intermed_max - 1)
+                parser.intermed[parser.intermedlen++] = c;
+            break;
+
+        case ParseAction::CsiDispatch:
+            parser.intermed[parser.intermedlen] = 0;
+            do_csi(c);
+            break;
+
+        case ParseAction::DcsCollectFinal:
+            string_start = pos + 1;
+            [[fallthrough]];
+        case ParseAction::DcsCollect:
+            if(parser.v.dcs.commandlen < csi_leader_max)
+                parser.v.dcs.command[parser.v.dcs.commandlen++] = c;
+            break;
+
+        case ParseAction::OscParam:
+            if(parser.v.osc.command == -1)
+                parser.v.osc.command = 0;
+            else if(parser.v.osc.command > arg_overflow_limit)
+                break;
+            else
+                parser.v.osc.command *= 10;
+            parser.v.osc.command += c - '0';
+            break;
+
+        case ParseAction::OscStart:
+            string_start = pos + 1;
+            break;
+
+        case ParseAction::OscStartHere:
+            string_start = pos;
+            break;
+
+        case ParseAction::OscEmptyEnd:
+            parser.state = ParserState::OSC;
+            string_fragment(data.subspan(pos, 0), true);
+            string_start = no_string;
+            break;
+
+        case ParseAction::StringEnd:
+            fragment(pos - string_start, true);
+            string_start = no_string;
+            break;
+
+        case ParseAction::StringEndEsc: {
+            size_t string_len = pos - string_start;
+            if(string_len)
+                string_len -= 1;
+            fragment(string_len, true);
+            string_start = no_string;
+            break;
+        }
+
+        case ParseAction::Invalid:
+            break;
+        }
+
+        st = t.next;
     }
 
+    parser.state = parser_state_of(st);
+    parser.in_esc = is_escape_dfa_state(st);
+
     if(string_start != no_string) {
         size_t string_len = pos - string_start;
         if(parser.in_esc && string_len > 0)
@@ -0,0 +1,488 @@
+#ifndef VTERM_PARSER_TABLE_H
+#define VTERM_PARSER_TABLE_H
+
+// Transition table for the table-driven parser engine, in the style of the
+// Paul Williams DEC VT500 parser: every input byte is mapped to a class,
+// and the (state, class) pair selects an action and a successor state.
+// Both tables are generated at compile time from the same rules as the
+// hand-written loop in parser.cpp, and checked with static_assert below.
+
+#include "internal.h"
+
+#include <array>
+#include <cstdint>
+
+namespace vterm {
+
+// ---- Byte classes ----
+
+enum class ByteClass : uint8_t {
+    Ignore,        // NUL, DEL
+    Cancel,        // CAN, SUB
+    Escape,        // ESC
+    Bell,          // BEL
+    Control,       // every other C0
+    Intermediate,  // 0x20-0x2f
+    Digit,         // 0-9
+    Colon,         // :
+    Semicolon,     // ;
+    Private,       // < = > ?
+    // 0x40-0x5f; each of these becomes the matching C1 class after ESC
+    Upper,
+    IntroDcs,      // P
+    IntroSos,      // X
+    IntroCsi,      // [
+    IntroSt,       // backslash
+    IntroOsc,      // ]
+    IntroPm,       // ^
+    IntroApc,      // _
+    Lower,         // 0x60-0x7e
+    // 0x80-0x9f, only when 8-bit C1 controls are recognised
+    C1,
+    C1Dcs,
+    C1Sos,
+    C1Csi,
+    C1St,
+    C1Osc,
+    C1Pm,
+    C1Apc,
+    High,          // 0xa0-0xff, or 0x80-0xff in UTF-8 mode
+
+    Count,
+};
+
+inline constexpr size_t byte_class_count = static_cast<size_t>(ByteClass::Count);
+
+[[nodiscard]] constexpr ByteClass intro_to_c1(ByteClass cls) {
+    return static_cast<ByteClass>(to_underlying(cls) + (to_underlying(ByteClass::C1) - to_underlying(ByteClass::Upper)));
+}
+
+[[nodiscard]] constexpr bool is_final_class(ByteClass cls) {
+    return cls >= ByteClass::Upper && cls <= ByteClass::Lower;
+}
+
+// End (exclusive) of the bytes that form a C1 control when preceded by ESC
+inline constexpr uint8_t esc_fe_end = c1_end - c1_esc_offset;
+
+[[nodiscard]] constexpr ByteClass classify_byte(uint8_t c, bool c1_allowed) {
+    if(c == ctrl_nul || c == ctrl_del) return ByteClass::Ignore;
+    if(c == ctrl_can || c == ctrl_sub) return ByteClass::Cancel;
+    if(c == ctrl_esc)                  return ByteClass::Escape;
+    if(c == ctrl_bel)                  return ByteClass::Bell;
+    if(c < c0_end)                     return ByteClass::Control;
+    if(c < '0')                        return ByteClass::Intermediate;
+    if(c <= '9')                       return ByteClass::Digit;
+    if(c == ':')                       return ByteClass::Colon;
+    if(c == ';')                       return ByteClass::Semicolon;
+    if(c < '@')                        return ByteClass::Private;
+    if(c >= c1_start && c < c1_end && !c1_allowed)
+        return ByteClass::High;
+    if(c >= c1_end || (c >= esc_fe_end && c < c1_start))
+        return c < c1_start ? ByteClass::Lower : ByteClass::High;
+
+    // 0x40-0x5f and 0x80-0x9f: classify by the C1 control it denotes
+    uint8_t c1 = c < c1_start ? static_cast<uint8_t>(c + c1_esc_offset) : c;
+    ByteClass base = ByteClass::Upper;
+    switch(static_cast<C1>(c1)) {
+    case C1::DCS: base = ByteClass::IntroDcs; break;
+    case C1::SOS: base = ByteClass::IntroSos; break;
+    case C1::CSI: base = ByteClass::IntroCsi; break;
+    case C1::ST:  base = ByteClass::IntroSt;  break;
+    case C1::OSC: base = ByteClass::IntroOsc; break;
+    case C1::PM:  base = ByteClass::IntroPm;  break;
+    case C1::APC: base = ByteClass::IntroApc; break;
+    default: break;
+    }
+    return c < c1_start ? base : intro_to_c1(base);
+}
+
+// Indexed by mode.utf8: [0] recognises 8-bit C1 controls, [1] does not
+using ByteClassTable = std::array<ByteClass, 256>;
+
+[[nodiscard]] constexpr std::array<ByteClassTable, 2> make_byte_classes() {
+    std::array<ByteClassTable, 2> tables{};
+    for(int32_t c = 0; c < 256; c++) {
+        tables[0][static_cast<size_t>(c)] = classify_byte(static_cast<uint8_t>(c), true);
+        tables[1][static_cast<size_t>(c)] = classify_byte(static_cast<uint8_t>(c), false);
+    }
+    return tables;
+}
+
+inline constexpr std::array<ByteClassTable, 2> parser_byte_classes = make_byte_classes();
+
+// ---- States ----
+
+// A flattened (ParserState, in_esc) pair. Normal with a pending ESC is split
+// on whether intermediates have been collected, since only the bare ESC form
+// can introduce a C1 control.
+enum class DfaState : uint8_t {
+    Ground,
+    Escape,
+    EscapeIntermediate,
+    CsiLeader,
+    CsiArgs,
+    CsiIntermediate,
+    DcsCommand,
+    // String states, then the same string states with an ESC pending
+    OscCommand,
+    Osc,
+    Dcs,
+    Apc,
+    Pm,
+    Sos,
+    OscCommandEscape,
+    OscEscape,
+    DcsEscape,
+    ApcEscape,
+    PmEscape,
+    SosEscape,
+
+    Count,
+};
+
+inline constexpr size_t dfa_state_count = static_cast<size_t>(DfaState::Count);
+
+inline constexpr uint8_t dfa_string_escape_offset =
+    to_underlying(DfaState::OscCommandEscape) - to_underlying(DfaState::OscCommand);
+
+[[nodiscard]] constexpr bool is_string_dfa_state(DfaState st) {
+    return st >= DfaState::OscCommand;
+}
+
+[[nodiscard]] constexpr bool is_escape_dfa_state(DfaState st) {
+    return st == DfaState::Escape || st == DfaState::EscapeIntermediate || st >= DfaState::OscCommandEscape;
+}
+
+[[nodiscard]] constexpr DfaState string_escape_of(DfaState st) {
+    return st >= DfaState::OscCommandEscape ? st
+         : static_cast<DfaState>(to_underlying(st) + dfa_string_escape_offset);
+}
+
+[[nodiscard]] constexpr DfaState string_base_of(DfaState st) {
+    return st >= DfaState::OscCommandEscape
+         ? static_cast<DfaState>(to_underlying(st) - dfa_string_escape_offset)
+         : st;
+}
+
+[[nodiscard]] constexpr ParserState parser_state_of(DfaState st) {
+    switch(string_base_of(st)) {
+    case DfaState::CsiLeader:       return ParserState::CSILeader;
+    case DfaState::CsiArgs:         return ParserState::CSIArgs;
+    case DfaState::CsiIntermediate: return ParserState::CSIIntermed;
+    case DfaState::DcsCommand:      return ParserState::DCSCommand;
+    case DfaState::OscCommand:      return ParserState::OSCCommand;
+    case DfaState::Osc:             return ParserState::OSC;
+    case DfaState::Dcs:             return ParserState::DCS;
+    case DfaState::Apc:             return ParserState::APC;
+    case DfaState::Pm:              return ParserState::PM;
+    case DfaState::Sos:             return ParserState::SOS;
+    default:                        return ParserState::Normal;
+    }
+}
+
+[[nodiscard]] constexpr DfaState dfa_state_for(ParserState state, bool in_esc, bool has_intermed) {
+    DfaState st = DfaState::Ground;
+    switch(state) {
+    case ParserState::Normal:
+        if(in_esc)
+            return has_intermed ? DfaState::EscapeIntermediate : DfaState::Escape;
+        return DfaState::Ground;
+    case ParserState::CSILeader:   return DfaState::CsiLeader;
+    case ParserState::CSIArgs:     return DfaState::CsiArgs;
+    case ParserState::CSIIntermed: return DfaState::CsiIntermediate;
+    case ParserState::DCSCommand:  return DfaState::DcsCommand;
+    case ParserState::OSCCommand:  st = DfaState::OscCommand; break;
+    case ParserState::OSC:         st = DfaState::Osc;        break;
+    case ParserState::DCS:         st = DfaState::Dcs;        break;
+    case ParserState::APC:         st = DfaState::Apc;        break;
+    case ParserState::PM:          st = DfaState::Pm;         break;
+    case ParserState::SOS:         st = DfaState::Sos;        break;
+    }
+    return in_esc ? string_escape_of(st) : st;
+}
+
+// ---- Actions ----
+
+enum class ParseAction : uint8_t {
+    None,
+    Ignore,            // NUL/DEL outside a string
+    IgnoreString,      // NUL/DEL inside a string: split the fragment around it
+    Cancel,
+    Escape,
+    Execute,
+    ExecuteString,     // C0 inside a string: split the fragment around it
+    Print,
+    EscCollect,
+    EscDispatch,
+    EscUnhandled,
+    C1Control,         // 8-bit C1 control
+    EscC1Control,      // 7-bit ESC Fe form of a C1 control
+    EnterDcs,
+    EnterSos,
+    EnterCsi,
+    EnterOsc,
+    EnterPm,
+    EnterApc,
+    CsiCollectLeader,
+    CsiParam,
+    CsiSubParam,
+    CsiSeparator,
+    CsiCollect,
+    CsiDispatch,
+    DcsCollect,
+    DcsCollectFinal,
+    OscParam,
+    OscStart,          // ';' after the command number
+    OscStartHere,      // string begins with the current byte
+    OscEmptyEnd,       // terminated before any string data
+    StringEnd,         // BEL or 8-bit ST
+    StringEndEsc,      // ESC \ — the ESC is not part of the string
+
+    Invalid,
+};
+
+// Work done before the action, modelling the fall-through between the
+// CSILeader -> CSIArgs -> CSIIntermed states of the hand-written loop
+inline constexpr uint8_t pre_csi_begin_args = 1 << 0;
+inline constexpr uint8_t pre_csi_end_args   = 1 << 1;
+
+// Padded to four bytes so a table lookup is a shift rather than a multiply
+struct alignas(4) Transition {
+    ParseAction action = ParseAction::Invalid;
+    DfaState next = DfaState::Ground;
+    uint8_t pre = 0;
+};
+
+namespace parser_table_detail {
+
+[[nodiscard]] constexpr Transition to(ParseAction action, DfaState next, uint8_t pre = 0) {
+    return {action, next, pre};
+}
+
+[[nodiscard]] constexpr ParseAction enter_action(ByteClass c1) {
+    switch(c1) {
+    case ByteClass::C1Dcs: return ParseAction::EnterDcs;
+    case ByteClass::C1Sos: return ParseAction::EnterSos;
+    case ByteClass::C1Csi: return ParseAction::EnterCsi;
+    case ByteClass::C1Osc: return ParseAction::EnterOsc;
+    case ByteClass::C1Pm:  return ParseAction::EnterPm;
+    case ByteClass::C1Apc: return ParseAction::EnterApc;
+    default:               return ParseAction::C1Control;
+    }
+}
+
+[[nodiscard]] constexpr DfaState enter_state(ByteClass c1) {
+    switch(c1) {
+    case ByteClass::C1Dcs: return DfaState::DcsCommand;
+    case ByteClass::C1Sos: return DfaState::Sos;
+    case ByteClass::C1Csi: return DfaState::CsiLeader;
+    case ByteClass::C1Osc: return DfaState::OscCommand;
+    case ByteClass::C1Pm:  return DfaState::Pm;
+    case ByteClass::C1Apc: return DfaState::Apc;
+    default:               return DfaState::Ground;
+    }
+}
+
+// Normal state with a pending ESC, after any string has been abandoned
+[[nodiscard]] constexpr Transition escape_rule(DfaState st, ByteClass cls) {
+    if(cls == ByteClass::Intermediate)
+        return to(ParseAction::EscCollect, DfaState::EscapeIntermediate);
+    if(cls >= ByteClass::Digit && cls <= ByteClass::Lower)
+        return to(ParseAction::EscDispatch, DfaState::Ground);
+    return to(ParseAction::EscUnhandled, st == DfaState::EscapeIntermediate ? st : DfaState::Escape);
+}
+
+[[nodiscard]] constexpr Transition csi_intermediate_rule(ByteClass cls, uint8_t pre) {
+    if(cls == ByteClass::Intermediate)
+        return to(ParseAction::CsiCollect, DfaState::CsiIntermediate, pre);
+    if(is_final_class(cls))
+        return to(ParseAction::CsiDispatch, DfaState::Ground, pre);
+    return to(ParseAction::None, DfaState::Ground, pre);
+}
+
+[[nodiscard]] constexpr Transition csi_args_rule(ByteClass cls, uint8_t pre) {
+    switch(cls) {
+    case ByteClass::Digit:     return to(ParseAction::CsiParam, DfaState::CsiArgs, pre);
+    case ByteClass::Colon:     return to(ParseAction::CsiSubParam, DfaState::CsiArgs, pre);
+    case ByteClass::Semicolon: return to(ParseAction::CsiSeparator, DfaState::CsiArgs, pre);
+    default:                   return csi_intermediate_rule(cls, pre | pre_csi_end_args);
+    }
+}
+
+[[nodiscard]] constexpr Transition make_transition(DfaState st, ByteClass cls) {
+    bool string_state = is_string_dfa_state(st);
+
+    // Controls that act the same way in every state
+    switch(cls) {
+    case ByteClass::Ignore:
+        return to(string_state ? ParseAction::IgnoreString : ParseAction::Ignore, st);
+    case ByteClass::Cancel:
+        return to(ParseAction::Cancel, DfaState::Ground);
+    case ByteClass::Escape:
+        return to(ParseAction::Escape, string_state ? string_escape_of(st) : DfaState::Escape);
+    case ByteClass::Control:
+        if(string_base_of(st) == DfaState::Sos)
+            return to(ParseAction::None, st);
+        return to(string_state ? ParseAction::ExecuteString : ParseAction::Execute, st);
+    case ByteClass::Bell:
+        if(!string_state)
+            return to(ParseAction::Execute, st);
+        break;
+    default:
+        break;
+    }
+
+    // A pending ESC inside a string: only ESC \ (ST) keeps the string alive
+    // long enough to terminate it; anything else abandons it.
+    if(st >= DfaState::OscCommandEscape) {
+        if(cls == ByteClass::IntroSt)
+            return to(st == DfaState::OscCommandEscape ? ParseAction::OscEmptyEnd : ParseAction::StringEndEsc,
+                      DfaState::Ground);
+        return escape_rule(DfaState::Escape, cls);
+    }
+
+    switch(st) {
+    case DfaState::Ground:
+        if(cls >= ByteClass::C1 && cls <= ByteClass::C1Apc)
+            return to(enter_action(cls), enter_state(cls));
+        return to(ParseAction::Print, DfaState::Ground);
+
+    case DfaState::Escape:
+        if(cls == ByteClass::IntroSt || cls == ByteClass::Upper)
+            return to(ParseAction::EscC1Control, DfaState::Ground);
+        if(cls > ByteClass::Upper && cls <= ByteClass::IntroApc)
+            return to(enter_action(intro_to_c1(cls)), enter_state(intro_to_c1(cls)));
+        return escape_rule(st, cls);
+
+    case DfaState::EscapeIntermediate:
+        return escape_rule(st, cls);
+
+    case DfaState::CsiLeader:
+        if(cls == ByteClass::Private)
+            return to(ParseAction::CsiCollectLeader, DfaState::CsiLeader);
+        return csi_args_rule(cls, pre_csi_begin_args);
+
+    case DfaState::CsiArgs:
+        return csi_args_rule(cls, 0);
+
+    case DfaState::CsiIntermediate:
+        return csi_intermediate_rule(cls, 0);
+
+    case DfaState::DcsCommand:
+        if(is_final_class(cls))
+            return to(ParseAction::DcsCollectFinal, DfaState::Dcs);
+        return to(ParseAction::DcsCollect, DfaState::DcsCommand);
+
+    case DfaState::OscCommand:
+        if(cls == ByteClass::Digit)
+            return to(ParseAction::OscParam, DfaState::OscCommand);
+        if(cls == ByteClass::Semicolon)
+            return to(ParseAction::OscStart, DfaState::Osc);
+        if(cls == ByteClass::Bell || cls == ByteClass::C1St)
+            return to(ParseAction::OscEmptyEnd, DfaState::Ground);
+        return to(ParseAction::OscStartHere, DfaState::Osc);
+
+    case DfaState::Osc:
+    case DfaState::Dcs:
+    case DfaState::Apc:
+    case DfaState::Pm:
+    case DfaState::Sos:
+        if(cls == ByteClass::Bell || cls == ByteClass::C1St)
+            return to(ParseAction::StringEnd, DfaState::Ground);
+        return to(ParseAction::None, st);
+
+    default:
+        return {};
+    }
+}
+
+using TransitionRow = std::array<Transition, byte_class_count>;
+
+[[nodiscard]] constexpr std::array<TransitionRow, dfa_state_count> make_transitions() {
+    std::array<TransitionRow, dfa_state_count> table{};
+    for(size_t s = 0; s < dfa_state_count; s++)
+        for(size_t c = 0; c < byte_class_count; c++)
+            table[s][c] = make_transition(static_cast<DfaState>(s), static_cast<ByteClass>(c));
+    return table;
+}
+
+} // namespace parser_table_detail
+
+inline constexpr auto parser_transitions = parser_table_detail::make_transitions();
+
+[[nodiscard]] constexpr const Transition& parser_transition(DfaState st, ByteClass cls) {
+    return parser_transitions[to_underlying(st)][to_underlying(cls)];
+}
+
+// ---- Compile-time checks ----
+
+namespace parser_table_detail {
+
+[[nodiscard]] constexpr bool all_transitions(auto pred) {
+    for(size_t s = 0; s < dfa_state_count; s++)
+        for(size_t c = 0; c < byte_class_count; c++)
+            if(!pred(static_cast<DfaState>(s), static_cast<ByteClass>(c), parser_transitions[s][c]))
+                return false;
+    return true;
+}
+
+[[nodiscard]] constexpr bool all_bytes(auto pred) {
+    for(int32_t c = 0; c < 256; c++)
+        if(!pred(static_cast<uint8_t>(c),
+                 parser_byte_classes[0][static_cast<size_t>(c)],
+                 parser_byte_classes[1][static_cast<size_t>(c)]))
+            return false;
+    return true;
+}
+
+} // namespace parser_table_detail
+
+static_assert([] {
+    for(size_t s = 0; s < dfa_state_count; s++) {
+        auto st = static_cast<DfaState>(s);
+        if(dfa_state_for(parser_state_of(st), is_escape_dfa_state(st), st == DfaState::EscapeIntermediate) != st)
+            return false;
+    }
+    return true;
+}(), "every DFA state must round-trip through the parser's (state, in_esc) pair");
+
+static_assert(parser_table_detail::all_transitions([](DfaState, ByteClass, const Transition& t) {
+    return t.action != ParseAction::Invalid && t.next < DfaState::Count;
+}), "every (state, class) pair must have a transition");
+
+static_assert(parser_table_detail::all_transitions([](DfaState, ByteClass cls, const Transition& t) {
+    return cls != ByteClass::Cancel || (t.action == ParseAction::Cancel && t.next == DfaState::Ground);
+}), "CAN and SUB must return to ground from every state");
+
+static_assert(parser_table_detail::all_transitions([](DfaState st, ByteClass cls, const Transition& t) {
+    return cls != ByteClass::Escape || (is_escape_dfa_state(t.next) &&
+        is_string_dfa_state(st) == is_string_dfa_state(t.next));
+}), "ESC must leave a pending escape, keeping any string state");
+
+static_assert(parser_table_detail::all_transitions([](DfaState st, ByteClass cls, const Transition& t) {
+    return (cls != ByteClass::Ignore && cls != ByteClass::Control) || t.next == st;
+}), "NUL, DEL and C0 controls must not change state");
+
+static_assert(parser_table_detail::all_transitions([](DfaState st, ByteClass, const Transition& t) {
+    return t.action != ParseAction::Print || st == DfaState::Ground;
+}), "only ground state prints text");
+
+static_assert(parser_table_detail::all_transitions([](DfaState st, ByteClass, const Transition& t) {
+    return t.pre == 0 || string_base_of(st) == DfaState::CsiLeader || st == DfaState::CsiArgs;
+}), "CSI fall-through is only possible out of the leader and argument states");
+
+static_assert(parser_table_detail::all_bytes([](uint8_t c, ByteClass c1_cls, ByteClass utf8_cls) {
+    if(c >= c1_start && c < c1_end)
+        return c1_cls >= ByteClass::C1 && c1_cls <= ByteClass::C1Apc && utf8_cls == ByteClass::High;
+    return c1_cls == utf8_cls;
+}), "the two byte class tables may only differ in the C1 range");
+
+static_assert(parser_table_detail::all_bytes([](uint8_t c, ByteClass c1_cls, ByteClass) {
+    if(c < c1_start || c >= c1_end)
+        return true;
+    return intro_to_c1(classify_byte(static_cast<uint8_t>(c - c1_esc_offset), true)) == c1_cls;
+}), "each ESC Fe byte must map onto the class of its 8-bit C1 equivalent");
+
+} // namespace vterm
+
+#endif // VTERM_PARSER_TABLE_H
@@ -61,6 +61,22 @@ constexpr void lookup_default_colour_ansi(int64_t idx, Color& col) {
     return argi;
 }
 
+// Order in which attributes are reported when falling back to on_setpenattr
+constexpr std::array<std::pair<AttrMask, Attr>, 12> pen_attr_masks = {{
+    {AttrMask::Bold,       Attr::Bold},
+    {AttrMask::Underline,  Attr::Underline},
+    {AttrMask::Italic,     Attr::Italic},
+    {AttrMask::Blink,      Attr::Blink},
+    {AttrMask::Reverse,    Attr::Reverse},
+    {AttrMask::Conceal,    Attr::Conceal},
+    {AttrMask::Strike,     Attr::Strike},
+    {AttrMask::Font,       Attr::Font},
+    {AttrMask::Small,      Attr::Small},
+    {AttrMask::Baseline,   Attr::Baseline},
+    {AttrMask::Foreground, Attr::Foreground},
+    {AttrMask::Background, Attr::Background},
+}};
+
 } // anonymous namespace
 
 bool State::Impl::lookup_colour_ansi(int64_t index, Color& col) const {
@@ -112,40 +128,49 @@ int32_t State::Impl::lookup_colour(int32_t palette, std::span<const int64_t> arg
     }
 }
 
-void State::Impl::setpenattr(Attr attr, ValueType type, const Value& val) {
-#ifdef DEBUG
-    if(type != get_attr_type(attr)) {
-        DEBUG_LOG("Cannot set attr {} as it has type {}, not type {}\n",
-            to_underlying(attr), to_underlying(get_attr_type(attr)), to_underlying(type));
-        return;
+bool State::Impl::get_penattr(Attr attr, Value& val) const {
+    switch(attr) {
+    case Attr::Bold:       val.boolean = pen.bold;      return true;
+    case Attr::Underline:  val.number  = to_underlying(pen.underline); return true;
+    case Attr::Italic:     val.boolean = pen.italic;    return true;
+    case Attr::Blink:      val.boolean = pen.blink;     return true;
+    case Attr::Reverse:    val.boolean = pen.reverse;   return true;
+    case Attr::Conceal:    val.boolean = pen.conceal;   return true;
+    case Attr::Strike:     val.boolean = pen.strike;    return true;
+    case Attr::Font:       val.number  = pen.font;      return true;
+    case Attr::Foreground: val.color   = pen.fg;        return true;
+    case Attr::Background: val.color   = pen.bg;        return true;
+    case Attr::Small:      val.boolean = pen.small;     return true;
+    case Attr::Baseline:   val.number  = to_underlying(pen.baseline);  return true;
+    case Attr::NAttrs:     return false;
     }
-#endif
-    if(callbacks)
-        callbacks->on_setpenattr(attr, val);
+    return false;
 }
 
-void State::Impl::setpenattr_bool(Attr attr, bool boolean) {
-    Value val{};
-    val.boolean = boolean;
-    setpenattr(attr, ValueType::Bool, val);
-}
+void State::Impl::flush_pen() {
+    AttrMask changed = pen_changed;
+    pen_changed = AttrMask{};
 
-void State::Impl::setpenattr_int(Attr attr, int32_t number) {
-    Value val{};
-    val.number = number;
-    setpenattr(attr, ValueType::Int, val);
-}
+    if(!changed || !callbacks)
+        return;
+    if(callbacks->on_setpen(pen, changed))
+        return;
 
-void State::Impl::setpenattr_col(Attr attr, Color color) {
-    Value val{};
-    val.color = color;
-    setpenattr(attr, ValueType::Color, val);
+    // Not handled as a batch; report each touched attribute in turn
+    for(auto [mask, attr] : pen_attr_masks) {
+        if(!(changed & mask))
+            continue;
+        Value val{};
+        (void)get_penattr(attr, val);
+        callbacks->on_setpenattr(attr, val);
+    }
 }
 
 void State::Impl::set_pen_col_ansi(Attr attr, int64_t col) {
-    Color& colref = (attr == Attr::Background) ? pen.bg : pen.fg;
+    bool is_bg = (attr == Attr::Background);
+    Color& colref = is_bg ? pen.bg : pen.fg;
     colref = Color::from_index(static_cast<uint8_t>(col));
-    setpenattr_col(attr, colref);
+    pen_changed |= is_bg ? AttrMask::Background : AttrMask::Foreground;
 }
 
 void State::Impl::newpen() {
@@ -160,20 +185,16 @@ void State::Impl::newpen() {
         lookup_default_colour_ansi(col, colors[col]);
 }
 
+void State::Impl::reset_pen_fields() {
+    pen = Pen{};
+    pen.fg = default_fg;
+    pen.bg = default_bg;
+    pen_changed = AttrMask::All;
+}
+
 void State::Impl::resetpen() {
-    pen.bold = false;      setpenattr_bool(Attr::Bold, false);
-    pen.underline = Underline::Off; setpenattr_int(Attr::Underline, to_underlying(pen.underline));
-    pen.italic = false;    setpenattr_bool(Attr::Italic, false);
-    pen.blink = false;     setpenattr_bool(Attr::Blink, false);
-    pen.reverse = false;   setpenattr_bool(Attr::Reverse, false);
-    pen.conceal = false;   setpenattr_bool(Attr::Conceal, false);
-    pen.strike = false;    setpenattr_bool(Attr::Strike, false);
-    pen.font = 0;          setpenattr_int (Attr::Font, 0);
-    pen.small = false;     setpenattr_bool(Attr::Small, false);
-    pen.baseline = Baseline::Normal; setpenattr_int(Attr::Baseline, to_underlying(pen.baseline));
-
-    pen.fg = default_fg;  setpenattr_col(Attr::Foreground, default_fg);
-    pen.bg = default_bg;  setpenattr_col(Attr::Background, default_bg);
+    reset_pen_fields();
+    flush_pen();
 }
 
 void State::Impl::savepen(bool save) {
@@ -182,20 +203,8 @@ void State::Impl::savepen(bool save) {
     }
     else {
         pen = saved.pen;
-
-        setpenattr_bool(Attr::Bold,      pen.bold);
-        setpenattr_int (Attr::Underline, to_underlying(pen.underline));
-        setpenattr_bool(Attr::Italic,    pen.italic);
-        setpenattr_bool(Attr::Blink,     pen.blink);
-        setpenattr_bool(Attr::Reverse,   pen.reverse);
-        setpenattr_bool(Attr::Conceal,   pen.conceal);
-        setpenattr_bool(Attr::Strike,    pen.strike);
-        setpenattr_int (Attr::Font,      pen.font);
-        setpenattr_bool(Attr::Small,     pen.small);
-        setpenattr_int (Attr::Baseline,  to_underlying(pen.baseline));
-
-        setpenattr_col(Attr::Foreground, pen.fg);
-        setpenattr_col(Attr::Background, pen.bg);
+        pen_changed = AttrMask::All;
+        flush_pen();
     }
 }
 
@@ -207,13 +216,13 @@ void State::Impl::setpen(std::span<const int64_t> args) {
         switch(int64_t arg = csi_arg(args[argi])) {
         case csi_arg_missing:
         case 0: // Reset
-            resetpen();
+            reset_pen_fields();
             break;
 
         case 1: { // Bold on
             const Color& fg = pen.fg;
             pen.bold = true;
-            setpenattr_bool(Attr::Bold, true);
+            pen_changed |= AttrMask::Bold;
             if(!fg.is_default_fg() && fg.is_indexed() && fg.indexed.idx < palette_normal_count && bold_is_highbright)
                 set_pen_col_ansi(Attr::Foreground, fg.indexed.idx + (pen.bold ? palette_normal_count : 0));
             break;
@@ -221,7 +230,7 @@ void State::Impl::setpen(std::span<const int64_t> args) {
 
         case 3:
             pen.italic = true;
-            setpenattr_bool(Attr::Italic, true);
+            pen_changed |= AttrMask::Italic;
             break;
 
         case 4: // Underline
@@ -235,73 +244,73 @@ void State::Impl::setpen(std::span<const int64_t> args) {
                 case 3: pen.underline = Underline::Curly; break;
                 }
             }
-            setpenattr_int(Attr::Underline, to_underlying(pen.underline));
+            pen_changed |= AttrMask::Underline;
             break;
 
         case 5:
             pen.blink = true;
-            setpenattr_bool(Attr::Blink, true);
+            pen_changed |= AttrMask::Blink;
             break;
 
         case 7:
             pen.reverse = true;
-            setpenattr_bool(Attr::Reverse, true);
+            pen_changed |= AttrMask::Reverse;
             break;
 
         case 8:
             pen.conceal = true;
-            setpenattr_bool(Attr::Conceal, true);
+            pen_changed |= AttrMask::Conceal;
             break;
 
         case 9:
             pen.strike = true;
-            setpenattr_bool(Attr::Strike, true);
+            pen_changed |= AttrMask::Strike;
             break;
 
         case 10: case 11: case 12: case 13: case 14:
         case 15: case 16: case 17: case 18: case 19:
             pen.font = static_cast<int32_t>(arg - 10);
-            setpenattr_int(Attr::Font, pen.font);
+            pen_changed |= AttrMask::Font;
             break;
 
         case 21:
             pen.underline = Underline::Double;
-            setpenattr_int(Attr::Underline, to_underlying(pen.underline));
+            pen_changed |= AttrMask::Underline;
             break;
 
         case 22:
             pen.bold = false;
-            setpenattr_bool(Attr::Bold, false);
+            pen_changed |= AttrMask::Bold;
             break;
 
         case 23:
             pen.italic = false;
-            setpenattr_bool(Attr::Italic, false);
+            pen_changed |= AttrMask::Italic;
             break;
 
         case 24:
             pen.underline = Underline::Off;
-            setpenattr_int(Attr::Underline, to_underlying(pen.underline));
+            pen_changed |= AttrMask::Underline;
             break;
 
         case 25:
             pen.blink = false;
-            setpenattr_bool(Attr::Blink, false);
+            pen_changed |= AttrMask::Blink;
             break;
 
         case 27:
             pen.reverse = false;
-            setpenattr_bool(Attr::Reverse, false);
+            pen_changed |= AttrMask::Reverse;
             break;
 
         case 28:
             pen.conceal = false;
-            setpenattr_bool(Attr::Conceal, false);
+            pen_changed |= AttrMask::Conceal;
             break;
 
         case 29:
             pen.strike = false;
-            setpenattr_bool(Attr::Strike, false);
+            pen_changed |= AttrMask::Strike;
             break;
 
         case 30: case 31: case 32: case 33:
@@ -318,13 +327,14 @@ void State::Impl::setpen(std::span<const int64_t> args) {
 
         case 38:
         case 48: {
-            if(argcount - argi < 2)
-                return;
+            if(argcount - argi < 2) {
+                argi = argcount;
+                break;
+            }
             bool is_bg = (arg == 48);
             Color& colref = is_bg ? pen.bg : pen.fg;
-            Attr attr = is_bg ? Attr::Background : Attr::Foreground;
             argi += 1 + lookup_colour(csi_arg(args[argi+1]), args.subspan(argi+2), colref);
-            setpenattr_col(attr, colref);
+            pen_changed |= is_bg ? AttrMask::Background : AttrMask::Foreground;
             break;
         }
 
@@ -333,7 +343,7 @@ void State::Impl::setpen(std::span<const int64_t> args) {
             bool is_bg = (arg == 49);
             Color& colref = is_bg ? pen.bg : pen.fg;
             colref = is_bg ? default_bg : default_fg;
-            setpenattr_col(is_bg ? Attr::Background : Attr::Foreground, colref);
+            pen_changed |= is_bg ? AttrMask::Background : AttrMask::Foreground;
             break;
         }
 
@@ -343,8 +353,7 @@ void State::Impl::setpen(std::span<const int64_t> args) {
                 (arg == 73) ? Baseline::Raise :
                 (arg == 74) ? Baseline::Lower :
                               Baseline::Normal;
-            setpenattr_bool(Attr::Small,    pen.small);
-            setpenattr_int (Attr::Baseline, to_underlying(pen.baseline));
+            pen_changed |= AttrMask::Small | AttrMask::Baseline;
             break;
 
         case 90: case 91: case 92: case 93:
@@ -367,6 +376,8 @@ void State::Impl::setpen(std::span<const int64_t> args) {
         if(argi < argcount)
             argi++;
     }
+
+    flush_pen();
 }
 
 int32_t State::Impl::getpen(std::span<int64_t> args) {
@@ -436,22 +447,7 @@ void State::set_bold_highbright(bool enabled) {
 }
 
 bool State::get_penattr(Attr attr, Value& val) const {
-    switch(attr) {
-    case Attr::Bold:       val.boolean = impl_->pen.bold;      return true;
-    case Attr::Underline:  val.number  = to_underlying(impl_->pen.underline); return true;
-    case Attr::Italic:     val.boolean = impl_->pen.italic;    return true;
-    case Attr::Blink:      val.boolean = impl_->pen.blink;     return true;
-    case Attr::Reverse:    val.boolean = impl_->pen.reverse;   return true;
-    case Attr::Conceal:    val.boolean = impl_->pen.conceal;   return true;
-    case Attr::Strike:     val.boolean = impl_->pen.strike;    return true;
-    case Attr::Font:       val.number  = impl_->pen.font;      return true;
-    case Attr::Foreground: val.color   = impl_->pen.fg;        return true;
-    case Attr::Background: val.color   = impl_->pen.bg;        return true;
-    case Attr::Small:      val.boolean = impl_->pen.small;     return true;
-    case Attr::Baseline:   val.number  = to_underlying(impl_->pen.baseline);  return true;
-    case Attr::NAttrs:     return false;
-    }
-    return false;
+    return impl_->get_penattr(attr, val);
 }
 
 } // namespace vterm
@@ -2,11 +2,19 @@
 #include "utf8.h"
 
 #include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
 #include <concepts>
 #include <cstdlib>
 #include <iostream>
 #include <limits>
+#include <memory_resource>
+#include <numeric>
+#include <optional>
 #include <type_traits>
+#include <unordered_map>
+#include <utility>
 
 #undef DEBUG_REFLOW
 
@@ -15,7 +23,7 @@ namespace {
 
 constexpr uint32_t unicode_space    = 0x20;
 constexpr uint32_t unicode_linefeed = 0x0a;
-constexpr uint32_t widechar_continuation = std::numeric_limits<uint32_t>::max();
+constexpr uint32_t widechar_continuation = glyph_continuation;
 constexpr int32_t  initial_logical_segments = 4;
 
 // --- Internal types ---
@@ -39,12 +47,351 @@ struct ScreenPen {
     uint32_t protected_cell : 1 = 0;
     uint32_t dwl            : 1 = 0; // on a DECDWL or DECDHL line
     uint32_t dhl            : 2 = 0; // on a DECDHL line (1=top 2=bottom)
+
+    constexpr bool operator==(const ScreenPen&) const = default;
 };
 
-// Internal representation of a screen cell
+using PenId = uint16_t;
+
+// Internal representation of a screen cell. `glyph` is a single codepoint,
+// 0 when erased, widechar_continuation, or glyph_cluster_flag | id into the
+// screen's ClusterTable; the pen lives in its PenTable.
 struct InternalScreenCell {
-    std::array<uint32_t, max_chars_per_cell> chars{};
-    ScreenPen pen;
+    uint32_t glyph = 0;
+    PenId pen_id = 0;
+};
+
+// Columns of a row up to and including its last non-blank cell, and whether
+// every glyph before that is ASCII. `ascii` may be false when it need not be.
+// A full-width erase only sets `blank`: every cell of the row is then
+// `blank_cell`, and the row's cells in the buffer are stale until written.
+struct RowExtent {
+    int32_t end = 0;
+    bool ascii = true;
+    bool blank = false;
+    InternalScreenCell blank_cell{};
+};
+
+// Rows of the buffer Screen::Impl::resize_buffer() is building, by screen
+// row. `index` maps them to physical rows; null when they are the same.
+struct ResizeRows {
+    std::vector<InternalScreenCell>& buffer;
+    std::vector<RowExtent>& extents;
+    std::pmr::vector<LineInfo>& lineinfo;
+    const std::vector<int32_t>* index = nullptr;
+    int32_t cols = 0;
+
+    [[nodiscard]] int32_t physical(int32_t row) const { return index ? (*index)[row] : row; }
+    [[nodiscard]] InternalScreenCell* cells(int32_t row) {
+        return buffer.data() + static_cast<ptrdiff_t>(physical(row)) * cols;
+    }
+    [[nodiscard]] RowExtent& extent(int32_t row) { return extents[physical(row)]; }
+
+    // Extends the extent of `row` over a cell just placed at `col`
+    void note_cell(int32_t row, int32_t col, uint32_t glyph) {
+        if(!glyph)
+            return;
+        RowExtent& ext = extent(row);
+        ext.end = col + 1;
+        ext.ascii = ext.ascii && glyph < utf8_max_1byte;
+    }
+};
+
+// Scratch memory for the temporaries of one resize. Each resize starts with
+// the arena empty; one that spilled past it makes the next get a bigger
+// buffer, so once warmed up a resize allocates nothing here.
+class ResizeArena {
+public:
+    [[nodiscard]] std::pmr::memory_resource* start() {
+        arena.reset();
+        if(spill.bytes > 0) {
+            buffer.resize(buffer.size() + spill.bytes);
+            spill.bytes = 0;
+        }
+        if(buffer.empty())
+            arena.emplace(&spill);
+        else
+            arena.emplace(buffer.data(), buffer.size(), &spill);
+        return &*arena;
+    }
+
+private:
+    // Heap memory the arena falls back on, counted
+    struct Spill final : std::pmr::memory_resource {
+        size_t bytes = 0;
+
+        void* do_allocate(size_t size, size_t align) override {
+            bytes += size;
+            return std::pmr::new_delete_resource()->allocate(size, align);
+        }
+        void do_deallocate(void* p, size_t size, size_t align) override {
+            std::pmr::new_delete_resource()->deallocate(p, size, align);
+        }
+        [[nodiscard]] bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+            return this == &other;
+        }
+    };
+
+    std::vector<std::byte> buffer;
+    Spill spill;
+    std::optional<std::pmr::monotonic_buffer_resource> arena;
+};
+
+// The fields Color::operator== looks at, packed into one word
+[[nodiscard]] constexpr uint32_t color_key(const Color& col) {
+    if(col.is_indexed())
+        return col.type | (static_cast<uint32_t>(col.indexed.idx) << 8);
+    return col.type | (static_cast<uint32_t>(col.rgb.red) << 8) |
+           (static_cast<uint32_t>(col.rgb.green) << 16) | (static_cast<uint32_t>(col.rgb.blue) << 24);
+}
+
+struct ScreenPenHash {
+    size_t operator()(const ScreenPen& pen) const noexcept {
+        uint64_t bits = pen.bold | (static_cast<uint64_t>(to_underlying(pen.underline)) << 1) |
+                        (pen.italic << 3) | (pen.blink << 4) | (pen.reverse << 5) |
+                        (pen.conceal << 6) | (pen.strike << 7) | (pen.font << 8) |
+                        (pen.small << 12) | (static_cast<uint64_t>(to_underlying(pen.baseline)) << 13) |
+                        (pen.protected_cell << 15) | (pen.dwl << 16) | (pen.dhl << 17);
+        uint64_t colors = color_key(pen.fg) | (static_cast<uint64_t>(color_key(pen.bg)) << 32);
+        return std::hash<uint64_t>{}(colors ^ (bits * 0x9E3779B97F4A7C15ull));
+    }
+};
+
+// Distinct pens used on a screen, shared by all its cells. Cells refer to
+// them by id; unreferenced entries are dropped by Screen::Impl::compact_pens()
+struct PenTable {
+    static constexpr size_t max_pens = std::numeric_limits<PenId>::max() + size_t{1};
+
+    std::vector<ScreenPen> pens;
+    std::unordered_map<ScreenPen, PenId, ScreenPenHash> ids;
+
+    [[nodiscard]] const ScreenPen& operator[](PenId id) const { return pens[id]; }
+
+    [[nodiscard]] PenId intern(const ScreenPen& pen) {
+        if(auto it = ids.find(pen); it != ids.end())
+            return it->second;
+        // Only reachable if one resize introduces ~64k new pens before the
+        // table can be compacted; fall back to the oldest pen
+        if(pens.size() == max_pens)
+            return 0;
+        auto id = static_cast<PenId>(pens.size());
+        pens.push_back(pen);
+        ids.emplace(pen, id);
+        return id;
+    }
+
+    void rebuild_ids() {
+        ids.clear();
+        for(size_t id = 0; id < pens.size(); id++)
+            ids.emplace(pens[id], static_cast<PenId>(id));
+    }
+};
+
+// Compact the pen table once it grows past this many entries
+inline constexpr size_t pen_compact_min = 1024;
+
+// Multi-codepoint glyphs (base + combining chars) used on a screen, stored
+// once and referred to from cells by id
+struct ClusterTable {
+    struct Hash {
+        using is_transparent = void;
+        size_t operator()(std::span<const uint32_t> cluster) const noexcept {
+            uint64_t h = 0xcbf29ce484222325ull;
+            for(uint32_t c : cluster)
+                h = (h ^ c) * 0x100000001b3ull;
+            return h;
+        }
+    };
+    struct Equal {
+        using is_transparent = void;
+        bool operator()(std::span<const uint32_t> a, std::span<const uint32_t> b) const noexcept {
+            return std::ranges::equal(a, b);
+        }
+    };
+
+    // Ids stay clear of widechar_continuation
+    static constexpr size_t max_clusters = glyph_continuation & ~glyph_cluster_flag;
+
+    std::unordered_map<std::vector<uint32_t>, uint32_t, Hash, Equal> ids;
+    std::vector<const std::vector<uint32_t>*> clusters; // keys of ids, by id
+
+    [[nodiscard]] std::span<const uint32_t> operator[](uint32_t glyph) const {
+        return *clusters[glyph & ~glyph_cluster_flag];
+    }
+
+    [[nodiscard]] uint32_t intern(std::span<const uint32_t> cluster) {
+        if(auto it = ids.find(cluster); it != ids.end())
+            return glyph_cluster_flag | it->second;
+        if(clusters.size() == max_clusters)
+            return cluster[0];
+        auto id = static_cast<uint32_t>(clusters.size());
+        auto [it, _] = ids.emplace(std::vector<uint32_t>(cluster.begin(), cluster.end()), id);
+        clusters.push_back(&it->first);
+        return glyph_cluster_flag | id;
+    }
+};
+
+// Compact the cluster table once it grows past this many entries
+inline constexpr size_t cluster_compact_min = 256;
+
+// Longest cluster kept in a cell; State already caps glyphs from a single
+// write at max_chars_per_cell, only split combining sequences grow past it
+inline constexpr size_t max_cluster_chars = 32;
+
+[[nodiscard]] constexpr bool is_cluster(uint32_t glyph) {
+    return (glyph & glyph_cluster_flag) && glyph != widechar_continuation;
+}
+
+// Most rects DamageSize::Region holds before it merges the cheapest pair
+inline constexpr size_t damage_region_max = 16;
+
+// Wasted cells a renderer would rather repaint than draw one more rect
+inline constexpr int64_t damage_rect_cost = 16;
+
+// Default budget for one DEC mode 2026 frame before it is released anyway
+inline constexpr size_t sync_output_max_bytes = 1024 * 1024;
+inline constexpr std::chrono::milliseconds sync_output_timeout{150};
+
+// Moves damage recorded before a scroll of `rect` to where its cells are now
+constexpr void scroll_damage(Rect& damaged, Rect rect, int32_t downward, int32_t rightward) {
+    if(rect.contains_rect(damaged)) {
+        // Scroll region entirely contains the damage; just move it
+        damaged.move(-downward, -rightward);
+        damaged.clip(rect);
+    }
+    // Common case: vertical scroll that neatly cuts the damage region in half
+    else if(rect.start_col <= damaged.start_col &&
+            rect.end_col   >= damaged.end_col &&
+            rightward == 0) {
+        if(damaged.start_row >= rect.start_row &&
+           damaged.start_row  < rect.end_row) {
+            damaged.start_row -= downward;
+            if(damaged.start_row < rect.start_row)
+                damaged.start_row = rect.start_row;
+            if(damaged.start_row > rect.end_row)
+                damaged.start_row = rect.end_row;
+        }
+        if(damaged.end_row > rect.start_row &&
+           damaged.end_row < rect.end_row) {
+            damaged.end_row -= downward;
+            if(damaged.end_row < rect.start_row)
+                damaged.end_row = rect.start_row;
+            if(damaged.end_row > rect.end_row)
+                damaged.end_row = rect.end_row;
+        }
+    }
+    else {
+        damaged.expand(rect);
+    }
+}
+
+[[nodiscard]] constexpr int64_t rect_area(const Rect& rect) {
+    return int64_t{rect.end_row - rect.start_row} * (rect.end_col - rect.start_col);
+}
+
+// Cells repainted needlessly if `a` and `b` were replaced by their bounding box
+[[nodiscard]] constexpr int64_t merge_waste(const Rect& a, const Rect& b) {
+    Rect both = a;
+    both.expand(b);
+    Rect overlap = a;
+    overlap.clip(b);
+    return rect_area(both) - rect_area(a) - rect_area(b) + rect_area(overlap);
+}
+
+// Disjoint damage rects for DamageSize::Region
+struct DamageRegion {
+    std::array<Rect, damage_region_max> rects{};
+    size_t count = 0;
+    bool newest_grown = false;  // rects[count - 1] grew without being merged
+
+    void add(Rect rect) {
+        if(rect.start_row >= rect.end_row || rect.start_col >= rect.end_col)
+            return;
+
+        // Fast path: text runs continue the newest rect, which is kept last
+        if(count) {
+            Rect& newest = rects[count - 1];
+            if(newest.contains_rect(rect))
+                return;
+            if(rect.start_row == newest.start_row && rect.end_row == newest.end_row &&
+               rect.start_col <= newest.end_col && rect.end_col >= newest.start_col) {
+                Rect grown = newest;
+                grown.expand(rect);
+                if(std::none_of(rects.begin(), rects.begin() + static_cast<std::ptrdiff_t>(count - 1),
+                                [&](const Rect& other) { return other.intersects(grown); })) {
+                    newest = grown;
+                    newest_grown = true;
+                    return;
+                }
+            }
+        }
+
+        // A new rect starts; settle the one the fast path grew first
+        if(newest_grown) {
+            newest_grown = false;
+            merge(rects[--count]);
+        }
+        merge(rect);
+    }
+
+    void clear() {
+        count = 0;
+        newest_grown = false;
+    }
+
+    [[nodiscard]] std::span<const Rect> sorted() {
+        std::sort(rects.begin(), rects.begin() + static_cast<std::ptrdiff_t>(count),
+                  [](const Rect& a, const Rect& b) {
+                      return a.start_row != b.start_row ? a.start_row < b.start_row
+                                                        : a.start_col < b.start_col;
+                  });
+        return {rects.data(), count};
+    }
+
+private:
+    void merge(Rect rect) {
+        // Absorb everything overlapping or cheap to join; the growing rect may
+        // reach further ones, so rescan after each merge
+        for(size_t i = 0; i < count; ) {
+            if(rects[i].contains_rect(rect))
+                return;
+            if(rects[i].intersects(rect) || merge_waste(rects[i], rect) <= damage_rect_cost) {
+                rect.expand(rects[i]);
+                rects[i] = rects[--count];
+                i = 0;
+            }
+            else
+                i++;
+        }
+
+        if(count < damage_region_max) {
+            rects[count++] = rect;
+            return;
+        }
+
+        // Full: join the pair, new rect included, that wastes the fewest cells
+        size_t best_a = 0, best_b = count;
+        int64_t best = std::numeric_limits<int64_t>::max();
+        for(size_t a = 0; a < count; a++)
+            for(size_t b = a + 1; b <= count; b++) {
+                int64_t waste = merge_waste(rects[a], b == count ? rect : rects[b]);
+                if(waste < best) {
+                    best = waste;
+                    best_a = a;
+                    best_b = b;
+                }
+            }
+
+        Rect joined = rects[best_a];
+        if(best_b == count)
+            joined.expand(rect);
+        else {
+            joined.expand(rects[best_b]);
+            rects[best_b] = rect;
+        }
+        rects[best_a] = rects[--count];
+        merge(joined);
+    }
 };
 
 } // anonymous namespace
@@ -67,12 +414,59 @@ struct Screen::Impl {
     Rect pending_scrollrect;
     int32_t  pending_scroll_downward  = 0;
     int32_t  pending_scroll_rightward = 0;
+    DamageRegion damage_region;
+
+    // Terminal::begin_batch() nesting. While open, damage goes to
+    // damage_region, one net scroll is held in pending_scrollrect, and cursor
+    // moves and termprops are kept here until end_batch()
+    int32_t batch_depth = 0;
+    struct {
+        bool cursor_moved = false;
+        Pos cursor_oldpos{};
+        Pos cursor_pos{};
+        bool cursor_visible = false;
+        std::array<bool, static_cast<size_t>(Prop::NProps)> props_set{};
+        std::array<Value, static_cast<size_t>(Prop::NProps)> props{};
+    } batch;
+
+    // DEC mode 2026 holds one batch level while set, released on reset or
+    // once the frame runs past its byte or time budget
+    bool sync_held = false;
+    size_t sync_bytes = 0;
+    std::chrono::steady_clock::time_point sync_start{};
+    size_t sync_max_bytes = sync_output_max_bytes;
+    std::chrono::milliseconds sync_timeout = sync_output_timeout;
+
+    // Scrolls are held back rather than emitted as they happen
+    [[nodiscard]] bool scroll_deferred() const {
+        return batch_depth > 0 || damage_merge == DamageSize::Scroll;
+    }
+
+    // Pull-based damage for collect_dirty_rows(). Changed rows are stamped
+    // with the open generation and flagged in dirty_bits; collecting closes
+    // the generation.
+    uint64_t generation = 1;
+    std::vector<uint64_t> row_generation;
+    std::vector<uint64_t> dirty_bits;
+    // Like row_generation, but by physical row of the active buffer: only
+    // changes to a row's cells count, not scrolls that rotate the row index
+    std::vector<uint64_t> content_generation;
+
+    // Rows handed out by snapshot(), by physical row; rewritten in place once
+    // no snapshot refers to them any more
+    std::vector<std::shared_ptr<std::vector<ScreenCell>>> snapshot_rows;
+    // Replaced rows an older snapshot may still hold, reused once released
+    std::vector<std::shared_ptr<std::vector<ScreenCell>>> snapshot_retired;
+    uint64_t snapshot_generation = 0;
+    std::array<Color, palette_ansi_count> snapshot_colors{};
+    std::shared_ptr<const std::array<Color, palette_max>> snapshot_palette;
 
     int32_t rows = 0;
     int32_t cols = 0;
 
     uint32_t global_reverse : 1 = 0;
     uint32_t reflow         : 1 = 0;
+    uint32_t direct_scrollback : 1 = 0;
 
     // Primary and Altscreen. buffers[1] is lazily allocated as needed
     std::array<std::vector<InternalScreenCell>, 2> buffers{};
@@ -80,11 +474,41 @@ struct Screen::Impl {
     // buffer_idx selects buffers[0] or buffers[1], depending on altscreen
     int32_t buffer_idx = 0;
 
+    // Physical row of buffers[i] that holds each screen row. Full-width
+    // vertical scrolls rotate these rather than moving cells.
+    std::array<std::vector<int32_t>, 2> row_index{};
+
+    // Extent of each physical row of buffers[i], kept up to date by every
+    // write so nothing has to scan for the end of a row
+    std::array<std::vector<RowExtent>, 2> row_extents{};
+
+    // Storage a resize builds the new buffer in, swapped with the old one
+    // afterwards, and scratch for its temporaries
+    std::vector<InternalScreenCell> spare_buffer;
+    std::vector<RowExtent> spare_extents;
+    ResizeArena resize_arena;
+    std::pmr::memory_resource* resize_scratch = nullptr;
+
     // buffer for a single screen row used in scrollback storage callbacks
     std::vector<ScreenCell> sb_buffer;
+    // Rows sb_pushlines_from_rows() hands over as one block, reused
+    std::vector<ScreenCell> sb_block;
+    std::vector<PushedLine> sb_lines;
+    // ASCII row write_direct() is building for scrollback, 0 for blank
+    std::string direct_line;
+
+    // UTF-8 text of the run get_row_runs() is building
+    std::string run_text;
 
     ScreenPen pen{};
 
+    PenTable pens;
+    PenId pen_id = 0; // pens.intern(pen)
+    size_t pen_compact_at = pen_compact_min;
+
+    ClusterTable clusters;
+    size_t cluster_compact_at = cluster_compact_min;
+
     // The StateCallbacks subclass instance
     std::unique_ptr<StateCallbacks> state_cbs;
 
@@ -93,17 +517,48 @@ struct Screen::Impl {
     [[nodiscard]] InternalScreenCell* getcell(int32_t row, int32_t col);
     [[nodiscard]] const InternalScreenCell* getcell(int32_t row, int32_t col) const;
     [[nodiscard]] std::vector<InternalScreenCell> alloc_buffer(int32_t rows, int32_t cols);
+    void reset_row_index(int32_t bufidx, int32_t rows);
+    [[nodiscard]] RowExtent& row_extent(int32_t row) {
+        return row_extents[buffer_idx][row_index[buffer_idx][row]];
+    }
+    [[nodiscard]] const RowExtent& row_extent(int32_t row) const {
+        return row_extents[buffer_idx][row_index[buffer_idx][row]];
+    }
+    void materialize_rows(int32_t bufidx);
+    void update_extent(int32_t row, int32_t start_col, int32_t end_col);
     [[nodiscard]] bool get_cell_impl(Pos pos, ScreenCell& cell) const;
+    [[nodiscard]] bool get_row_runs(int32_t row, RunSink& sink);
     [[nodiscard]] bool moverect_internal(Rect dest, Rect src);
     [[nodiscard]] bool erase_internal(Rect rect, bool selective);
     [[nodiscard]] bool moverect_user(Rect dest, Rect src);
     [[nodiscard]] bool erase_user(Rect rect, bool selective);
     void flush_damage_impl();
+    void end_batch();
+    void begin_sync();
+    void end_sync();
+    void check_sync_budget();
     void damagerect(Rect rect);
     void damagescreen();
-    void sb_pushline_from_row(int32_t row, bool continuation);
+    void mark_moved(int32_t start_row, int32_t end_row);
+    void mark_dirty(int32_t start_row, int32_t end_row);
+    void mark_all_dirty();
+    void reset_dirty_rows();
+    [[nodiscard]] Screen::DirtyRows collect_dirty_rows(uint64_t since_generation, std::span<int32_t> out);
+    [[nodiscard]] ScreenSnapshot snapshot();
+    void sb_pushlines_from_rows(int32_t nrows, std::span<const LineInfo> lineinfos);
+    void sb_pushlines(std::span<const PushedLine> lines);
+    [[nodiscard]] bool direct_scroll_ready() const;
+    [[nodiscard]] size_t write_direct(std::span<const char> data, size_t& parse);
+    [[nodiscard]] PenId erase_pen_id(const LineInfo& info);
     void resize_buffer(int32_t bufidx, int32_t new_rows, int32_t new_cols, bool active, StateFields& statefields);
-    void reset_default_colours(std::span<InternalScreenCell> buf);
+    [[nodiscard]] bool resize_rows_in_place(int32_t bufidx, int32_t new_rows, bool active, StateFields& statefields);
+    void backfill_rows(int32_t bufidx, ResizeRows& out, int32_t& new_row, int32_t old_cols, bool active, StateFields& statefields);
+    void reset_default_colours();
+    void update_pen_id();
+    void compact_pens();
+    [[nodiscard]] PenId pen_id_with(uint32_t protected_cell, uint32_t dwl, uint32_t dhl);
+    [[nodiscard]] uint32_t intern_glyph(std::span<const uint32_t> chars);
+    void compact_clusters();
     template<typename T>
         requires (std::same_as<T, char> || std::same_as<T, uint32_t>)
     size_t get_chars_impl(std::span<T> buf, Rect rect) const;
@@ -119,27 +574,70 @@ Terminal::Impl::~Impl() {
     state.reset();
 }
 
+// --- Terminal batching (needs complete Screen::Impl) ---
+
+void Terminal::begin_batch() {
+    if(impl_->screen)
+        impl_->screen->batch_depth++;
+}
+
+void Terminal::end_batch() {
+    if(impl_->screen)
+        impl_->screen->end_batch();
+}
+
+void Terminal::Impl::sync_output_wrote(size_t bytes) {
+    if(!screen || !screen->sync_held)
+        return;
+    screen->sync_bytes += bytes;
+    screen->check_sync_budget();
+}
+
 // --- Helpers ---
 
 void Screen::Impl::clearcell(InternalScreenCell& cell) const {
-    cell.chars[0] = 0;
-    cell.pen = pen;
+    cell.glyph = 0;
+    cell.pen_id = pen_id;
 }
 
+// For writing: a blank row gets its cells filled in first
 InternalScreenCell* Screen::Impl::getcell(int32_t row, int32_t col) {
     if(row < 0 || row >= rows)
         return nullptr;
     if(col < 0 || col >= cols)
         return nullptr;
-    return &buffers[buffer_idx][cols * row + col];
+    InternalScreenCell* cells = &buffers[buffer_idx][cols * row_index[buffer_idx][row]];
+    RowExtent& extent = row_extent(row);
+    if(extent.blank) {
+        std::fill_n(cells, cols, extent.blank_cell);
+        extent.blank = false;
+    }
+    return cells + col;
 }
 
+// For reading: every cell of a blank row is its blank_cell, so step along
+// the row by calling this per cell, not by pointer
 const InternalScreenCell* Screen::Impl::getcell(int32_t row, int32_t col) const {
     if(row < 0 || row >= rows)
         return nullptr;
     if(col < 0 || col >= cols)
         return nullptr;
-    return &buffers[buffer_idx][cols * row + col];
+    const RowExtent& extent = row_extent(row);
+    if(extent.blank)
+        return &extent.blank_cell;
+    return &buffers[buffer_idx][cols * row_index[buffer_idx][row] + col];
+}
+
+// Fills in every blank row of buffers[bufidx], for code that walks the
+// buffer directly
+void Screen::Impl::materialize_rows(int32_t bufidx) {
+    auto& extents = row_extents[bufidx];
+    for(size_t row = 0; row < extents.size(); row++) {
+        if(!extents[row].blank)
+            continue;
+        std::fill_n(buffers[bufidx].begin() + static_cast<ptrdiff_t>(row) * cols, cols, extents[row].blank_cell);
+        extents[row].blank = false;
+    }
 }
 
 std::vector<InternalScreenCell> Screen::Impl::alloc_buffer(int32_t rows, int32_t cols) {
@@ -151,24 +649,85 @@ std::vector<InternalScreenCell> Screen::Impl::alloc_buffer(int32_t rows, int32_t
     return new_buffer;
 }
 
+void Screen::Impl::reset_row_index(int32_t bufidx, int32_t rows) {
+    row_index[bufidx].resize(rows);
+    std::iota(row_index[bufidx].begin(), row_index[bufidx].end(), 0);
+}
+
+// Cells [start_col, end_col) of `row` were just rewritten
+void Screen::Impl::update_extent(int32_t row, int32_t start_col, int32_t end_col) {
+    if(row < 0 || row >= rows)
+        return;
+    start_col = std::max(start_col, 0);
+    end_col = std::min(end_col, cols);
+
+    RowExtent& extent = row_extent(row);
+    const InternalScreenCell* cells = getcell(row, 0);
+
+    int32_t last = 0;
+    bool ascii = true;
+    for(int32_t col = start_col; col < end_col; col++) {
+        if(cells[col].glyph) {
+            last = col + 1;
+            ascii = ascii && cells[col].glyph < utf8_max_1byte;
+        }
+    }
+
+    if(last || end_col < extent.end) {
+        // Anything past the written cells is as it was
+        extent.end = std::max(last, end_col < extent.end ? extent.end : 0);
+        extent.ascii = extent.ascii && ascii;
+        return;
+    }
+
+    // The row now ends somewhere before the written cells
+    int32_t end = std::min(start_col, extent.end);
+    while(end > 0 && cells[end - 1].glyph == 0)
+        end--;
+    extent.end = end;
+    if(end == 0)
+        extent.ascii = true;
+}
+
 namespace {
 
+// Take every drawing attribute from the state's pen, keeping the
+// screen-only bits (protection, line size) as they are.
+constexpr void assign_pen(ScreenPen& dst, const Pen& src) {
+    dst.fg        = src.fg;
+    dst.bg        = src.bg;
+    dst.bold      = src.bold;
+    dst.underline = src.underline;
+    dst.italic    = src.italic;
+    dst.blink     = src.blink;
+    dst.reverse   = src.reverse;
+    dst.conceal   = src.conceal;
+    dst.strike    = src.strike;
+    dst.font      = src.font;
+    dst.small     = src.small;
+    dst.baseline  = src.baseline;
+}
+
 // Copy pen attributes from internal ScreenPen to external ScreenCell.
 // The global_reverse flag is XORed into .reverse on the way out.
+constexpr void pen_to_attrs(const ScreenPen& pen, CellAttrs& attrs, uint32_t global_reverse) {
+    attrs.bold      = pen.bold;
+    attrs.underline = pen.underline;
+    attrs.italic    = pen.italic;
+    attrs.blink     = pen.blink;
+    attrs.reverse   = pen.reverse ^ global_reverse;
+    attrs.conceal   = pen.conceal;
+    attrs.strike    = pen.strike;
+    attrs.font      = pen.font;
+    attrs.small     = pen.small;
+    attrs.baseline  = pen.baseline;
+
+    attrs.dwl = pen.dwl;
+    attrs.dhl = pen.dhl;
+}
+
 constexpr void pen_to_cell_attrs(const ScreenPen& pen, ScreenCell& cell, uint32_t global_reverse) {
-    cell.attrs.bold      = pen.bold;
-    cell.attrs.underline = pen.underline;
-    cell.attrs.italic    = pen.italic;
-    cell.attrs.blink     = pen.blink;
-    cell.attrs.reverse   = pen.reverse ^ global_reverse;
-    cell.attrs.conceal   = pen.conceal;
-    cell.attrs.strike    = pen.strike;
-    cell.attrs.font      = pen.font;
-    cell.attrs.small     = pen.small;
-    cell.attrs.baseline  = pen.baseline;
-
-    cell.attrs.dwl = pen.dwl;
-    cell.attrs.dhl = pen.dhl;
+    pen_to_attrs(pen, cell.attrs, global_reverse);
 
     cell.fg = pen.fg;
     cell.bg = pen.bg;
@@ -200,12 +759,19 @@ bool Screen::Impl::get_cell_impl(Pos pos, ScreenCell& cell) const {
     if(!intcell)
         return false;
 
-    cell.chars = intcell->chars;
+    cell.chars = {};
+    if(is_cluster(intcell->glyph)) {
+        std::span<const uint32_t> cluster = clusters[intcell->glyph];
+        std::copy_n(cluster.begin(), std::min(cluster.size(), cell.chars.size()), cell.chars.begin());
+    }
+    else {
+        cell.chars[0] = intcell->glyph;
+    }
 
-    pen_to_cell_attrs(intcell->pen, cell, global_reverse);
+    pen_to_cell_attrs(pens[intcell->pen_id], cell, global_reverse);
 
     const InternalScreenCell* nextcell = (pos.col < (cols - 1)) ? getcell(pos.row, pos.col + 1) : nullptr;
-    if(nextcell && nextcell->chars[0] == widechar_continuation)
+    if(nextcell && nextcell->glyph == widechar_continuation)
         cell.width = 2;
     else
         cell.width = 1;
@@ -216,10 +782,16 @@ bool Screen::Impl::get_cell_impl(Pos pos, ScreenCell& cell) const {
 // Internal flush_damage operating on Screen::Impl
 void Screen::Impl::flush_damage_impl() {
     if(pending_scrollrect.start_row != no_damage_row) {
-        scroll_rect(pending_scrollrect,
-            pending_scroll_downward, pending_scroll_rightward,
-            [this](Rect dest, Rect src) -> bool { return moverect_user(dest, src); },
-            [this](Rect r, bool selective) -> bool { return erase_user(r, selective); });
+        if(pending_scroll_downward == 0 && pending_scroll_rightward == 0) {
+            // Scrolls that cancelled out still erased cells along the way
+            damagerect(pending_scrollrect);
+        }
+        else {
+            scroll_rect(pending_scrollrect,
+                pending_scroll_downward, pending_scroll_rightward,
+                [this](Rect dest, Rect src) -> bool { return moverect_user(dest, src); },
+                [this](Rect r, bool selective) -> bool { return erase_user(r, selective); });
+        }
 
         pending_scrollrect.start_row = no_damage_row;
     }
@@ -230,6 +802,15 @@ void Screen::Impl::flush_damage_impl() {
 
         damaged.start_row = no_damage_row;
     }
+
+    if(damage_region.count) {
+        auto rects = damage_region.sorted();
+        if(callbacks && !callbacks->on_damage_batch(rects))
+            for(const Rect& rect : rects)
+                callbacks->on_damage(rect);
+
+        damage_region.clear();
+    }
 }
 
 // --- Damage ---
@@ -237,6 +818,12 @@ void Screen::Impl::flush_damage_impl() {
 void Screen::Impl::damagerect(Rect rect) {
     Rect emit{};
 
+    if(batch_depth > 0) {
+        // Held until end_batch()
+        damage_region.add(rect);
+        return;
+    }
+
     switch(damage_merge) {
     case DamageSize::Cell:
         // Always emit damage event
@@ -281,6 +868,11 @@ void Screen::Impl::damagerect(Rect rect) {
         }
         return;
 
+    case DamageSize::Region:
+        // Held until flush_damage()
+        damage_region.add(rect);
+        return;
+
     default:
         DEBUG_LOG("TODO: Maybe merge damage for level {}\n", to_underlying(damage_merge));
         return;
@@ -294,19 +886,449 @@ void Screen::Impl::damagescreen() {
     damagerect({.start_row = 0, .end_row = rows, .start_col = 0, .end_col = cols});
 }
 
+void Screen::Impl::end_batch() {
+    if(batch_depth == 0 || --batch_depth > 0)
+        return;
+
+    // Still batching while the held scroll goes out, so a moverect the
+    // callbacks decline becomes damage in the same flush
+    batch_depth = 1;
+    flush_damage_impl();
+    batch_depth = 0;
+
+    for(size_t i = 0; i < batch.props.size(); i++) {
+        if(batch.props_set[i] && callbacks)
+            callbacks->on_settermprop(static_cast<Prop>(i), batch.props[i]);
+    }
+
+    if(batch.cursor_moved && callbacks)
+        callbacks->on_movecursor(batch.cursor_pos, batch.cursor_oldpos, batch.cursor_visible);
+
+    batch = {};
+}
+
+void Screen::Impl::begin_sync() {
+    if(sync_held)
+        return;
+    sync_held = true;
+    sync_bytes = 0;
+    sync_start = std::chrono::steady_clock::now();
+    batch_depth++;
+}
+
+void Screen::Impl::end_sync() {
+    if(!sync_held)
+        return;
+    sync_held = false;
+    end_batch();
+}
+
+// Releases what the frame has drawn so far and keeps holding the rest
+void Screen::Impl::check_sync_budget() {
+    bool over = (sync_max_bytes && sync_bytes >= sync_max_bytes) ||
+                (sync_timeout.count() && std::chrono::steady_clock::now() - sync_start >= sync_timeout);
+    if(!over)
+        return;
+    end_sync();
+    begin_sync();
+}
+
+// --- Dirty rows ---
+
+// Rows now showing other cells, which themselves are unchanged
+void Screen::Impl::mark_moved(int32_t start_row, int32_t end_row) {
+    start_row = std::max(start_row, 0);
+    end_row = std::min(end_row, rows);
+    for(int32_t row = start_row; row < end_row; row++) {
+        row_generation[row] = generation;
+        dirty_bits[row >> 6] |= uint64_t{1} << (row & 63);
+    }
+}
+
+void Screen::Impl::mark_dirty(int32_t start_row, int32_t end_row) {
+    mark_moved(start_row, end_row);
+    const auto& index = row_index[buffer_idx];
+    for(int32_t row = std::max(start_row, 0); row < std::min(end_row, rows); row++)
+        content_generation[index[row]] = generation;
+}
+
+void Screen::Impl::mark_all_dirty() {
+    mark_dirty(0, rows);
+}
+
+void Screen::Impl::reset_dirty_rows() {
+    row_generation.assign(rows, generation);
+    content_generation.assign(rows, generation);
+    dirty_bits.assign((rows + 63) / 64, 0);
+    mark_moved(0, rows);
+}
+
+Screen::DirtyRows Screen::Impl::collect_dirty_rows(uint64_t since_generation, std::span<int32_t> out) {
+    Screen::DirtyRows result{.count = 0, .generation = generation};
+    auto emit = [&](int32_t row) {
+        if(result.count < out.size())
+            out[result.count] = row;
+        result.count++;
+    };
+
+    if(since_generation + 1 == generation) {
+        // Changed since the last collect: exactly the flagged rows
+        for(size_t word = 0; word < dirty_bits.size(); word++)
+            for(uint64_t bits = dirty_bits[word]; bits; bits &= bits - 1)
+                emit(static_cast<int32_t>(word * 64 + std::countr_zero(bits)));
+    }
+    else {
+        for(int32_t row = 0; row < rows; row++)
+            if(row_generation[row] > since_generation)
+                emit(row);
+    }
+
+    std::ranges::fill(dirty_bits, 0);
+    generation++;
+    return result;
+}
+
+// --- Snapshots ---
+
+struct ScreenSnapshot::Impl {
+    int32_t rows = 0;
+    int32_t cols = 0;
+    std::vector<std::shared_ptr<const std::vector<ScreenCell>>> lines;
+    std::vector<LineInfo> lineinfos;
+    std::shared_ptr<const std::array<Color, palette_max>> palette;
+
+    Pos cursor_pos;
+    bool cursor_visible = false;
+    bool cursor_blink = false;
+    CursorShape cursor_shape = CursorShape::Block;
+};
+
+ScreenSnapshot Screen::Impl::snapshot() {
+    auto image = std::make_shared<ScreenSnapshot::Impl>();
+    image->rows = rows;
+    image->cols = cols;
+
+    // Rows no snapshot refers to any more go to the front
+    auto free_end = std::partition(snapshot_retired.begin(), snapshot_retired.end(),
+                                   [](const auto& line) { return line.use_count() == 1; });
+    // Pairs with the release of the last reader's reference
+    std::atomic_thread_fence(std::memory_order_acquire);
+    size_t nfree = static_cast<size_t>(free_end - snapshot_retired.begin());
+
+    // Cached by physical row, so rows a scroll only rotated are still shared
+    const auto& physical = row_index[buffer_idx];
+    snapshot_rows.resize(rows);
+    image->lines.reserve(rows);
+    for(int32_t row = 0; row < rows; row++) {
+        auto& line = snapshot_rows[physical[row]];
+        if(!line || content_generation[physical[row]] > snapshot_generation) {
+            if(line && line.use_count() > 1) {
+                snapshot_retired.push_back(std::move(line));
+                line = nullptr;
+            }
+            else if(line)
+                std::atomic_thread_fence(std::memory_order_acquire);
+            if(!line && nfree > 0)
+                line = std::exchange(snapshot_retired[--nfree], nullptr);
+            else if(!line)
+                line = std::make_shared<std::vector<ScreenCell>>();
+            line->resize(cols);
+            Pos pos{.row = row, .col = 0};
+            for(; pos.col < cols; pos.col++)
+                (void)get_cell_impl(pos, (*line)[pos.col]);
+        }
+        image->lines.push_back(line);
+    }
+
+    std::erase(snapshot_retired, nullptr);
+    // Renderers hold one or two frames; rows pinned longer are let go
+    if(snapshot_retired.size() > static_cast<size_t>(4 * rows))
+        snapshot_retired.erase(snapshot_retired.begin(), snapshot_retired.end() - 4 * rows);
+
+    const auto& lineinfos = state.lineinfos[state.lineinfo_bufidx];
+    image->lineinfos.assign(lineinfos.begin(), lineinfos.begin() + std::min<size_t>(rows, lineinfos.size()));
+    image->lineinfos.resize(rows);
+
+    if(!snapshot_palette || snapshot_colors != state.colors) {
+        auto palette = std::make_shared<std::array<Color, palette_max>>();
+        for(int32_t index = 0; index < palette_max; index++)
+            (void)state.lookup_colour_palette(index, (*palette)[index]);
+        snapshot_palette = std::move(palette);
+        snapshot_colors = state.colors;
+    }
+    image->palette = snapshot_palette;
+
+    image->cursor_pos = state.pos;
+    image->cursor_visible = state.mode.cursor_visible;
+    image->cursor_blink = state.mode.cursor_blink;
+    image->cursor_shape = static_cast<CursorShape>(state.mode.cursor_shape);
+
+    // Later changes are stamped with a newer generation than this snapshot
+    snapshot_generation = generation++;
+
+    ScreenSnapshot result;
+    result.impl_ = std::move(image);
+    return result;
+}
+
 // --- State callback implementations ---
 
-// Copy internal to external representation for pushline
-void Screen::Impl::sb_pushline_from_row(int32_t row, bool continuation) {
-    Pos pos{};
-    pos.row = row;
-    for(pos.col = 0; pos.col < cols; pos.col++)
-        (void)get_cell_impl(pos, sb_buffer[pos.col]);
+// Copy the top `nrows` rows to external representation and push them as one
+// block
+void Screen::Impl::sb_pushlines_from_rows(int32_t nrows, std::span<const LineInfo> lineinfos) {
+    nrows = std::min(nrows, rows);
+    if(nrows <= 0)
+        return;
+
+    sb_block.resize(static_cast<size_t>(nrows) * cols);
+    sb_lines.resize(nrows);
+    for(int32_t row = 0; row < nrows; row++) {
+        std::span<ScreenCell> cells(sb_block.data() + static_cast<size_t>(row) * cols, cols);
+        Pos pos{.row = row, .col = 0};
+        if(row_extent(row).blank) {
+            (void)get_cell_impl(pos, cells[0]);
+            std::fill(cells.begin() + 1, cells.end(), cells[0]);
+        }
+        else {
+            for(; pos.col < cols; pos.col++)
+                (void)get_cell_impl(pos, cells[pos.col]);
+        }
+        sb_lines[row] = {.cells = cells, .continuation = lineinfos[row].continuation != 0};
+    }
+
+    sb_pushlines(std::span(sb_lines).first(nrows));
+}
 
+void Screen::Impl::sb_pushlines(std::span<const PushedLine> lines) {
     if(scrollback() && scrollback()->capacity > 0)
-        scrollback()->push_line(sb_buffer, continuation);
-    if(callbacks)
-        callbacks->on_sb_pushline(sb_buffer, continuation);
+        scrollback()->push_lines(lines);
+    if(callbacks && !callbacks->on_sb_pushlines(lines))
+        for(const PushedLine& line : lines)
+            callbacks->on_sb_pushline(line.cells, line.continuation);
+}
+
+// --- Direct scrollback ---
+
+// Plain text reaches the screen only through the State and
+// ScreenStateCallbacks below, scrolling the whole screen at its bottom row
+bool Screen::Impl::direct_scroll_ready() const {
+    const EncodingInstance* gl = state.encoding[state.gl_set].get();
+    return direct_scrollback && buffer_idx == bufidx_primary && cols > 1 &&
+           state.rows == rows && state.cols == cols &&
+           vt.parser.state == ParserState::Normal && !vt.parser.in_esc &&
+           vt.parser.callbacks == state.owned_parser_callbacks.get() &&
+           state.callbacks == state_cbs.get() &&
+           gl && gl->ascii_identity() && !state.gsingle_set &&
+           state.mode.autowrap && !state.mode.insert && !state.protected_cell &&
+           state.scrollregion_top == 0 && state.scrollregion_bottom_val() == rows &&
+           state.scrollregion_left_val() == 0 && state.scrollregion_right_val() == cols;
+}
+
+// Takes the longest run of printable ASCII, CR and LF at the start of `data`
+// that scrolls the screen at least `rows` times, up to its last LF, and lays
+// it out as the State and screen would have: rows that scroll off go
+// straight to scrollback, the rest are written to the screen. Returns the
+// bytes taken; `parse` is set to how many that follow go to the parser
+// before the next attempt.
+size_t Screen::Impl::write_direct(std::span<const char> data, size_t& parse) {
+    parse = data.size();
+    if(!direct_scroll_ready())
+        return 0;
+
+    // A later LF may leave the cursor on a fresh bottom row
+    auto parse_through_lf = [&](size_t from) -> size_t {
+        auto lf = std::find(data.begin() + static_cast<ptrdiff_t>(from), data.end(), '\n');
+        parse = lf == data.end() ? data.size() : static_cast<size_t>(lf - data.begin()) + 1;
+        return 0;
+    };
+
+    const int32_t bottom = rows - 1;
+    const LineInfo& bottom_info = state.get_lineinfo(bottom);
+    if(state.pos.row != bottom || !row_extent(bottom).blank ||
+       bottom_info.doublewidth || bottom_info.doubleheight)
+        return parse_through_lf(0);
+
+    // Count the scrolls, following on_text() and on_control()
+    int32_t col = state.pos.col;
+    bool phantom = state.at_phantom;
+    int32_t scrolls = 0;
+    int32_t taken_scrolls = 0;
+    size_t taken = 0;
+    size_t i = 0;
+    for(; i < data.size(); i++) {
+        auto c = static_cast<uint8_t>(data[i]);
+        if(c >= c0_end && c < ctrl_del) {
+            if(phantom) {
+                scrolls++;
+                col = 0;
+                phantom = false;
+            }
+            if(col == cols - 1)
+                phantom = true;
+            else
+                col++;
+        }
+        else if(c == ctrl_cr) {
+            if(col != 0)
+                phantom = false;
+            col = 0;
+        }
+        else if(c == ctrl_lf) {
+            scrolls++;
+            if(state.mode.newline && col != 0) {
+                col = 0;
+                phantom = false;
+            }
+            taken = i + 1;
+            taken_scrolls = scrolls;
+        }
+        else
+            break;
+    }
+    if(taken_scrolls < rows)
+        return parse_through_lf(i);
+    parse = 0;
+
+    // Of the rows the text fills, the first `pushed` scroll off after the
+    // screen's own rows above the cursor; the rest end up on the screen
+    const int32_t pushed = taken_scrolls - rows + 1;
+    const bool has_sink = callbacks || (scrollback() && scrollback()->capacity > 0);
+    if(has_sink)
+        sb_pushlines_from_rows(bottom, state.lineinfos[state.lineinfo_bufidx]);
+
+    auto external = [&](PenId id) {
+        ScreenCell cell{};
+        pen_to_cell_attrs(pens[id], cell, global_reverse);
+        cell.width = 1;
+        return cell;
+    };
+    const InternalScreenCell erased{.glyph = 0, .pen_id = erase_pen_id(LineInfo{})};
+    const ScreenCell glyph_style = external(pen_id);
+    const ScreenCell erased_style = external(erased.pen_id);
+    // The first row is the bottom one, erased when it last scrolled in
+    ScreenCell blank_style = external(row_extent(bottom).blank_cell.pen_id);
+    direct_line.assign(cols, 0);
+
+    // Callbacks get the pushed rows a screenful at a time
+    size_t block_lines = 0;
+    if(callbacks) {
+        sb_block.resize(static_cast<size_t>(rows) * cols);
+        sb_lines.resize(rows);
+    }
+    auto notify_lines = [&] {
+        std::span<const PushedLine> lines(sb_lines.data(), block_lines);
+        if(!callbacks->on_sb_pushlines(lines))
+            for(const PushedLine& pushed_line : lines)
+                callbacks->on_sb_pushline(pushed_line.cells, pushed_line.continuation);
+        block_lines = 0;
+    };
+
+    int32_t line = 0;  // rows filled so far
+    bool continuation = bottom_info.continuation;
+    auto begin_line = [&] {
+        if(line < pushed) {
+            std::ranges::fill(direct_line, 0);
+            return;
+        }
+        int32_t row = line - pushed;
+        row_extent(row) = {.blank = true, .blank_cell = erased};
+        LineInfo info{};
+        info.continuation = continuation;
+        state.get_lineinfo(row) = info;
+    };
+    auto end_line = [&] {
+        if(line < pushed && has_sink) {
+            if(scrollback() && scrollback()->capacity > 0)
+                scrollback()->push_ascii_line(direct_line, glyph_style, blank_style, continuation);
+            if(callbacks) {
+                std::span<ScreenCell> cells(sb_block.data() + block_lines * cols, cols);
+                for(int32_t col = 0; col < cols; col++) {
+                    cells[col] = direct_line[col] ? glyph_style : blank_style;
+                    cells[col].chars[0] = static_cast<uint8_t>(direct_line[col]);
+                }
+                sb_lines[block_lines++] = {.cells = cells, .continuation = continuation};
+                if(block_lines == sb_lines.size() || line + 1 == pushed)
+                    notify_lines();
+            }
+        }
+        blank_style = erased_style;
+        line++;
+    };
+
+    col = state.pos.col;
+    phantom = state.at_phantom;
+    int32_t last_col = -1;
+    uint32_t last_char = 0;
+    begin_line();
+    for(i = 0; i < taken; i++) {
+        auto c = static_cast<uint8_t>(data[i]);
+        if(c == ctrl_cr) {
+            if(col != 0)
+                phantom = false;
+            col = 0;
+            continue;
+        }
+        if(c == ctrl_lf) {
+            end_line();
+            continuation = false;
+            begin_line();
+            if(state.mode.newline && col != 0) {
+                col = 0;
+                phantom = false;
+            }
+            continue;
+        }
+
+        if(phantom) {
+            end_line();
+            continuation = true;
+            begin_line();
+            col = 0;
+            phantom = false;
+        }
+        if(line < pushed) {
+            direct_line[col] = static_cast<char>(c);
+        }
+        else {
+            int32_t row = line - pushed;
+            InternalScreenCell* cell = getcell(row, col);
+            cell->glyph = c;
+            cell->pen_id = pen_id;
+            RowExtent& extent = row_extent(row);
+            extent.end = std::max(extent.end, col + 1);
+        }
+        last_col = col;
+        last_char = c;
+        if(col == cols - 1)
+            phantom = true;
+        else
+            col++;
+    }
+
+    // As left by the last glyph and the LF after it
+    if(last_col >= 0) {
+        state.combine_chars[0] = last_char;
+        state.combine_count = 1;
+        state.combine_width = 1;
+        state.combine_pos = {.row = bottom, .col = last_col};
+    }
+    Pos oldpos = state.pos;
+    state.pos.col = col;
+    state.at_phantom = phantom;
+
+    mark_dirty(0, rows);
+    damagescreen();
+    state.updatecursor(oldpos, false);
+
+    return taken;
+}
+
+size_t Terminal::Impl::write_direct(std::span<const char> bytes, size_t& parse) {
+    if(!screen) {
+        parse = bytes.size();
+        return 0;
+    }
+    return screen->write_direct(bytes, parse);
 }
 
 // StateCallbacks subclass that routes state callbacks to screen logic
@@ -321,27 +1343,56 @@ struct ScreenStateCallbacks : public StateCallbacks {
         if(!cell)
             return false;
 
-        int32_t i = 0;
-        for(; i < static_cast<int32_t>(info.chars.size()) && i < max_chars_per_cell; i++)
-            cell->chars[i] = info.chars[i];
-        if(i < max_chars_per_cell)
-            cell->chars[i] = 0;
-        cell->pen = screen.pen;
+        // No other cell is mid-update, so ids may be renumbered
+        if(screen.clusters.clusters.size() >= screen.cluster_compact_at)
+            screen.compact_clusters();
+        cell->glyph = screen.intern_glyph(info.chars);
+        cell->pen_id = screen.pen_id_with(info.protected_cell, info.dwl, info.dhl);
 
         for(int32_t col = 1; col < info.width; col++) {
             InternalScreenCell* cont = screen.getcell(pos.row, pos.col + col);
-            if(cont) cont->chars[0] = widechar_continuation;
+            if(cont) cont->glyph = widechar_continuation;
         }
 
-        cell->pen.protected_cell = info.protected_cell;
-        cell->pen.dwl            = info.dwl;
-        cell->pen.dhl            = info.dhl;
-
+        screen.update_extent(pos.row, pos.col, pos.col + info.width);
+        screen.mark_dirty(pos.row, pos.row + 1);
         screen.damagerect({.start_row = pos.row, .end_row = pos.row + 1, .start_col = pos.col, .end_col = pos.col + info.width});
 
         return true;
     }
 
+    bool on_putglyphs(std::span<const uint32_t> chars, Pos pos) override {
+        int32_t count = static_cast<int32_t>(chars.size());
+        InternalScreenCell* cell = screen.getcell(pos.row, pos.col);
+        if(!cell || pos.col + count > screen.cols)
+            return false;
+
+        uint32_t all_bits = 0;
+        for(int32_t i = 0; i < count; i++) {
+            cell[i].glyph = chars[i];
+            cell[i].pen_id = screen.pen_id;
+            all_bits |= chars[i];
+        }
+
+        // Printable codepoints are never blank, so the row reaches at least this far
+        RowExtent& extent = screen.row_extent(pos.row);
+        extent.end = std::max(extent.end, pos.col + count);
+        extent.ascii = extent.ascii && all_bits < utf8_max_1byte;
+
+        screen.mark_dirty(pos.row, pos.row + 1);
+
+        // Per-cell damage keeps its one-event-per-glyph contract
+        if(screen.damage_merge == DamageSize::Cell && screen.batch_depth == 0) {
+            for(int32_t col = pos.col; col < pos.col + count; col++)
+                screen.damagerect({.start_row = pos.row, .end_row = pos.row + 1, .start_col = col, .end_col = col + 1});
+        }
+        else {
+            screen.damagerect({.start_row = pos.row, .end_row = pos.row + 1, .start_col = pos.col, .end_col = pos.col + count});
+        }
+
+        return true;
+    }
+
     bool on_premove(Rect rect) override {
         bool has_sink = screen.callbacks ||
                         (screen.scrollback() && screen.scrollback()->capacity > 0);
@@ -349,22 +1400,27 @@ struct ScreenStateCallbacks : public StateCallbacks {
            rect.start_row == 0 && rect.start_col == 0 &&
            rect.end_col == screen.cols &&
            screen.buffer_idx == bufidx_primary) {
-            for(int32_t row = 0; row < rect.end_row; row++) {
-                const LineInfo& lineinfo = screen.state.get_lineinfo(row);
-                screen.sb_pushline_from_row(row, lineinfo.continuation);
-            }
+            screen.sb_pushlines_from_rows(rect.end_row, screen.state.lineinfos[screen.state.lineinfo_bufidx]);
         }
         return true;
     }
 
     bool on_movecursor(Pos pos, Pos oldpos, bool visible) override {
+        if(screen.batch_depth > 0) {
+            if(!screen.batch.cursor_moved)
+                screen.batch.cursor_oldpos = oldpos;
+            screen.batch.cursor_moved = true;
+            screen.batch.cursor_pos = pos;
+            screen.batch.cursor_visible = visible;
+            return true;
+        }
         if(screen.callbacks)
             return screen.callbacks->on_movecursor(pos, oldpos, visible);
         return false;
     }
 
     bool on_scrollrect(Rect rect, int32_t downward, int32_t rightward) override {
-        if(screen.damage_merge != DamageSize::Scroll) {
+        if(!screen.scroll_deferred()) {
             scroll_rect(rect, downward, rightward,
                 [this](Rect dest, Rect src) -> bool { return screen.moverect_internal(dest, src); },
                 [this](Rect r, bool selective) -> bool { return screen.erase_internal(r, selective); });
@@ -378,7 +1434,8 @@ struct ScreenStateCallbacks : public StateCallbacks {
             return true;
         }
 
-        if(screen.damaged.start_row != no_damage_row &&
+        if(screen.batch_depth == 0 &&
+           screen.damaged.start_row != no_damage_row &&
            !rect.intersects(screen.damaged)) {
             screen.flush_damage_impl();
         }
@@ -395,7 +1452,12 @@ struct ScreenStateCallbacks : public StateCallbacks {
             screen.pending_scroll_rightward += rightward;
         }
         else {
-            screen.flush_damage_impl();
+            if(screen.batch_depth > 0) {
+                // Only one scroll is held; repaint the earlier one instead
+                screen.damagerect(screen.pending_scrollrect);
+            }
+            else
+                screen.flush_damage_impl();
 
             screen.pending_scrollrect = rect;
             screen.pending_scroll_downward  = downward;
@@ -406,37 +1468,25 @@ struct ScreenStateCallbacks : public StateCallbacks {
             [this](Rect dest, Rect src) -> bool { return screen.moverect_internal(dest, src); },
             [this](Rect r, bool selective) -> bool { return screen.erase_internal(r, selective); });
 
-        if(screen.damaged.start_row == no_damage_row)
-            return true;
+        if(screen.damaged.start_row != no_damage_row)
+            scroll_damage(screen.damaged, rect, downward, rightward);
 
-        if(rect.contains_rect(screen.damaged)) {
-            // Scroll region entirely contains the damage; just move it
-            screen.damaged.move(-downward, -rightward);
-            screen.damaged.clip(rect);
-        }
-        // Common case: vertical scroll that neatly cuts the damage region in half
-        else if(rect.start_col <= screen.damaged.start_col &&
-                rect.end_col   >= screen.damaged.end_col &&
-                rightward == 0) {
-            if(screen.damaged.start_row >= rect.start_row &&
-               screen.damaged.start_row  < rect.end_row) {
-                screen.damaged.start_row -= downward;
-                if(screen.damaged.start_row < rect.start_row)
-                    screen.damaged.start_row = rect.start_row;
-                if(screen.damaged.start_row > rect.end_row)
-                    screen.damaged.start_row = rect.end_row;
-            }
-            if(screen.damaged.end_row > rect.start_row &&
-               screen.damaged.end_row < rect.end_row) {
-                screen.damaged.end_row -= downward;
-                if(screen.damaged.end_row < rect.start_row)
-                    screen.damaged.end_row = rect.start_row;
-                if(screen.damaged.end_row > rect.end_row)
-                    screen.damaged.end_row = rect.end_row;
+        if(screen.batch_depth > 0 && screen.damage_region.count) {
+            // Moved rects may now overlap; add them back one by one
+            DamageRegion moved = screen.damage_region;
+            screen.damage_region.clear();
+            for(size_t i = 0; i < moved.count; i++) {
+                scroll_damage(moved.rects[i], rect, downward, rightward);
+                screen.damage_region.add(moved.rects[i]);
             }
         }
-        else {
-            screen.damaged.expand(rect);
+
+        if(screen.batch_depth > 0) {
+            // The net shift only exposes one edge; scrolls the other way in
+            // the same batch blanked cells it would not
+            scroll_rect(rect, downward, rightward,
+                [](Rect, Rect) -> bool { return true; },
+                [this](Rect r, bool) -> bool { screen.damagerect(r); return true; });
         }
 
         return true;
@@ -452,23 +1502,13 @@ struct ScreenStateCallbacks : public StateCallbacks {
         return false;
     }
 
-    bool on_setpenattr(Attr attr, const Value& val) override {
-        switch(attr) {
-        case Attr::Bold:       screen.pen.bold      = val.boolean; return true;
-        case Attr::Underline:  screen.pen.underline  = static_cast<Underline>(val.number); return true;
-        case Attr::Italic:     screen.pen.italic     = val.boolean; return true;
-        case Attr::Blink:      screen.pen.blink      = val.boolean; return true;
-        case Attr::Reverse:    screen.pen.reverse    = val.boolean; return true;
-        case Attr::Conceal:    screen.pen.conceal    = val.boolean; return true;
-        case Attr::Strike:     screen.pen.strike     = val.boolean; return true;
-        case Attr::Font:       screen.pen.font       = val.number;  return true;
-        case Attr::Foreground: screen.pen.fg         = val.color;   return true;
-        case Attr::Background: screen.pen.bg         = val.color;   return true;
-        case Attr::Small:      screen.pen.small      = val.boolean; return true;
-        case Attr::Baseline:   screen.pen.baseline   = static_cast<Baseline>(val.number);  return true;
-        case Attr::NAttrs:     return false;
-        }
-        return false;
+    bool on_setpen(const Pen& pen, AttrMask) override {
+        // No cell pen is being built here, so ids may be renumbered
+        if(screen.pens.pens.size() >= screen.pen_compact_at)
+            screen.compact_pens();
+        assign_pen(screen.pen, pen);
+        screen.update_pen_id();
+        return true;
     }
 
     bool on_settermprop(Prop prop, const Value& val) override {
@@ -481,17 +1521,36 @@ struct ScreenStateCallbacks : public StateCallbacks {
                 : bufidx_primary;
             // only send a damage event on disable; because during enable there's an
             // erase that sends a damage anyway
+            screen.mark_all_dirty();
             if(!val.boolean)
                 screen.damagescreen();
             break;
         case Prop::Reverse:
             screen.global_reverse = val.boolean;
+            screen.mark_all_dirty();
             screen.damagescreen();
             break;
+        case Prop::SyncOutput:
+            // Handled here whatever the callbacks say, and never held
+            if(val.boolean)
+                screen.begin_sync();
+            else
+                screen.end_sync();
+            if(screen.callbacks)
+                (void)screen.callbacks->on_settermprop(prop, val);
+            return true;
         default:
             ; // ignore
         }
 
+        // Strings point into the parser's buffer and cannot be held
+        if(screen.batch_depth > 0 && get_prop_type(prop) != ValueType::String) {
+            auto i = static_cast<size_t>(to_underlying(prop));
+            screen.batch.props[i] = val;
+            screen.batch.props_set[i] = true;
+            return true;
+        }
+
         if(screen.callbacks)
             return screen.callbacks->on_settermprop(prop, val);
 
@@ -509,13 +1568,24 @@ struct ScreenStateCallbacks : public StateCallbacks {
     bool on_setlineinfo(int32_t row, const LineInfo& newinfo, const LineInfo& oldinfo) override {
         if(newinfo.doublewidth != oldinfo.doublewidth ||
            newinfo.doubleheight != oldinfo.doubleheight) {
+            // Rows are usually a handful of pens; remember the last mapping
+            PenId from = 0, to = 0;
+            bool have_mapping = false;
             for(int32_t col = 0; col < screen.cols; col++) {
                 InternalScreenCell* cell = screen.getcell(row, col);
                 if(!cell) continue;
-                cell->pen.dwl = newinfo.doublewidth;
-                cell->pen.dhl = newinfo.doubleheight;
+                if(!have_mapping || cell->pen_id != from) {
+                    ScreenPen pen = screen.pens[cell->pen_id];
+                    pen.dwl = newinfo.doublewidth;
+                    pen.dhl = newinfo.doubleheight;
+                    from = cell->pen_id;
+                    to = screen.pens.intern(pen);
+                    have_mapping = true;
+                }
+                cell->pen_id = to;
             }
 
+            screen.mark_dirty(row, row + 1);
             screen.damagerect({.start_row = row, .end_row = row + 1, .start_col = 0, .end_col = newinfo.doublewidth ? screen.cols / 2 : screen.cols});
 
             if(newinfo.doublewidth)
@@ -541,6 +1611,24 @@ bool Screen::Impl::moverect_internal(Rect dest, Rect src) {
     int32_t ncols = src.end_col - src.start_col;
     int32_t downward = src.start_row - dest.start_row;
 
+    // Full-width vertical move between touching or overlapping rects: rotate
+    // the row index. Rows of src outside dest end up holding stale cells,
+    // which scroll_rect() erases straight after.
+    if(ncols == cols && src.start_col == 0 && dest.start_col == 0 &&
+       std::abs(downward) <= dest.end_row - dest.start_row) {
+        auto& index = row_index[buffer_idx];
+        auto first = index.begin() + std::min(dest.start_row, src.start_row);
+        auto last  = index.begin() + std::max(dest.end_row, src.end_row);
+        if(downward > 0)
+            std::rotate(first, first + downward, last);
+        else
+            std::rotate(first, last + downward, last);
+        mark_moved(dest.start_row, dest.end_row);
+        return true;
+    }
+
+    mark_dirty(dest.start_row, dest.end_row);
+
     int32_t init_row, test_row, inc_row;
     if(downward < 0) {
         init_row = dest.end_row - 1;
@@ -554,21 +1642,28 @@ bool Screen::Impl::moverect_internal(Rect dest, Rect src) {
     }
 
     auto& buf = buffers[buffer_idx];
+    auto& index = row_index[buffer_idx];
     for(int32_t row = init_row; row != test_row; row += inc_row) {
-        auto dst = buf.begin() + row * cols + dest.start_col;
-        auto srci = buf.begin() + (row + downward) * cols + src.start_col;
+        // Fill in blank rows before copying cells in or out
+        (void)getcell(row, 0);
+        (void)getcell(row + downward, 0);
+        auto dst = buf.begin() + index[row] * cols + dest.start_col;
+        auto srci = buf.begin() + index[row + downward] * cols + src.start_col;
         if(dst < srci)
             std::copy(srci, srci + ncols, dst);
         else
             std::copy_backward(srci, srci + ncols, dst + ncols);
     }
 
+    for(int32_t row = dest.start_row; row < dest.end_row; row++)
+        update_extent(row, dest.start_col, dest.end_col);
+
     return true;
 }
 
 bool Screen::Impl::moverect_user(Rect dest, Rect src) {
     if(callbacks) {
-        if(damage_merge != DamageSize::Scroll) {
+        if(!scroll_deferred()) {
             // Avoid an infinite loop
             flush_damage_impl();
         }
@@ -583,32 +1678,56 @@ bool Screen::Impl::moverect_user(Rect dest, Rect src) {
 }
 
 bool Screen::Impl::erase_internal(Rect rect, bool selective) {
+    mark_dirty(rect.start_row, rect.end_row);
+
+    int32_t start_col = std::max(rect.start_col, 0);
+    int32_t end_col = std::min(rect.end_col, cols);
 
-    for(int32_t row = rect.start_row; row < state.rows && row < rect.end_row; row++) {
+    // Rows share a handful of line sizes; intern each pen once
+    PenId newpen_id = 0;
+    LineInfo newpen_info{};
+    bool have_pen = false;
+
+    for(int32_t row = std::max(rect.start_row, 0); row < std::min(state.rows, rows) && row < rect.end_row; row++) {
         const LineInfo& info = state.get_lineinfo(row);
 
-        for(int32_t col = rect.start_col; col < rect.end_col; col++) {
-            InternalScreenCell* cell = getcell(row, col);
-            if(!cell)
-                continue;
+        if(!have_pen || info.doublewidth != newpen_info.doublewidth || info.doubleheight != newpen_info.doubleheight) {
+            newpen_id = erase_pen_id(info);
+            newpen_info = info;
+            have_pen = true;
+        }
+
+        if(!selective && start_col == 0 && end_col == cols) {
+            // Whole row: nothing is written until the row next is
+            row_extent(row) = {.blank = true, .blank_cell = {.glyph = 0, .pen_id = newpen_id}};
+            continue;
+        }
 
-            if(selective && cell->pen.protected_cell)
+        InternalScreenCell* cells = getcell(row, 0);
+        for(int32_t col = start_col; col < end_col; col++) {
+            if(selective && pens[cells[col].pen_id].protected_cell)
                 continue;
 
-            cell->chars[0] = 0;
-            // Only copy .fg and .bg; leave things like rv in reset state
-            ScreenPen newpen{};
-            newpen.fg = pen.fg;
-            newpen.bg = pen.bg;
-            cell->pen = newpen;
-            cell->pen.dwl = info.doublewidth;
-            cell->pen.dhl = info.doubleheight;
+            cells[col].glyph = 0;
+            cells[col].pen_id = newpen_id;
         }
+
+        update_extent(row, start_col, end_col);
     }
 
     return true;
 }
 
+// Erased cells keep only the pen's colours; leave things like rv in reset state
+PenId Screen::Impl::erase_pen_id(const LineInfo& info) {
+    ScreenPen newpen{};
+    newpen.fg = pen.fg;
+    newpen.bg = pen.bg;
+    newpen.dwl = info.doublewidth;
+    newpen.dhl = info.doubleheight;
+    return pens.intern(newpen);
+}
+
 bool Screen::Impl::erase_user(Rect rect, [[maybe_unused]] bool selective) {
     damagerect(rect);
     return true;
@@ -618,15 +1737,6 @@ bool Screen::Impl::erase_user(Rect rect, [[maybe_unused]] bool selective) {
 
 namespace {
 
-// How many cells are non-blank
-// Returns the position of the first blank cell in the trailing blank end
-[[nodiscard]] constexpr int32_t line_popcount(std::span<const InternalScreenCell> buffer, int32_t row, int32_t cols) {
-    int32_t col = cols - 1;
-    while(col >= 0 && buffer[row * cols + col].chars[0] == 0)
-        col--;
-    return col + 1;
-}
-
 // Compute the number of rows needed to pack `total_width` cells into rows of
 // `new_cols`, accounting for double-width characters that can't be split across
 // row boundaries.  `is_wide_at_boundary(pos)` returns true when the character
@@ -651,14 +1761,31 @@ template<typename IsWideAtBoundary>
 } // anonymous namespace
 
 void Screen::Impl::resize_buffer(int32_t bufidx, int32_t new_rows, int32_t new_cols, bool active, StateFields& statefields) {
+    resize_scratch = resize_arena.start();
+
+    if(new_cols == cols && resize_rows_in_place(bufidx, new_rows, active, statefields))
+        return;
+
     int32_t old_rows = rows;
     int32_t old_cols = cols;
 
-    std::vector<InternalScreenCell>& old_buffer = buffers[bufidx];
+    materialize_rows(bufidx);
+
+    // Old rows are read through row_index, in place
+    const std::vector<InternalScreenCell>& old_buffer = buffers[bufidx];
+    const std::vector<int32_t>& old_index = row_index[bufidx];
     std::vector<LineInfo>& old_lineinfo_vec = *statefields.lineinfos[bufidx];
+    const std::vector<RowExtent>& old_extents = row_extents[bufidx];
+    auto old_cell = [&](int32_t row, int32_t col) -> const InternalScreenCell& {
+        return old_buffer[static_cast<size_t>(old_index[row]) * old_cols + col];
+    };
 
-    std::vector<InternalScreenCell> new_buffer(new_rows * new_cols);
-    std::vector<LineInfo> new_lineinfo(new_rows);
+    std::vector<InternalScreenCell> new_buffer = std::move(spare_buffer);
+    std::vector<RowExtent> new_extents = std::move(spare_extents);
+    new_buffer.assign(static_cast<size_t>(new_rows) * new_cols, InternalScreenCell{});
+    new_extents.assign(new_rows, RowExtent{});
+    std::pmr::vector<LineInfo> new_lineinfo(new_rows, resize_scratch);
+    ResizeRows dst{.buffer = new_buffer, .extents = new_extents, .lineinfo = new_lineinfo, .cols = new_cols};
 
     int32_t old_row = old_rows - 1;
     int32_t new_row = new_rows - 1;
@@ -693,7 +1820,7 @@ void Screen::Impl::resize_buffer(int32_t bufidx, int32_t new_rows, int32_t new_c
                 if(reflow && row < (old_rows - 1) && old_lineinfo_vec[row + 1].continuation)
                     width += old_cols;
                 else
-                    width += line_popcount(old_buffer, row, old_cols);
+                    width += old_extents[old_index[row]].end;
             }
 
             if(final_blank_row == (new_row + 1) && width == 0)
@@ -705,7 +1832,7 @@ void Screen::Impl::resize_buffer(int32_t bufidx, int32_t new_rows, int32_t new_c
                     int32_t p_row = old_row_start + boundary_pos / old_cols;
                     int32_t p_col = boundary_pos % old_cols;
                     return p_row <= old_row_end &&
-                           old_buffer[p_row * old_cols + p_col].chars[0] == widechar_continuation;
+                           old_cell(p_row, p_col).glyph == widechar_continuation;
                 });
             }
             else {
@@ -737,6 +1864,8 @@ void Screen::Impl::resize_buffer(int32_t bufidx, int32_t new_rows, int32_t new_c
                     new_buffer.begin() + (rowcount + downwards) * new_cols);
                 std::copy_backward(new_lineinfo.begin(), new_lineinfo.begin() + rowcount,
                     new_lineinfo.begin() + rowcount + downwards);
+                std::copy_backward(new_extents.begin(), new_extents.begin() + rowcount,
+                    new_extents.begin() + rowcount + downwards);
 
                 new_row       += downwards;
                 new_row_start += downwards;
@@ -769,6 +1898,7 @@ void Screen::Impl::resize_buffer(int32_t bufidx, int32_t new_rows, int32_t new_c
                 width -= count;
 
                 int32_t new_col = 0;
+                new_extents[new_row] = {};
 
                 while(count) {
                     if(reflow && new_col == new_cols - 1 && new_cols > 1) {
@@ -779,14 +1909,15 @@ void Screen::Impl::resize_buffer(int32_t bufidx, int32_t new_rows, int32_t new_c
                             peek_col = 0;
                         }
                         if(peek_row <= old_row_end &&
-                           old_buffer[peek_row * old_cols + peek_col].chars[0] == widechar_continuation) {
+                           old_cell(peek_row, peek_col).glyph == widechar_continuation) {
                             clearcell(new_buffer[new_row * new_cols + new_col]);
                             width += count;
                             break;
                         }
                     }
 
-                    new_buffer[new_row * new_cols + new_col] = old_buffer[old_row * old_cols + old_col];
+                    new_buffer[new_row * new_cols + new_col] = old_cell(old_row, old_col);
+                    dst.note_cell(new_row, new_col, new_buffer[new_row * new_cols + new_col].glyph);
 
                     if(old_cursor.row == old_row && old_cursor.col == old_col) {
                         new_cursor.row = new_row;
@@ -849,10 +1980,7 @@ void Screen::Impl::resize_buffer(int32_t bufidx, int32_t new_rows, int32_t new_c
         if(has_sink) {
             int32_t saved_buffer_idx = buffer_idx;
             buffer_idx = bufidx;
-            for(int32_t row = 0; row <= old_row; row++) {
-                const LineInfo& lineinfo = old_lineinfo_vec[row];
-                sb_pushline_from_row(row, lineinfo.continuation);
-            }
+            sb_pushlines_from_rows(old_row + 1, old_lineinfo_vec);
             buffer_idx = saved_buffer_idx;
         }
         if(active)
@@ -861,6 +1989,221 @@ void Screen::Impl::resize_buffer(int32_t bufidx, int32_t new_rows, int32_t new_c
 
     // ---- Phase 3: Backfill empty rows from scrollback ----
 
+    backfill_rows(bufidx, dst, new_row, old_cols, active, statefields);
+
+    // ---- Phase 4: Scroll content to top and blank-fill bottom ----
+
+    if(new_row >= 0) {
+        int32_t moverows = new_rows - new_row - 1;
+        std::copy(new_buffer.begin() + (new_row + 1) * new_cols,
+            new_buffer.begin() + (new_row + 1 + moverows) * new_cols,
+            new_buffer.begin());
+        std::copy(new_lineinfo.begin() + new_row + 1,
+            new_lineinfo.begin() + new_row + 1 + moverows,
+            new_lineinfo.begin());
+        std::copy(new_extents.begin() + new_row + 1,
+            new_extents.begin() + new_row + 1 + moverows,
+            new_extents.begin());
+
+        new_cursor.row -= (new_row + 1);
+        if(new_cursor.row < 0)
+            new_cursor.row = 0;
+
+        for(new_row = moverows; new_row < new_rows; new_row++) {
+            for(int32_t col = 0; col < new_cols; col++)
+                clearcell(new_buffer[new_row * new_cols + col]);
+            new_lineinfo[new_row] = LineInfo{};
+            new_extents[new_row] = {};
+        }
+    }
+
+    spare_buffer = std::exchange(buffers[bufidx], std::move(new_buffer));
+    spare_extents = std::exchange(row_extents[bufidx], std::move(new_extents));
+    reset_row_index(bufidx, new_rows);
+
+    statefields.lineinfos[bufidx]->assign(new_lineinfo.begin(), new_lineinfo.end());
+
+    if(active)
+        statefields.pos = new_cursor;
+}
+
+// Resize that only changes the row count. When every logical line keeps its
+// height at the same width, the rows resize_buffer() would build are the old
+// rows moved whole, so they stay where they are in buffers[bufidx] and only
+// row_index, the extents and the line infos change. Rows keep their cells
+// as they were, trailing blanks included. Returns false, having changed
+// nothing, when a line would repack differently.
+bool Screen::Impl::resize_rows_in_place(int32_t bufidx, int32_t new_rows, bool active, StateFields& statefields) {
+    int32_t old_rows = rows;
+    std::vector<InternalScreenCell>& buffer = buffers[bufidx];
+    std::vector<int32_t>& index = row_index[bufidx];
+    std::vector<RowExtent>& extents = row_extents[bufidx];
+    const std::vector<LineInfo>& old_lineinfo = *statefields.lineinfos[bufidx];
+
+    auto first_glyph = [&](int32_t row) {
+        const RowExtent& extent = extents[index[row]];
+        return extent.blank ? extent.blank_cell.glyph : buffer[static_cast<size_t>(index[row]) * cols].glyph;
+    };
+
+    // Phase 1 of resize_buffer() counted in rows: place logical lines
+    // bottom-up, dropping trailing blank rows while the cursor stays on
+    // screen, until one no longer fits
+    int32_t old_row = old_rows - 1;
+    int32_t new_row = new_rows - 1;
+    int32_t final_blank_row = new_rows;
+    Pos old_cursor = statefields.pos;
+    Pos new_cursor = {.row = cursor_unset, .col = cursor_unset};
+
+    while(old_row >= 0) {
+        int32_t old_row_end = old_row;
+        while(reflow && old_row >= 0 && old_lineinfo[old_row].continuation)
+            old_row--;
+        int32_t old_row_start = std::max(old_row, 0);
+
+        // A wide glyph at a row start or an empty last row would repack
+        if(old_row_end > old_row_start) {
+            if(extents[index[old_row_end]].end == 0)
+                return false;
+            for(int32_t row = old_row_start + 1; row <= old_row_end; row++)
+                if(first_glyph(row) == widechar_continuation)
+                    return false;
+        }
+
+        int32_t height = old_row_end - old_row_start + 1;
+        bool blank = height == 1 && extents[index[old_row_start]].end == 0;
+        if(final_blank_row == (new_row + 1) && blank)
+            final_blank_row = new_row;
+
+        int32_t new_row_start = new_row - height + 1;
+        int32_t spare_rows = new_rows - final_blank_row;
+        if(new_row_start < 0 && spare_rows >= 0 &&
+           (!active || new_cursor.row == cursor_unset || (new_cursor.row - new_row_start) < new_rows))
+        {
+            int32_t downwards = std::min(-new_row_start, spare_rows);
+            new_row       += downwards;
+            new_row_start += downwards;
+            if(new_cursor.row >= 0)
+                new_cursor.row += downwards;
+            final_blank_row += downwards;
+        }
+
+        if(new_row_start < 0) {
+            if(old_row_start <= old_cursor.row && old_cursor.row <= old_row_end)
+                new_cursor = {.row = 0, .col = std::min(old_cursor.col, cols - 1)};
+            old_row = old_row_end;
+            break;
+        }
+
+        if(old_row_start <= old_cursor.row && old_cursor.row <= old_row_end)
+            new_cursor = {.row = new_row_start + old_cursor.row - old_row_start, .col = std::min(old_cursor.col, cols - 1)};
+
+        old_row = old_row_start - 1;
+        new_row = new_row_start - 1;
+    }
+
+    if(old_cursor.row <= old_row)
+        new_cursor = {.row = 0, .col = std::min(old_cursor.col, cols - 1)};
+
+    if(active && (new_cursor.row == cursor_unset || new_cursor.col == cursor_unset)) {
+        std::cerr << "screen_resize failed to update cursor position\n";
+        std::abort();
+    }
+
+    // Phase 2: rows above the placed lines go to scrollback
+    if(old_row >= 0 && bufidx == bufidx_primary) {
+        bool has_sink = callbacks || (scrollback() && scrollback()->capacity > 0);
+        if(has_sink) {
+            int32_t saved_buffer_idx = buffer_idx;
+            buffer_idx = bufidx;
+            sb_pushlines_from_rows(old_row + 1, old_lineinfo);
+            buffer_idx = saved_buffer_idx;
+        }
+    }
+
+    // Old rows old_row + 1 onwards become new rows new_row + 1 onwards;
+    // rows below the last of those were blank and are dropped
+    int32_t kept = new_rows - new_row - 1;
+    int32_t first_kept = old_row + 1;
+
+    // Like resize_buffer(), carry over only the continuation flags
+    std::pmr::vector<LineInfo> new_lineinfo(new_rows, resize_scratch);
+    for(int32_t i = 0; i < kept; i++)
+        new_lineinfo[new_row + 1 + i].continuation = reflow && i > 0 && old_lineinfo[first_kept + i].continuation;
+
+    // Keep physical rows below new_rows; a kept row above that moves down
+    // into one that is free
+    int32_t physical_rows = std::max(old_rows, new_rows);
+    std::pmr::vector<int32_t> new_index(new_rows, resize_scratch);
+    std::pmr::vector<bool> used(physical_rows, false, resize_scratch);
+    for(int32_t i = 0; i < kept; i++) {
+        new_index[new_row + 1 + i] = index[first_kept + i];
+        used[index[first_kept + i]] = true;
+    }
+
+    if(new_rows > old_rows) {
+        buffer.resize(static_cast<size_t>(new_rows) * cols);
+        extents.resize(new_rows);
+    }
+
+    int32_t next_free = 0;
+    auto take_free = [&] {
+        while(used[next_free])
+            next_free++;
+        used[next_free] = true;
+        return next_free;
+    };
+    for(int32_t row = new_row + 1; row < new_rows; row++) {
+        int32_t from = new_index[row];
+        if(from < new_rows)
+            continue;
+        int32_t to = take_free();
+        std::copy_n(buffer.begin() + static_cast<ptrdiff_t>(from) * cols, cols, buffer.begin() + static_cast<ptrdiff_t>(to) * cols);
+        extents[to] = extents[from];
+        new_index[row] = to;
+    }
+
+    if(new_rows < old_rows) {
+        buffer.resize(static_cast<size_t>(new_rows) * cols);
+        extents.resize(new_rows);
+    }
+
+    const RowExtent blank_row = {.blank = true, .blank_cell = {.glyph = 0, .pen_id = pen_id}};
+    for(int32_t row = 0; row <= new_row; row++) {
+        new_index[row] = take_free();
+        extents[new_index[row]] = blank_row;
+    }
+    index.assign(new_index.begin(), new_index.end());
+
+    // Phase 3: backfill rows above new_row from scrollback
+    ResizeRows dst{.buffer = buffer, .extents = extents, .lineinfo = new_lineinfo, .index = &index, .cols = cols};
+    backfill_rows(bufidx, dst, new_row, cols, active, statefields);
+
+    // Phase 4: rows still empty rotate round to the bottom
+    if(new_row >= 0) {
+        int32_t shift = new_row + 1;
+        std::rotate(index.begin(), index.begin() + shift, index.end());
+        std::rotate(new_lineinfo.begin(), new_lineinfo.begin() + shift, new_lineinfo.end());
+        for(int32_t row = new_rows - shift; row < new_rows; row++) {
+            extents[index[row]] = blank_row;
+            new_lineinfo[row] = LineInfo{};
+        }
+
+        new_cursor.row = std::max(new_cursor.row - shift, 0);
+    }
+
+    statefields.lineinfos[bufidx]->assign(new_lineinfo.begin(), new_lineinfo.end());
+
+    if(active)
+        statefields.pos = new_cursor;
+
+    return true;
+}
+
+// Phase 3 of resize_buffer(): fills the empty rows above `new_row` of `out`
+// from scrollback, moving `new_row` up past what it fills
+void Screen::Impl::backfill_rows(int32_t bufidx, ResizeRows& out, int32_t& new_row, int32_t old_cols, bool active, StateFields& statefields) {
+    int32_t new_cols = out.cols;
+
     auto do_popline = [this](std::span<ScreenCell> cells, bool& cont) -> bool {
         if(scrollback() && scrollback()->capacity > 0)
             return scrollback()->pop_line(cells, cont);
@@ -875,10 +2218,25 @@ void Screen::Impl::resize_buffer(int32_t bufidx, int32_t new_rows, int32_t new_c
             callbacks->on_sb_pushline(cells, cont);
     };
 
+    // Popped cells come in runs sharing a pen; intern each run's pen once
+    ScreenPen run_pen{};
+    PenId run_pen_id = 0;
+    bool have_run_pen = false;
+    auto cell_pen_id = [&](const ScreenCell& cell) {
+        ScreenPen cellpen{};
+        cell_attrs_to_pen(cell, cellpen, global_reverse);
+        if(!have_run_pen || !(cellpen == run_pen)) {
+            run_pen = cellpen;
+            run_pen_id = pens.intern(cellpen);
+            have_run_pen = true;
+        }
+        return run_pen_id;
+    };
+
     // Reflow-aware backfill: pop complete logical lines from scrollback,
     // join continuation segments, and re-split at new column width.
     auto backfill_reflow = [&]() {
-        std::vector<ScreenCell> logical_cells(old_cols * initial_logical_segments);
+        std::pmr::vector<ScreenCell> logical_cells(old_cols * initial_logical_segments, resize_scratch);
 
         while(new_row >= 0) {
             int32_t total_segs = 0;
@@ -955,7 +2313,8 @@ void Screen::Impl::resize_buffer(int32_t bufidx, int32_t new_rows, int32_t new_c
             int32_t row_start = new_row - new_height + 1;
 
             for(int32_t row = row_start; row <= new_row; row++) {
-                new_lineinfo[row].continuation = (row > row_start);
+                out.lineinfo[row].continuation = (row > row_start);
+                out.extent(row) = {};
 
                 int32_t count = remaining >= new_cols ? new_cols : remaining;
                 remaining -= count;
@@ -964,7 +2323,7 @@ void Screen::Impl::resize_buffer(int32_t bufidx, int32_t new_rows, int32_t new_c
                 pos.row = row;
                 for(pos.col = 0; count > 0; pos.col++, count--) {
                     ScreenCell& src = logical_cells[src_seg * old_cols + src_col];
-                    InternalScreenCell& dst = new_buffer[pos.row * new_cols + pos.col];
+                    InternalScreenCell& dst = out.cells(pos.row)[pos.col];
 
                     if(src.width == 2 && pos.col == new_cols - 1 && new_cols > 1) {
                         clearcell(dst);
@@ -972,11 +2331,14 @@ void Screen::Impl::resize_buffer(int32_t bufidx, int32_t new_rows, int32_t new_c
                         break;
                     }
 
-                    dst.chars = src.chars;
-                    cell_attrs_to_pen(src, dst.pen, global_reverse);
+                    dst.glyph = intern_glyph(src.chars);
+                    dst.pen_id = cell_pen_id(src);
+                    out.note_cell(pos.row, pos.col, dst.glyph);
 
-                    if(src.width == 2 && pos.col < (new_cols - 1))
-                        new_buffer[pos.row * new_cols + pos.col + 1].chars[0] = widechar_continuation;
+                    if(src.width == 2 && pos.col < (new_cols - 1)) {
+                        out.cells(pos.row)[pos.col + 1].glyph = widechar_continuation;
+                        out.note_cell(pos.row, pos.col + 1, widechar_continuation);
+                    }
 
                     src_col++;
                     if(src_col >= old_cols) {
@@ -986,7 +2348,7 @@ void Screen::Impl::resize_buffer(int32_t bufidx, int32_t new_rows, int32_t new_c
                 }
 
                 for( ; pos.col < new_cols; pos.col++)
-                    clearcell(new_buffer[pos.row * new_cols + pos.col]);
+                    clearcell(out.cells(pos.row)[pos.col]);
             }
 
             if(active)
@@ -1004,7 +2366,8 @@ void Screen::Impl::resize_buffer(int32_t bufidx, int32_t new_rows, int32_t new_c
                 std::span(sb_buffer).first(static_cast<size_t>(old_cols)), continuation);
             if(!popresult)
                 break;
-            new_lineinfo[new_row].continuation = continuation;
+            out.lineinfo[new_row].continuation = continuation;
+            out.extent(new_row) = {};
 
             Pos pos{};
             pos.row = new_row;
@@ -1012,7 +2375,7 @@ void Screen::Impl::resize_buffer(int32_t bufidx, int32_t new_rows, int32_t new_c
                 int32_t w = sb_buffer[pos.col].width;
                 if(w < 1) w = 1;
                 ScreenCell& src = sb_buffer[pos.col];
-                InternalScreenCell& dst = new_buffer[pos.row * new_cols + pos.col];
+                InternalScreenCell& dst = out.cells(pos.row)[pos.col];
 
                 if(src.width == 2 && pos.col == new_cols - 1) {
                     clearcell(dst);
@@ -1020,16 +2383,19 @@ void Screen::Impl::resize_buffer(int32_t bufidx, int32_t new_rows, int32_t new_c
                     continue;
                 }
 
-                dst.chars = src.chars;
-                cell_attrs_to_pen(src, dst.pen, global_reverse);
+                dst.glyph = intern_glyph(src.chars);
+                dst.pen_id = cell_pen_id(src);
+                out.note_cell(pos.row, pos.col, dst.glyph);
 
-                if(src.width == 2 && pos.col < (new_cols - 1))
-                    new_buffer[pos.row * new_cols + pos.col + 1].chars[0] = widechar_continuation;
+                if(src.width == 2 && pos.col < (new_cols - 1)) {
+                    out.cells(pos.row)[pos.col + 1].glyph = widechar_continuation;
+                    out.note_cell(pos.row, pos.col + 1, widechar_continuation);
+                }
 
                 pos.col += w;
             }
             for( ; pos.col < new_cols; pos.col++)
-                clearcell(new_buffer[pos.row * new_cols + pos.col]);
+                clearcell(out.cells(pos.row)[pos.col]);
             new_row--;
 
             if(active)
@@ -1044,35 +2410,6 @@ void Screen::Impl::resize_buffer(int32_t bufidx, int32_t new_rows, int32_t new_c
         else
             backfill_simple();
     }
-
-    // ---- Phase 4: Scroll content to top and blank-fill bottom ----
-
-    if(new_row >= 0) {
-        int32_t moverows = new_rows - new_row - 1;
-        std::copy(new_buffer.begin() + (new_row + 1) * new_cols,
-            new_buffer.begin() + (new_row + 1 + moverows) * new_cols,
-            new_buffer.begin());
-        std::copy(new_lineinfo.begin() + new_row + 1,
-            new_lineinfo.begin() + new_row + 1 + moverows,
-            new_lineinfo.begin());
-
-        new_cursor.row -= (new_row + 1);
-        if(new_cursor.row < 0)
-            new_cursor.row = 0;
-
-        for(new_row = moverows; new_row < new_rows; new_row++) {
-            for(int32_t col = 0; col < new_cols; col++)
-                clearcell(new_buffer[new_row * new_cols + col]);
-            new_lineinfo[new_row] = LineInfo{};
-        }
-    }
-
-    buffers[bufidx] = std::move(new_buffer);
-
-    *statefields.lineinfos[bufidx] = std::move(new_lineinfo);
-
-    if(active)
-        statefields.pos = new_cursor;
 }
 
 // --- resize (StateCallbacks::on_resize implementation) ---
@@ -1084,6 +2421,11 @@ bool ScreenStateCallbacks::on_resize(int32_t new_rows, int32_t new_cols, StateFi
     int32_t old_rows = screen.rows;
     int32_t old_cols = screen.cols;
 
+    if(screen.pens.pens.size() >= screen.pen_compact_at)
+        screen.compact_pens();
+    if(screen.clusters.clusters.size() >= screen.cluster_compact_at)
+        screen.compact_clusters();
+
     if(new_cols > old_cols) {
         // Ensure that .sb_buffer is large enough for a new or old row
         screen.sb_buffer.resize(new_cols);
@@ -1104,6 +2446,7 @@ bool ScreenStateCallbacks::on_resize(int32_t new_rows, int32_t new_cols, StateFi
 
     screen.rows = new_rows;
     screen.cols = new_cols;
+    screen.reset_dirty_rows();
 
     if(new_cols <= old_cols) {
         screen.sb_buffer.resize(new_cols);
@@ -1130,7 +2473,11 @@ Screen::Impl::Impl(Terminal::Impl& vt_ref)
     damaged.start_row = no_damage_row;
     pending_scrollrect.start_row = no_damage_row;
 
+    update_pen_id();
+    reset_dirty_rows();
     buffers[bufidx_primary] = alloc_buffer(rows, cols);
+    reset_row_index(bufidx_primary, rows);
+    row_extents[bufidx_primary].assign(rows, RowExtent{});
     buffer_idx = bufidx_primary;
 
     sb_buffer.resize(cols);
@@ -1177,14 +2524,35 @@ size_t Screen::Impl::get_chars_impl(std::span<T> buf, Rect rect) const {
     };
 
     for(int32_t row = rect.start_row; row < rect.end_row; row++) {
-        for(int32_t col = rect.start_col; col < rect.end_col; col++) {
+        // Cells past the row's last non-blank one would only be padding
+        bool in_screen = row >= 0 && row < rows;
+        int32_t end_col = in_screen ? std::min(rect.end_col, row_extent(row).end) : rect.end_col;
+
+        if(in_screen && row_extent(row).ascii && rect.start_col >= 0 && end_col > rect.start_col) {
+            // One unit per cell: copy the glyphs straight out, blanks as spaces
+            const InternalScreenCell* cells = getcell(row, 0);
+            while(end_col > rect.start_col && cells[end_col - 1].glyph == 0)
+                end_col--;
+            auto count = static_cast<size_t>(end_col - rect.start_col);
+            if(!buf.empty() && outpos < buf.size()) {
+                size_t fit = std::min(count, buf.size() - outpos);
+                for(size_t i = 0; i < fit; i++) {
+                    uint32_t glyph = cells[rect.start_col + i].glyph;
+                    buf[outpos + i] = static_cast<T>(glyph ? glyph : unicode_space);
+                }
+            }
+            outpos += count;
+            end_col = rect.start_col;
+        }
+
+        for(int32_t col = rect.start_col; col < end_col; col++) {
             const InternalScreenCell* cell = getcell(row, col);
             if(!cell) continue;
 
-            if(cell->chars[0] == 0)
+            if(cell->glyph == 0)
                 // Erased cell, might need a space
                 padding++;
-            else if(cell->chars[0] == widechar_continuation)
+            else if(cell->glyph == widechar_continuation)
                 // Gap behind a double-width char, do nothing
                 ;
             else {
@@ -1192,8 +2560,12 @@ size_t Screen::Impl::get_chars_impl(std::span<T> buf, Rect rect) const {
                     put(unicode_space);
                     padding--;
                 }
-                for(int32_t i = 0; i < max_chars_per_cell && cell->chars[i]; i++) {
-                    put(cell->chars[i]);
+                if(is_cluster(cell->glyph)) {
+                    for(uint32_t c : clusters[cell->glyph])
+                        put(c);
+                }
+                else {
+                    put(cell->glyph);
                 }
             }
         }
@@ -1215,36 +2587,171 @@ namespace {
     return to_underlying(mask & flag) != 0;
 }
 
-[[nodiscard]] constexpr bool attrs_differ(AttrMask attrs, const InternalScreenCell& a, const InternalScreenCell& b) {
-    if(has_attr(attrs, AttrMask::Bold)       && (a.pen.bold      != b.pen.bold))      return true;
-    if(has_attr(attrs, AttrMask::Underline)  && (a.pen.underline  != b.pen.underline)) return true;
-    if(has_attr(attrs, AttrMask::Italic)     && (a.pen.italic     != b.pen.italic))    return true;
-    if(has_attr(attrs, AttrMask::Blink)      && (a.pen.blink      != b.pen.blink))     return true;
-    if(has_attr(attrs, AttrMask::Reverse)    && (a.pen.reverse    != b.pen.reverse))   return true;
-    if(has_attr(attrs, AttrMask::Conceal)    && (a.pen.conceal    != b.pen.conceal))   return true;
-    if(has_attr(attrs, AttrMask::Strike)     && (a.pen.strike     != b.pen.strike))    return true;
-    if(has_attr(attrs, AttrMask::Font)       && (a.pen.font       != b.pen.font))      return true;
-    if(has_attr(attrs, AttrMask::Foreground) && a.pen.fg != b.pen.fg)  return true;
-    if(has_attr(attrs, AttrMask::Background) && a.pen.bg != b.pen.bg)  return true;
-    if(has_attr(attrs, AttrMask::Small)      && (a.pen.small      != b.pen.small))     return true;
-    if(has_attr(attrs, AttrMask::Baseline)   && (a.pen.baseline   != b.pen.baseline))  return true;
+[[nodiscard]] constexpr bool attrs_differ(AttrMask attrs, const ScreenPen& a, const ScreenPen& b) {
+    if(has_attr(attrs, AttrMask::Bold)       && (a.bold      != b.bold))      return true;
+    if(has_attr(attrs, AttrMask::Underline)  && (a.underline  != b.underline)) return true;
+    if(has_attr(attrs, AttrMask::Italic)     && (a.italic     != b.italic))    return true;
+    if(has_attr(attrs, AttrMask::Blink)      && (a.blink      != b.blink))     return true;
+    if(has_attr(attrs, AttrMask::Reverse)    && (a.reverse    != b.reverse))   return true;
+    if(has_attr(attrs, AttrMask::Conceal)    && (a.conceal    != b.conceal))   return true;
+    if(has_attr(attrs, AttrMask::Strike)     && (a.strike     != b.strike))    return true;
+    if(has_attr(attrs, AttrMask::Font)       && (a.font       != b.font))      return true;
+    if(has_attr(attrs, AttrMask::Foreground) && a.fg != b.fg)  return true;
+    if(has_attr(attrs, AttrMask::Background) && a.bg != b.bg)  return true;
+    if(has_attr(attrs, AttrMask::Small)      && (a.small      != b.small))     return true;
+    if(has_attr(attrs, AttrMask::Baseline)   && (a.baseline   != b.baseline))  return true;
 
     return false;
 }
 
+// Interned pens are unique, so equal ids short-circuit the field compare
+[[nodiscard]] bool attrs_differ(AttrMask attrs, const PenTable& pens, PenId a, PenId b) {
+    return a != b && attrs_differ(attrs, pens[a], pens[b]);
+}
+
 } // anonymous namespace
 
-// --- reset_default_colours ---
+// --- get_row_runs ---
+
+bool Screen::Impl::get_row_runs(int32_t row, RunSink& sink) {
+    const InternalScreenCell* cells = std::as_const(*this).getcell(row, 0);
+    if(!cells)
+        return false;
+
+    int32_t start = 0;
+    run_text.clear();
+
+    auto emit = [&](int32_t end, PenId pen_id) {
+        ScreenRun run{.start_col = start, .cols = end - start, .text = run_text};
+        const ScreenPen& runpen = pens[pen_id];
+        pen_to_attrs(runpen, run.attrs, global_reverse);
+        run.fg = runpen.fg;
+        run.bg = runpen.bg;
+        return sink.on_run(run);
+    };
 
-void Screen::Impl::reset_default_colours(std::span<InternalScreenCell> buf) {
-    for(int32_t row = 0; row < rows; row++)
-        for(int32_t col = 0; col < cols; col++) {
-            InternalScreenCell& cell = buf[row * cols + col];
-            if(cell.pen.fg.is_default_fg())
-                cell.pen.fg = pen.fg;
-            if(cell.pen.bg.is_default_bg())
-                cell.pen.bg = pen.bg;
+    if(row_extent(row).blank) {
+        run_text.assign(static_cast<size_t>(cols), ' ');
+        (void)emit(cols, cells->pen_id);
+        return true;
+    }
+
+    auto put = [&](uint32_t c) {
+        if(c < utf8_max_1byte) {
+            run_text += static_cast<char>(c);
+            return;
+        }
+        std::array<char, utf8_max_seqlen> bytes{};
+        run_text.append(bytes.data(), fill_utf8(c, bytes));
+    };
+
+    for(int32_t col = 0; col < cols; col++) {
+        const InternalScreenCell& cell = cells[col];
+        // A wide char stays in one run with its right half
+        if(col > start && cell.glyph != widechar_continuation &&
+           attrs_differ(AttrMask::All, pens, cells[start].pen_id, cell.pen_id)) {
+            if(!emit(col, cells[start].pen_id))
+                return true;
+            start = col;
+            run_text.clear();
         }
+
+        if(cell.glyph == 0)
+            put(unicode_space);
+        else if(cell.glyph == widechar_continuation)
+            ;
+        else if(is_cluster(cell.glyph))
+            for(uint32_t c : clusters[cell.glyph])
+                put(c);
+        else
+            put(cell.glyph);
+    }
+
+    (void)emit(cols, cells[start].pen_id);
+    return true;
+}
+
+// --- reset_default_colours ---
+
+void Screen::Impl::reset_default_colours() {
+    // Every cell in both buffers refers into the table, so rewriting the
+    // pens recolours them all
+    for(ScreenPen& p : pens.pens) {
+        if(p.fg.is_default_fg())
+            p.fg = pen.fg;
+        if(p.bg.is_default_bg())
+            p.bg = pen.bg;
+    }
+    pens.rebuild_ids();
+    update_pen_id();
+}
+
+// --- pen table ---
+
+void Screen::Impl::update_pen_id() {
+    pen_id = pens.intern(pen);
+}
+
+PenId Screen::Impl::pen_id_with(uint32_t protected_cell, uint32_t dwl, uint32_t dhl) {
+    if(!protected_cell && !dwl && !dhl)
+        return pen_id;
+    ScreenPen flagged = pen;
+    flagged.protected_cell = protected_cell;
+    flagged.dwl            = dwl;
+    flagged.dhl            = dhl;
+    return pens.intern(flagged);
+}
+
+uint32_t Screen::Impl::intern_glyph(std::span<const uint32_t> chars) {
+    // Expanded ScreenCell chars are zero-terminated
+    auto len = static_cast<size_t>(std::ranges::find(chars, 0u) - chars.begin());
+    if(len <= 1)
+        return len ? chars[0] : 0;
+    return clusters.intern(chars.first(std::min(len, max_cluster_chars)));
+}
+
+void Screen::Impl::compact_clusters() {
+    ClusterTable live;
+    for(auto& buf : buffers)
+        for(InternalScreenCell& cell : buf)
+            if(is_cluster(cell.glyph))
+                cell.glyph = live.intern(clusters[cell.glyph]);
+
+    clusters = std::move(live);
+    cluster_compact_at = std::max(cluster_compact_min, clusters.clusters.size() * 2);
+}
+
+void Screen::Impl::compact_pens() {
+    constexpr PenId unused = std::numeric_limits<PenId>::max();
+
+    std::vector<PenId> remap(pens.pens.size(), unused);
+    remap[pen_id] = 0;
+    for(const auto& buf : buffers)
+        for(const InternalScreenCell& cell : buf)
+            remap[cell.pen_id] = 0;
+    for(const auto& extents : row_extents)
+        for(const RowExtent& extent : extents)
+            remap[extent.blank_cell.pen_id] = 0;
+
+    std::vector<ScreenPen> live;
+    for(size_t id = 0; id < remap.size(); id++) {
+        if(remap[id] == unused)
+            continue;
+        remap[id] = static_cast<PenId>(live.size());
+        live.push_back(pens.pens[id]);
+    }
+
+    for(auto& buf : buffers)
+        for(InternalScreenCell& cell : buf)
+            cell.pen_id = remap[cell.pen_id];
+    for(auto& extents : row_extents)
+        for(RowExtent& extent : extents)
+            extent.blank_cell.pen_id = remap[extent.blank_cell.pen_id];
+    pen_id = remap[pen_id];
+
+    pens.pens = std::move(live);
+    pens.rebuild_ids();
+    pen_compact_at = std::max(pen_compact_min, pens.pens.size() * 2);
 }
 
 // ============================================================
@@ -1273,6 +2780,8 @@ void Screen::enable_altscreen(bool enabled) {
         int32_t cols = impl_->vt.cols;
 
         impl_->buffers[bufidx_altscreen] = impl_->alloc_buffer(rows, cols);
+        impl_->reset_row_index(bufidx_altscreen, rows);
+        impl_->row_extents[bufidx_altscreen].assign(rows, RowExtent{});
     }
 }
 
@@ -1280,15 +2789,29 @@ void Screen::enable_reflow(bool enabled) {
     impl_->reflow = enabled;
 }
 
+void Screen::enable_direct_scrollback(bool enabled) {
+    impl_->direct_scrollback = enabled;
+}
+
 void Screen::set_damage_merge(DamageSize size) {
     flush_damage();
     impl_->damage_merge = size;
 }
 
 void Screen::flush_damage() {
+    // A synchronized frame stays held unless it has run out of time
+    if(impl_->sync_held) {
+        impl_->check_sync_budget();
+        return;
+    }
     impl_->flush_damage_impl();
 }
 
+void Screen::set_sync_output_budget(size_t max_bytes, std::chrono::milliseconds timeout) {
+    impl_->sync_max_bytes = max_bytes;
+    impl_->sync_timeout = timeout;
+}
+
 void Screen::reset(bool hard) {
     impl_->damaged.start_row = no_damage_row;
     impl_->pending_scrollrect.start_row = no_damage_row;
@@ -1296,10 +2819,32 @@ void Screen::reset(bool hard) {
     flush_damage();
 }
 
+Screen::DirtyRows Screen::collect_dirty_rows(uint64_t since_generation, std::span<int32_t> rows) {
+    return impl_->collect_dirty_rows(since_generation, rows);
+}
+
+ScreenSnapshot Screen::snapshot() {
+    return impl_->snapshot();
+}
+
 bool Screen::get_cell(Pos pos, ScreenCell& cell) const {
     return impl_->get_cell_impl(pos, cell);
 }
 
+bool Screen::get_cell_glyph(Pos pos, uint32_t& glyph) const {
+    const InternalScreenCell* cell = impl()->getcell(pos.row, pos.col);
+    if(!cell)
+        return false;
+    glyph = cell->glyph;
+    return true;
+}
+
+std::span<const uint32_t> Screen::get_cluster(uint32_t glyph) const {
+    if(!is_cluster(glyph) || (glyph & ~glyph_cluster_flag) >= impl_->clusters.clusters.size())
+        return {};
+    return impl_->clusters[glyph];
+}
+
 size_t Screen::get_chars(std::span<uint32_t> chars, Rect rect) const {
     return impl_->get_chars_impl(chars, rect);
 }
@@ -1309,7 +2854,7 @@ size_t Screen::get_text(std::span<char> str, Rect rect) const {
 }
 
 bool Screen::get_attrs_extent(Rect& extent, Pos pos, AttrMask attrs) const {
-    auto* target_ptr = impl_->getcell(pos.row, pos.col);
+    auto* target_ptr = impl()->getcell(pos.row, pos.col);
     if(!target_ptr)
         return false;
     const auto& target = *target_ptr;
@@ -1325,15 +2870,15 @@ bool Screen::get_attrs_extent(Rect& extent, Pos pos, AttrMask attrs) const {
     int32_t col;
 
     for(col = pos.col - 1; col >= extent.start_col; col--) {
-        const InternalScreenCell* c = impl_->getcell(pos.row, col);
-        if(!c || attrs_differ(attrs, target, *c))
+        const InternalScreenCell* c = impl()->getcell(pos.row, col);
+        if(!c || attrs_differ(attrs, impl_->pens, target.pen_id, c->pen_id))
             break;
     }
     extent.start_col = col + 1;
 
     for(col = pos.col + 1; col < extent.end_col; col++) {
-        const InternalScreenCell* c = impl_->getcell(pos.row, col);
-        if(!c || attrs_differ(attrs, target, *c))
+        const InternalScreenCell* c = impl()->getcell(pos.row, col);
+        if(!c || attrs_differ(attrs, impl_->pens, target.pen_id, c->pen_id))
             break;
     }
     extent.end_col = col;
@@ -1341,14 +2886,17 @@ bool Screen::get_attrs_extent(Rect& extent, Pos pos, AttrMask attrs) const {
     return true;
 }
 
+bool Screen::get_row_runs(int32_t row, RunSink& sink) {
+    return impl_->get_row_runs(row, sink);
+}
+
 bool Screen::is_eol(Pos pos) const {
     // This cell is EOL if this and every cell to the right is blank
-    for(; pos.col < impl_->cols; pos.col++) {
-        const InternalScreenCell* cell = impl_->getcell(pos.row, pos.col);
-        if(!cell || cell->chars[0] != 0)
-            return false;
-    }
-    return true;
+    if(pos.col >= impl_->cols)
+        return true;
+    if(!impl()->getcell(pos.row, pos.col))
+        return false;
+    return pos.col >= impl_->row_extent(pos.row).end;
 }
 
 void Screen::convert_color_to_rgb(Color& col) const {
@@ -1376,9 +2924,59 @@ void Screen::set_default_colors(const Color& default_fg, const Color& default_bg
                             | color_type::default_bg;
     }
 
-    impl_->reset_default_colours(impl_->buffers[0]);
-    if(!impl_->buffers[1].empty())
-        impl_->reset_default_colours(impl_->buffers[1]);
+    impl_->reset_default_colours();
+    impl_->mark_all_dirty();
+}
+
+// --- ScreenSnapshot public API ---
+
+int32_t ScreenSnapshot::rows() const {
+    return impl_ ? impl_->rows : 0;
+}
+
+int32_t ScreenSnapshot::cols() const {
+    return impl_ ? impl_->cols : 0;
+}
+
+bool ScreenSnapshot::get_cell(Pos pos, ScreenCell& cell) const {
+    if(!impl_ || pos.row < 0 || pos.row >= impl_->rows || pos.col < 0 || pos.col >= impl_->cols)
+        return false;
+    cell = (*impl_->lines[pos.row])[pos.col];
+    return true;
+}
+
+std::span<const ScreenCell> ScreenSnapshot::get_row(int32_t row) const {
+    if(!impl_ || row < 0 || row >= impl_->rows)
+        return {};
+    return *impl_->lines[row];
+}
+
+LineInfo ScreenSnapshot::get_lineinfo(int32_t row) const {
+    if(!impl_ || row < 0 || row >= impl_->rows)
+        return {};
+    return impl_->lineinfos[row];
+}
+
+Pos ScreenSnapshot::cursor_pos() const {
+    return impl_ ? impl_->cursor_pos : Pos{};
+}
+
+bool ScreenSnapshot::cursor_visible() const {
+    return impl_ && impl_->cursor_visible;
+}
+
+bool ScreenSnapshot::cursor_blink() const {
+    return impl_ && impl_->cursor_blink;
+}
+
+CursorShape ScreenSnapshot::cursor_shape() const {
+    return impl_ ? impl_->cursor_shape : CursorShape::Block;
+}
+
+void ScreenSnapshot::convert_color_to_rgb(Color& col) const {
+    if(col.is_indexed() && impl_)
+        col = (*impl_->palette)[col.indexed.idx];
+    col.type &= color_type::type_mask;
 }
 
 } // namespace vterm
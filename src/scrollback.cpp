@@ -1,141 +1,703 @@
 #include "scrollback_impl.h"
+#include "utf8.h"
 
 #include <algorithm>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <utility>
 
 namespace vterm {
 
-// --- Scrollback::Impl method definitions ---
+// --- Row encoding ---
+//
+// A row is laid out as:
+//   varint cols, varint text_cells, flags byte
+//   text:   chars[0] of the first text_cells cells (UTF-8, see put_glyph)
+//   runs:   (varint length, CellAttrs, fg, bg) until all cols are covered
+//   extras: (varint index + 1, width, count, glyphs...) for cells whose width
+//           or combining chars cannot be inferred from the text; 0 ends
+// Cells past text_cells are blank with width 1.
 
-void Scrollback::Impl::push_line(std::span<const ScreenCell> cells, bool continuation) {
-    Line line;
-    line.cells.assign(cells.begin(), cells.end());
-    line.continuation = continuation;
+namespace {
 
-    lines.push_back(std::move(line));
-    enforce_capacity();
+inline constexpr uint8_t row_continuation = 0x01;
+inline constexpr uint8_t row_wide         = 0x02;
+
+// Text bytes that cannot start a UTF-8 sequence mark the non-codepoint glyphs
+inline constexpr uint8_t text_continuation = 0xff;  // glyph_continuation
+inline constexpr uint8_t text_raw          = 0xfe;  // 4 raw bytes follow
+
+inline constexpr size_t style_size = sizeof(CellAttrs) + 2 * sizeof(Color);
+
+// Upper bounds on encoded sizes, so encoding can write through a pointer
+inline constexpr size_t max_varint_size = (sizeof(size_t) * 8 + 6) / 7;
+inline constexpr size_t max_glyph_size  = utf8_max_seqlen;
+inline constexpr size_t max_cell_size   = max_glyph_size +                                 // text
+                                          max_varint_size + style_size +                   // run
+                                          max_varint_size + 2 + max_chars_per_cell * max_glyph_size;  // extra
+
+const ScreenCell blank_cell{.width = 1};
+
+void put_varint(char*& out, size_t value) {
+    while(value >= 0x80) {
+        *out++ = static_cast<char>(0x80 | (value & 0x7f));
+        value >>= 7;
+    }
+    *out++ = static_cast<char>(value);
 }
 
-bool Scrollback::Impl::pop_line(std::span<ScreenCell> cells, bool& continuation) {
-    if(lines.empty())
-        return false;
+[[nodiscard]] size_t get_varint(const char*& p) {
+    size_t value = 0;
+    for(int32_t shift = 0; ; shift += 7) {
+        auto byte = static_cast<uint8_t>(*p++);
+        value |= static_cast<size_t>(byte & 0x7f) << shift;
+        if(!(byte & 0x80))
+            return value;
+    }
+}
+
+void put_glyph(char*& out, uint32_t glyph) {
+    if(glyph < utf8_max_1byte) {
+        *out++ = static_cast<char>(glyph);
+    }
+    else if(glyph == glyph_continuation) {
+        *out++ = static_cast<char>(text_continuation);
+    }
+    else if(glyph > static_cast<uint32_t>(std::numeric_limits<int32_t>::max())) {
+        *out++ = static_cast<char>(text_raw);
+        for(int32_t b = 0; b < 4; b++)
+            *out++ = static_cast<char>(glyph >> (b * 8));
+    }
+    else {
+        out += fill_utf8(static_cast<int32_t>(glyph), std::span(out, max_glyph_size));
+    }
+}
+
+[[nodiscard]] uint32_t get_glyph(const char*& p) {
+    auto lead = static_cast<uint8_t>(*p++);
+    if(lead < utf8_max_1byte)
+        return lead;
+    if(lead == text_continuation)
+        return glyph_continuation;
+    if(lead == text_raw) {
+        uint32_t glyph = 0;
+        for(int32_t b = 0; b < 4; b++)
+            glyph |= static_cast<uint32_t>(static_cast<uint8_t>(*p++)) << (b * 8);
+        return glyph;
+    }
+
+    int32_t len = lead >= 0xfc ? 6 : lead >= 0xf8 ? 5 : lead >= 0xf0 ? 4 : lead >= 0xe0 ? 3 : 2;
+    uint32_t glyph = lead & utf8_lead_mask[len];
+    for(int32_t b = 1; b < len; b++)
+        glyph = (glyph << 6) | (static_cast<uint8_t>(*p++) & utf8_continuation_mask);
+    return glyph;
+}
+
+[[nodiscard]] bool is_blank(const ScreenCell& cell) {
+    return cell.chars[0] == 0 && cell.width == 1 && std::ranges::all_of(cell.chars, [](uint32_t c) { return c == 0; });
+}
+
+
+[[nodiscard]] bool same_style(const ScreenCell& a, const ScreenCell& b) {
+    // Identical bytes are the common case; otherwise compare the fields, which
+    // ignores bitfield padding and unused Color bytes
+    if(std::memcmp(&a.attrs, &b.attrs, sizeof(CellAttrs)) == 0 &&
+       std::memcmp(&a.fg, &b.fg, sizeof(Color)) == 0 &&
+       std::memcmp(&a.bg, &b.bg, sizeof(Color)) == 0)
+        return true;
+    return a.attrs.bold == b.attrs.bold && a.attrs.underline == b.attrs.underline &&
+           a.attrs.italic == b.attrs.italic && a.attrs.blink == b.attrs.blink &&
+           a.attrs.reverse == b.attrs.reverse && a.attrs.conceal == b.attrs.conceal &&
+           a.attrs.strike == b.attrs.strike && a.attrs.font == b.attrs.font &&
+           a.attrs.dwl == b.attrs.dwl && a.attrs.dhl == b.attrs.dhl &&
+           a.attrs.small == b.attrs.small && a.attrs.baseline == b.attrs.baseline &&
+           a.fg == b.fg && a.bg == b.bg;
+}
+
+void put_style(char*& out, const ScreenCell& cell) {
+    std::memcpy(out, &cell.attrs, sizeof(CellAttrs));
+    std::memcpy(out + sizeof(CellAttrs), &cell.fg, sizeof(Color));
+    std::memcpy(out + sizeof(CellAttrs) + sizeof(Color), &cell.bg, sizeof(Color));
+    out += style_size;
+}
+
+void get_style(const char*& p, ScreenCell& cell) {
+    std::memcpy(&cell.attrs, p, sizeof(CellAttrs));
+    std::memcpy(&cell.fg, p + sizeof(CellAttrs), sizeof(Color));
+    std::memcpy(&cell.bg, p + sizeof(CellAttrs) + sizeof(Color), sizeof(Color));
+    p += style_size;
+}
 
-    const auto& line = lines.back();
-    const size_t copy_cols = std::min(cells.size(), line.cells.size());
+// Encodes `cells`, padded with blanks to `cols`, into `out` and returns the
+// encoded size. `out` only ever grows.
+size_t encode_row(std::vector<char>& out, std::span<const ScreenCell> cells, size_t cols, bool continuation) {
+    auto cell_at = [&](size_t i) -> const ScreenCell& { return i < cells.size() ? cells[i] : blank_cell; };
 
-    std::copy_n(line.cells.begin(), copy_cols, cells.begin());
+    size_t text_cells = std::min(cells.size(), cols);
+    while(text_cells > 0 && is_blank(cells[text_cells - 1]))
+        text_cells--;
 
-    for(size_t i = copy_cols; i < cells.size(); ++i) {
-        cells[i] = ScreenCell{};
+    if(out.size() < 2 * max_varint_size + 1 + (cols + 1) * max_cell_size)
+        out.resize(2 * max_varint_size + 1 + (cols + 1) * max_cell_size);
+    char* p = out.data();
+
+    put_varint(p, cols);
+    put_varint(p, text_cells);
+    char* flags = p++;
+
+    bool any_extras = false;
+    bool wide = false;
+    for(size_t i = 0; i < text_cells; i++) {
+        uint32_t glyph = cells[i].chars[0];
+        any_extras |= cells[i].width != 1 || cells[i].chars[1] != 0 || glyph == glyph_continuation;
+        wide |= cells[i].width > 1;
+        put_glyph(p, glyph);
+    }
+    *flags = static_cast<char>((continuation ? row_continuation : 0) | (wide ? row_wide : 0));
+
+    for(size_t start = 0; start < cols; ) {
+        const ScreenCell& style = cell_at(start);
+        size_t end = start + 1;
+        size_t span_end = std::min(cols, cells.size());
+        while(end < span_end && same_style(style, cells[end]))
+            end++;
+        if(end >= span_end)
+            while(end < cols && same_style(style, blank_cell))
+                end++;
+        put_varint(p, end - start);
+        put_style(p, style);
+        start = end;
+    }
+
+    // A wide glyph shows up as a following glyph_continuation; combining chars
+    // past chars[1] are only looked for when chars[1] is set
+    for(size_t i = 0; any_extras && i < text_cells; i++) {
+        const ScreenCell& cell = cells[i];
+        int32_t width = (i + 1 < text_cells && cells[i + 1].chars[0] == glyph_continuation) ? 2 : 1;
+        if(cell.width == width && cell.chars[1] == 0)
+            continue;
+
+        size_t more = cell.chars.size() - 1;
+        while(more > 0 && cell.chars[more] == 0)
+            more--;
+
+        put_varint(p, i + 1);
+        *p++ = static_cast<char>(cell.width);
+        *p++ = static_cast<char>(more);
+        for(size_t c = 1; c <= more; c++)
+            put_glyph(p, cell.chars[c]);
+    }
+    put_varint(p, 0);
+
+    return static_cast<size_t>(p - out.data());
+}
+
+// encode_row() for a row of ASCII glyphs and blanks in two styles, without
+// going through ScreenCells
+size_t encode_ascii_row(std::vector<char>& out, std::string_view chars, const ScreenCell& glyph_style,
+                        const ScreenCell& blank_style, bool continuation) {
+    size_t cols = chars.size();
+    size_t text_cells = cols;
+    while(text_cells > 0 && chars[text_cells - 1] == 0)
+        text_cells--;
+
+    if(out.size() < 2 * max_varint_size + 1 + (cols + 1) * max_cell_size)
+        out.resize(2 * max_varint_size + 1 + (cols + 1) * max_cell_size);
+    char* p = out.data();
+
+    put_varint(p, cols);
+    put_varint(p, text_cells);
+    *p++ = static_cast<char>(continuation ? row_continuation : 0);
+
+    std::memcpy(p, chars.data(), text_cells);
+    p += text_cells;
+
+    bool one_style = same_style(glyph_style, blank_style);
+    for(size_t start = 0; start < cols; ) {
+        bool glyph = chars[start] != 0;
+        size_t end = start + 1;
+        while(end < cols && (one_style || (chars[end] != 0) == glyph))
+            end++;
+        put_varint(p, end - start);
+        put_style(p, glyph ? glyph_style : blank_style);
+        start = end;
+    }
+    put_varint(p, 0);
+
+    return static_cast<size_t>(p - out.data());
+}
+
+// Start of each row when `content` is wrapped at `cols`: a wide glyph that
+// would straddle the edge moves to the next row. Empty content is one row.
+void wrap_offsets(std::span<const ScreenCell> content, size_t cols, std::vector<size_t>& starts) {
+    starts.clear();
+    size_t offset = 0;
+    do {
+        starts.push_back(offset);
+        size_t chunk = std::min(cols, content.size() - offset);
+        if(chunk > 1 && chunk == cols && offset + chunk < content.size() &&
+           content[offset + chunk - 1].width > 1)
+            chunk--;
+        offset += chunk;
+    } while(offset < content.size());
+}
+
+[[nodiscard]] ScrollbackStore::RowInfo row_info(const char* p) {
+    ScrollbackStore::RowInfo info;
+    info.cols = get_varint(p);
+    info.text_cells = get_varint(p);
+    info.continuation = (static_cast<uint8_t>(*p) & row_continuation) != 0;
+    info.wide = (static_cast<uint8_t>(*p) & row_wide) != 0;
+    return info;
+}
+
+// Decodes the row encoded at `p` into `cells`, padding past its width with
+// blanks
+void decode_row(const char* p, std::span<ScreenCell> cells, bool& continuation) {
+
+    size_t cols = get_varint(p);
+    size_t text_cells = get_varint(p);
+    continuation = (static_cast<uint8_t>(*p++) & row_continuation) != 0;
+    size_t n = std::min(cols, cells.size());
+
+    for(size_t i = 0; i < text_cells; i++) {
+        uint32_t glyph = get_glyph(p);
+        if(i < n) {
+            cells[i].chars = {};
+            cells[i].chars[0] = glyph;
+            cells[i].width = 1;
+        }
+        if(glyph == glyph_continuation && i > 0 && i - 1 < n)
+            cells[i - 1].width = 2;
+    }
+    for(size_t i = text_cells; i < n; i++) {
+        cells[i].chars = {};
         cells[i].width = 1;
     }
 
-    continuation = line.continuation;
-    lines.pop_back();
+    for(size_t start = 0; start < cols; ) {
+        size_t len = get_varint(p);
+        ScreenCell style;
+        get_style(p, style);
+        for(size_t i = start; i < std::min(start + len, n); i++) {
+            cells[i].attrs = style.attrs;
+            cells[i].fg = style.fg;
+            cells[i].bg = style.bg;
+        }
+        start += len;
+    }
 
-    return true;
+    while(size_t index1 = get_varint(p)) {
+        size_t i = index1 - 1;
+        auto width = static_cast<int8_t>(*p++);
+        auto more = static_cast<uint8_t>(*p++);
+        if(i < n)
+            cells[i].width = width;
+        for(size_t c = 1; c <= more; c++) {
+            uint32_t glyph = get_glyph(p);
+            if(i < n && c < cells[i].chars.size())
+                cells[i].chars[c] = glyph;
+        }
+    }
+
+    for(size_t i = n; i < cells.size(); i++)
+        cells[i] = blank_cell;
 }
 
-void Scrollback::Impl::clear() {
-    lines.clear();
-    push_track_start = 0;
-    push_track_count = 0;
-    sb_before_resize = 0;
+} // anonymous namespace
+
+// --- ScrollbackStore ---
+
+void ScrollbackStore::push_back(std::span<const ScreenCell> cells, size_t cols, bool continuation) {
+    append_scratch(encode_row(scratch, cells, cols, continuation));
 }
 
-void Scrollback::Impl::reflow(int32_t new_cols) {
-    if(lines.empty() || new_cols <= 0)
-        return;
+void ScrollbackStore::push_back_ascii(std::string_view chars, const ScreenCell& glyph_style,
+                                      const ScreenCell& blank_style, bool continuation) {
+    append_scratch(encode_ascii_row(scratch, chars, glyph_style, blank_style, continuation));
+}
+
+// Stores the `need` bytes encoded at the start of scratch as the newest row
+void ScrollbackStore::append_scratch(size_t need) {
+    if(blocks.empty() || blocks.back().data.size() - blocks.back().used < need) {
+        Block block;
+        if(!spare.empty() && spare.back().data.size() >= need) {
+            block = std::move(spare.back());
+            spare.pop_back();
+        }
+        else {
+            block.data.resize(std::max(block_size, need));
+        }
+        block.used = 0;
+        block.live = 0;
+        blocks.push_back(std::move(block));
+    }
+
+    Block& block = blocks.back();
+    std::memcpy(block.data.data() + block.used, scratch.data(), need);
+
+    if(count == rows.size()) {
+        std::vector<RowRef> grown(std::max<size_t>(64, rows.size() * 2));
+        for(size_t i = 0; i < count; i++)
+            grown[i] = row(i);
+        std::swap(rows, grown);
+        if(pinned)
+            retired.push_back(std::move(grown));
+        head = 0;
+    }
+
+    row(count) = RowRef{
+        .block  = first_block + static_cast<uint32_t>(blocks.size() - 1),
+        .offset = static_cast<uint32_t>(block.used),
+    };
+    count++;
+    block.used += need;
+    block.live++;
+}
+
+void ScrollbackStore::pop_front() {
+    RowRef ref = row(0);
+    head = (head + 1) & (rows.size() - 1);
+    count--;
+    release(ref);
+}
+
+void ScrollbackStore::pop_back() {
+    RowRef ref = row(count - 1);
+    count--;
+    release(ref);
+
+    // The newest row is always last in its block; reuse its space
+    if(!blocks.empty() && ref.block - first_block == blocks.size() - 1)
+        blocks.back().used = ref.offset;
+}
+
+void ScrollbackStore::erase(size_t first, size_t last) {
+    for(size_t i = first; i < last; i++)
+        release(row(i));
+
+    size_t n = last - first;
+    for(size_t i = first; i + n < count; i++)
+        row(i) = row(i + n);
+    count -= n;
+}
+
+void ScrollbackStore::clear() {
+    while(!blocks.empty()) {
+        recycle(std::move(blocks.back()));
+        blocks.pop_back();
+    }
+    rows = {};
+    head = 0;
+    count = 0;
+}
+
+void ScrollbackStore::release(const RowRef& ref) {
+    block_of(ref).live--;
+
+    while(blocks.size() > 1 && blocks.front().live == 0) {
+        recycle(std::move(blocks.front()));
+        blocks.pop_front();
+        first_block++;
+    }
+    while(blocks.size() > 1 && blocks.back().live == 0) {
+        recycle(std::move(blocks.back()));
+        blocks.pop_back();
+    }
+    if(blocks.size() == 1 && blocks.front().live == 0)
+        blocks.front().used = 0;
+}
+
+void ScrollbackStore::recycle(Block&& block) {
+    if(spare.empty() && block.data.size() == block_size)
+        spare.push_back(std::move(block));
+}
+
+ScrollbackStore::RowInfo ScrollbackStore::info(size_t index) const {
+    const RowRef& ref = row(index);
+    return row_info(block_of(ref).data.data() + ref.offset);
+}
+
+size_t ScrollbackStore::cols(size_t index) const {
+    const RowRef& ref = row(index);
+    const char* p = block_of(ref).data.data() + ref.offset;
+    return get_varint(p);
+}
+
+void ScrollbackStore::decode(size_t index, std::span<ScreenCell> cells, bool& continuation) const {
+    const RowRef& ref = row(index);
+    decode_row(block_of(ref).data.data() + ref.offset, cells, continuation);
+}
+
+ScrollbackStore::View ScrollbackStore::pin() {
+    View view;
+    view.ring = rows.data();
+    view.mask = rows.size() - 1;
+    view.head = head;
+    view.first_block = first_block;
+    view.block_data.reserve(blocks.size());
+    for(const Block& block : blocks)
+        view.block_data.push_back(block.data.data());
+    pinned = true;
+    return view;
+}
+
+void ScrollbackStore::unpin() {
+    pinned = false;
+    retired.clear();
+}
+
+const char* ScrollbackStore::View::row_data(size_t index) const {
+    const RowRef& ref = ring[(head + index) & mask];
+    return block_data[ref.block - first_block] + ref.offset;
+}
+
+ScrollbackStore::RowInfo ScrollbackStore::View::info(size_t index) const {
+    return row_info(row_data(index));
+}
+
+size_t ScrollbackStore::View::cols(size_t index) const {
+    const char* p = row_data(index);
+    return get_varint(p);
+}
+
+void ScrollbackStore::View::decode(size_t index, std::span<ScreenCell> cells, bool& continuation) const {
+    decode_row(row_data(index), cells, continuation);
+}
+
+size_t ScrollbackStore::memory_usage() const {
+    size_t bytes = rows.capacity() * sizeof(RowRef) + scratch.capacity();
+    for(const Block& block : blocks)
+        bytes += block.data.capacity();
+    for(const Block& block : spare)
+        bytes += block.data.capacity();
+    return bytes;
+}
+
+// --- Logical lines ---
+
+namespace {
+
+using WrappedLine = Scrollback::Impl::WrappedLine;
+
+// Joins stored rows [first, last) onto `lines`: each row that is not a
+// continuation starts a logical line, and so does the oldest stored row
+template<typename Rows, typename Lines>
+void group_rows(const Rows& rows, size_t first, size_t last, size_t base, Lines& lines) {
+    for(size_t i = first; i < last; i++) {
+        ScrollbackStore::RowInfo info = rows.info(i);
+        if(lines.empty() || !info.continuation)
+            lines.push_back({.first = base + i});
+
+        WrappedLine& line = lines.back();
+        if(info.text_cells > 0)
+            line.length = line.cols + info.text_cells;
+        line.cols += info.cols;
+        line.rows_stored++;
+        line.wide |= info.wide;
+    }
+}
 
-    std::deque<Line> reflowed;
+// Decodes the stored rows of `line` into `cells`
+template<typename Rows>
+void decode_line(const Rows& rows, const WrappedLine& line, size_t base, std::vector<ScreenCell>& cells) {
+    cells.resize(line.cols);
+    size_t pos = 0;
+    for(size_t i = 0; i < line.rows_stored; i++) {
+        size_t stored = line.first - base + i;
+        size_t cols = rows.cols(stored);
+        bool continuation = false;
+        rows.decode(stored, std::span(cells).subspan(pos, cols), continuation);
+        pos += cols;
+    }
+}
 
-    // Process logical lines: a logical line starts with continuation=false and includes
-    // all subsequent lines with continuation=true
-    std::vector<ScreenCell> logical_line;
+// Rows `length` cells without wide glyphs wrap to
+[[nodiscard]] size_t plain_rows(size_t length, size_t cols) {
+    return length == 0 ? 1 : (length + cols - 1) / cols;
+}
 
-    auto flush_logical_line = [&]() {
-        if(logical_line.empty())
+// Fills pending.lines with `old` and the lines stored rows [first, last)
+// form, indexed at pending.cols, as reflow() and update_index() would. Runs
+// on the worker thread; returns early once stopped.
+void build_reflow(std::stop_token stop, ScrollbackStore::View rows, std::span<const WrappedLine> old,
+                  size_t base, size_t first, size_t last, size_t front_cells, Scrollback::Impl::Pending& pending) {
+    constexpr size_t chunk = 4096;
+
+    std::vector<WrappedLine> lines;
+    lines.reserve(old.size());
+    for(size_t k = 0; k < old.size(); k += chunk) {
+        if(stop.stop_requested())
             return;
+        auto from = old.begin() + static_cast<ptrdiff_t>(k);
+        lines.insert(lines.end(), from, from + static_cast<ptrdiff_t>(std::min(chunk, old.size() - k)));
+    }
+    for(size_t i = first; i < last; i += chunk) {
+        if(stop.stop_requested())
+            return;
+        group_rows(rows, i, std::min(i + chunk, last), base, lines);
+    }
 
-        // Strip trailing blank cells (chars[0] == 0), matching vterm's line_popcount
-        while(!logical_line.empty() && logical_line.back().chars[0] == 0)
-            logical_line.pop_back();
-
-        if(logical_line.empty()) {
-            // Was an empty line — emit one blank row
-            Line blank;
-            blank.cells.resize(static_cast<size_t>(new_cols));
-            for(auto& c : blank.cells) {
-                c = ScreenCell{};
-                c.width = 1;
-            }
-            blank.continuation = false;
-            reflowed.push_back(std::move(blank));
+    auto cols = static_cast<size_t>(pending.cols);
+    std::vector<ScreenCell> cells;
+    std::vector<size_t> starts;
+    size_t end = 0;
+    for(size_t k = 0; k < lines.size(); k++) {
+        if(stop.stop_requested())
+            return;
+        WrappedLine& line = lines[k];
+        size_t skip = k == 0 ? front_cells : 0;
+        if(line.wide) {
+            decode_line(rows, line, base, cells);
+            wrap_offsets(std::span(cells).subspan(skip, line.length - skip), cols, starts);
+            end += starts.size();
         }
         else {
-            // Split into chunks of new_cols
-            size_t offset = 0;
-            bool first = true;
-
-            while(offset < logical_line.size()) {
-                size_t chunk_size = std::min(static_cast<size_t>(new_cols),
-                                             logical_line.size() - offset);
-
-                // Don't split a double-width character across rows
-                if(chunk_size > 1 &&
-                   chunk_size == static_cast<size_t>(new_cols) &&
-                   offset + chunk_size < logical_line.size() &&
-                   logical_line[offset + chunk_size - 1].width > 1) {
-                    chunk_size--;
-                }
-
-                Line row;
-                row.cells.assign(logical_line.begin() + static_cast<ptrdiff_t>(offset),
-                                 logical_line.begin() + static_cast<ptrdiff_t>(offset + chunk_size));
-
-                // Pad to new_cols
-                while(row.cells.size() < static_cast<size_t>(new_cols)) {
-                    ScreenCell blank_cell{};
-                    blank_cell.width = 1;
-                    row.cells.push_back(blank_cell);
-                }
-
-                row.continuation = !first;
-                first = false;
-
-                reflowed.push_back(std::move(row));
-                offset += chunk_size;
-            }
+            end += plain_rows(line.length - skip, cols);
         }
+        line.end = end;
+    }
 
-        logical_line.clear();
-    };
+    pending.lines = std::move(lines);
+    pending.done.store(true, std::memory_order_release);
+}
+
+} // anonymous namespace
+
+// --- Scrollback::Impl method definitions ---
+
+size_t Scrollback::Impl::size() const {
+    size_t rows = shown_rows();
+    return capacity > 0 ? std::min(rows, capacity) : rows;
+}
 
-    for(size_t i = 0; i < lines.size(); i++) {
-        if(i > 0 && !lines[i].continuation)
-            flush_logical_line();
+Scrollback::Line Scrollback::Impl::line(size_t index) const {
+    Line line;
+    size_t row = index + (shown_rows() - size());
+    line.cells.resize(row < wrapped_rows() ? static_cast<size_t>(wrap_cols)
+                                           : store.cols(store.size() - clean + row - wrapped_rows()));
+    (void)read_line(index, line.cells, line.continuation);
+    return line;
+}
 
-        logical_line.insert(logical_line.end(),
-                            lines[i].cells.begin(), lines[i].cells.end());
+size_t Scrollback::Impl::read_line(size_t index, std::span<ScreenCell> cells, bool& continuation) const {
+    // Rows past the capacity are hidden until the next change drops them
+    size_t row = index + (shown_rows() - size());
+    if(row >= wrapped_rows()) {
+        size_t stored = store.size() - clean + row - wrapped_rows();
+        store.decode(stored, cells, continuation);
+        return store.cols(stored);
     }
 
-    flush_logical_line();
+    size_t target = row + row_shift;
+    auto it = std::ranges::upper_bound(wrapped, target, {}, &WrappedLine::end);
+    auto k = static_cast<size_t>(it - wrapped.begin());
+    size_t line_row = target - (k == 0 ? row_shift : wrapped[k - 1].end);
+    load_line(k);
 
-    lines = std::move(reflowed);
+    size_t length = wrapped[k].length - loaded_skip;
+    size_t start = row_starts[line_row];
+    size_t stop = line_row + 1 < row_starts.size() ? row_starts[line_row + 1] : length;
+    size_t n = std::min(stop - start, cells.size());
+    std::copy_n(logical_line.begin() + static_cast<ptrdiff_t>(loaded_skip + start), n, cells.begin());
+    std::fill(cells.begin() + static_cast<ptrdiff_t>(n), cells.end(), blank_cell);
+    continuation = line_row > 0 || (k == 0 && front_cont);
+    return static_cast<size_t>(wrap_cols);
+}
 
-    // Trim to capacity
-    while(capacity > 0 && lines.size() > capacity)
-        lines.pop_front();
+void Scrollback::Impl::push_line(std::span<const ScreenCell> cells, bool continuation) {
+    settle();
+    store.push_back(cells, cells.size(), continuation);
+    clean++;
+    enforce_capacity();
+}
+
+void Scrollback::Impl::push_lines(std::span<const PushedLine> lines) {
+    settle();
+    // Lines the block itself pushes past capacity are never stored
+    size_t skip = capacity > 0 && lines.size() > capacity ? lines.size() - capacity : 0;
+    for(size_t i = 0; i < skip; i++)
+        note_evicted();
+    for(const PushedLine& line : lines.subspan(skip))
+        store.push_back(line.cells, line.cells.size(), line.continuation);
+    clean += lines.size() - skip;
+    enforce_capacity();
+}
+
+void Scrollback::Impl::push_ascii_line(std::string_view chars, const ScreenCell& glyph_style,
+                                       const ScreenCell& blank_style, bool continuation) {
+    settle();
+    store.push_back_ascii(chars, glyph_style, blank_style, continuation);
+    clean++;
+    enforce_capacity();
+}
+
+bool Scrollback::Impl::pop_line(std::span<ScreenCell> cells, bool& continuation) {
+    // Rows are popped from the reflowed view, past the capacity at its width
+    finish_reflow();
+    settle();
+    // Rows past the capacity may still be stored while a reflow is pending
+    if(size() == 0)
+        return false;
+    if(clean == 0)
+        store_last_line();
+
+    store.decode(store.size() - 1, cells, continuation);
+    store.pop_back();
+    clean--;
+
+    return true;
+}
+
+void Scrollback::Impl::clear() {
+    cancel_reflow();
+    store.clear();
+    wrapped.clear();
+    clean = 0;
+    base = 0;
+    front_cells = 0;
+    front_cont = false;
+    index_valid = true;
+    row_shift = 0;
+    loaded_first = npos;
+    push_track_start = 0;
+    push_track_count = 0;
+    sb_before_resize = 0;
+}
+
+void Scrollback::Impl::reflow(int32_t new_cols) {
+    if(store.empty() || new_cols <= 0)
+        return;
+    if(background_reflow) {
+        start_reflow(new_cols);
+        return;
+    }
+
+    // Rows hidden at the old width are gone before re-wrapping
+    settle();
+
+    // The rows shown as pushed join the logical lines
+    group_rows(store, store.size() - clean, store.size(), base, wrapped);
+
+    clean = 0;
+    wrap_cols = new_cols;
+    front_cont = false;
+    index_valid = false;
+    loaded_first = npos;
 }
 
 void Scrollback::Impl::begin_resize() {
-    sb_before_resize = lines.size();
+    settle();
+    sb_before_resize = size();
 }
 
 void Scrollback::Impl::commit_resize(int32_t old_rows, int32_t new_rows,
                                       int32_t old_cols, int32_t new_cols) {
     if(old_cols == new_cols) {
         // Same column width — resize compensation only
-        size_t sb_after = lines.size();
+        settle();
+        size_t sb_after = size();
         size_t sb_before = sb_before_resize;
 
         if(new_rows < old_rows && sb_after > sb_before) {
@@ -150,11 +712,9 @@ void Scrollback::Impl::commit_resize(int32_t old_rows, int32_t new_rows,
         else if(new_rows > old_rows && push_track_count > 0) {
             // Grow: erase tracked pushed lines (they're orphaned duplicates)
             const size_t erase_start = push_track_start;
-            const size_t erase_end = std::min(erase_start + push_track_count, lines.size());
-            if(erase_start < lines.size()) {
-                lines.erase(lines.begin() + static_cast<ptrdiff_t>(erase_start),
-                            lines.begin() + static_cast<ptrdiff_t>(erase_end));
-            }
+            const size_t erase_end = std::min(erase_start + push_track_count, size());
+            if(erase_start < erase_end)
+                erase_rows(erase_start, erase_end);
             push_track_count = 0;
             push_track_start = 0;
         }
@@ -168,25 +728,249 @@ void Scrollback::Impl::commit_resize(int32_t old_rows, int32_t new_rows,
 }
 
 void Scrollback::Impl::enforce_capacity() {
-    while(capacity > 0 && lines.size() > capacity) {
-        lines.pop_front();
-        if(sb_before_resize > 0)
-            sb_before_resize--;
-        if(push_track_count > 0) {
-            if(push_track_start > 0) {
-                push_track_start--;
-            }
-            else {
-                push_track_count--;
-            }
+    // size() hides the excess until a pending reflow is in; it is evicted
+    // from then on
+    if(pending) {
+        for(size_t hidden = shown_rows() - size(); pending->hidden < hidden; pending->hidden++)
+            note_evicted();
+        return;
+    }
+    update_index();
+    if(capacity > 0 && shown_rows() > capacity)
+        drop_front(shown_rows() - capacity, true);
+}
+
+// Wraps at new_cols on a worker thread. A reflow still pending is dropped;
+// the rows it would have joined are joined at new_cols instead.
+void Scrollback::Impl::start_reflow(int32_t new_cols) {
+    cancel_reflow();
+    settle();
+
+    // Back to the width shown with nothing pushed since: nothing to wrap
+    if(new_cols == wrap_cols && clean == 0) {
+        front_cont = false;
+        return;
+    }
+
+    pending = std::make_unique<Pending>();
+    pending->cols = new_cols;
+    pending->clean_end = base + store.size();
+    pending->worker = std::jthread(build_reflow, store.pin(), std::span<const WrappedLine>(wrapped.begin(), wrapped.end()),
+                                   base, store.size() - clean, store.size(), front_cells, std::ref(*pending));
+}
+
+// Applies a pending reflow if the worker is done with it
+void Scrollback::Impl::poll_reflow() {
+    if(pending && pending->done.load(std::memory_order_acquire))
+        finish_reflow();
+}
+
+// Waits for a pending reflow and applies it
+void Scrollback::Impl::finish_reflow() {
+    if(!pending)
+        return;
+    pending->worker.join();
+    apply_reflow();
+}
+
+void Scrollback::Impl::cancel_reflow() {
+    if(!pending)
+        return;
+    pending.reset();
+    store.unpin();
+}
+
+void Scrollback::Impl::apply_reflow() {
+    size_t before = size();
+
+    wrapped.assign(std::move(pending->lines));
+    clean = base + store.size() - pending->clean_end;
+    wrap_cols = pending->cols;
+    front_cont = false;
+    index_valid = true;
+    row_shift = 0;
+    loaded_first = npos;
+    pending.reset();
+    store.unpin();
+
+    // Resize compensation counts from the oldest row. The rows it tracks were
+    // pushed after the width change, so they keep their distance from the
+    // newest row.
+    size_t after = size();
+    sb_before_resize = sb_before_resize + after > before ? sb_before_resize + after - before : 0;
+    if(push_track_start + after >= before) {
+        push_track_start = push_track_start + after - before;
+    }
+    else {
+        push_track_start = 0;
+        push_track_count = 0;
+    }
+    settle();
+}
+
+// Keeps resize compensation pointing at the same lines once the oldest is gone
+void Scrollback::Impl::note_evicted() {
+    if(sb_before_resize > 0)
+        sb_before_resize--;
+    if(push_track_count > 0) {
+        if(push_track_start > 0) {
+            push_track_start--;
+        }
+        else {
+            push_track_count--;
+        }
+    }
+}
+
+// Rows each logical line wraps to at wrap_cols. Only lines with wide glyphs
+// need decoding; the rest wrap every wrap_cols cells.
+void Scrollback::Impl::update_index() const {
+    if(index_valid)
+        return;
+
+    size_t end = 0;
+    for(size_t k = 0; k < wrapped.size(); k++) {
+        const WrappedLine& line = wrapped[k];
+        if(line.wide) {
+            load_line(k);
+            end += row_starts.size();
+        }
+        else {
+            end += plain_rows(line.length - (k == 0 ? front_cells : 0), static_cast<size_t>(wrap_cols));
+        }
+        line.end = end;
+    }
+    row_shift = 0;
+    index_valid = true;
+}
+
+size_t Scrollback::Impl::shown_rows() const {
+    return wrapped_rows() + clean;
+}
+
+size_t Scrollback::Impl::wrapped_rows() const {
+    update_index();
+    return wrapped.empty() ? 0 : wrapped.back().end - row_shift;
+}
+
+// Decodes logical line `k` into logical_line and wraps it at wrap_cols
+void Scrollback::Impl::load_line(size_t k) const {
+    const WrappedLine& line = wrapped[k];
+    size_t skip = k == 0 ? front_cells : 0;
+    if(loaded_first == line.first && loaded_skip == skip)
+        return;
+
+    decode_line(store, line, base, logical_line);
+    wrap_offsets(std::span(logical_line).subspan(skip, line.length - skip),
+                 static_cast<size_t>(wrap_cols), row_starts);
+    loaded_first = line.first;
+    loaded_skip = skip;
+}
+
+void Scrollback::Impl::settle() {
+    update_index();
+    // A pending reflow still reads them
+    if(pending)
+        return;
+    if(size_t hidden = shown_rows() - size())
+        drop_front(hidden, false);
+}
+
+// Drops the oldest `rows` shown rows, cutting into a logical line if needed
+void Scrollback::Impl::drop_front(size_t rows, bool evicted) {
+    while(rows > 0 && !store.empty()) {
+        size_t dropped = 1;
+        if(wrapped.empty()) {
+            store.pop_front();
+            base++;
+            clean--;
+        }
+        else if(size_t line_rows = wrapped.front().end - row_shift; rows < line_rows) {
+            load_line(0);
+            front_cells += row_starts[rows];
+            front_cont = true;
+            row_shift += rows;
+            dropped = rows;
+        }
+        else {
+            for(size_t i = 0; i < wrapped.front().rows_stored; i++)
+                store.pop_front();
+            base += wrapped.front().rows_stored;
+            row_shift = wrapped.front().end;
+            wrapped.pop_front();
+            front_cells = 0;
+            front_cont = false;
+            dropped = line_rows;
         }
+
+        rows -= dropped;
+        for(size_t i = 0; evicted && i < dropped; i++)
+            note_evicted();
+    }
+    if(wrapped.empty())
+        row_shift = 0;
+}
+
+// Stores the newest logical line as rows at wrap_cols, so that they can be
+// popped one at a time
+void Scrollback::Impl::store_last_line() {
+    size_t k = wrapped.size() - 1;
+    load_line(k);
+    bool first_cont = k == 0 && front_cont;
+    size_t length = wrapped[k].length - loaded_skip;
+    std::span<const ScreenCell> content = std::span(logical_line).subspan(loaded_skip, length);
+
+    for(size_t i = 0; i < wrapped[k].rows_stored; i++)
+        store.pop_back();
+    wrapped.pop_back();
+    if(wrapped.empty()) {
+        front_cells = 0;
+        front_cont = false;
+        row_shift = 0;
+    }
+
+    for(size_t r = 0; r < row_starts.size(); r++) {
+        size_t stop = r + 1 < row_starts.size() ? row_starts[r + 1] : length;
+        store.push_back(content.subspan(row_starts[r], stop - row_starts[r]), static_cast<size_t>(wrap_cols),
+                        r > 0 || first_cont);
     }
+    clean += row_starts.size();
+    loaded_first = npos;
+}
+
+// Erases rows [first, last), counted like size(). Rows tracked for resize
+// compensation were pushed since the last width change, so they are stored as
+// shown.
+void Scrollback::Impl::erase_rows(size_t first, size_t last) {
+    if(pending) {
+        // Erased from the reflowed view, as far back from the newest row
+        size_t before = size();
+        finish_reflow();
+        size_t after = size();
+        if(last + after <= before)
+            return;
+        first = first + after > before ? first + after - before : 0;
+        last = last + after - before;
+    }
+
+    size_t hidden = shown_rows() - size();
+    size_t wrapped_end = wrapped_rows();
+    first = std::max(first + hidden, wrapped_end);
+    last += hidden;
+    if(first >= last)
+        return;
+
+    size_t stored = store.size() - clean;
+    store.erase(stored + first - wrapped_end, stored + last - wrapped_end);
+    clean -= last - first;
 }
 
 // --- Scrollback public API ---
 
 void Scrollback::set_capacity(size_t max_lines) {
     if(!impl_) return;
+    impl_->finish_reflow();
+    impl_->settle();
     impl_->capacity = max_lines;
     impl_->enforce_capacity();
 }
@@ -198,16 +982,21 @@ size_t Scrollback::capacity() const {
 
 size_t Scrollback::size() const {
     if(!impl_) return 0;
-    return impl_->lines.size();
+    impl_->poll_reflow();
+    return impl_->size();
 }
 
 bool Scrollback::empty() const {
     if(!impl_) return true;
-    return impl_->lines.empty();
+    return impl_->empty();
+}
+
+Scrollback::Line Scrollback::line(size_t index) const {
+    return impl_->line(index);
 }
 
-const Scrollback::Line& Scrollback::line(size_t index) const {
-    return impl_->lines[index];
+size_t Scrollback::read_line(size_t index, std::span<ScreenCell> cells, bool& continuation) const {
+    return impl_->read_line(index, cells, continuation);
 }
 
 void Scrollback::clear() {
@@ -215,4 +1004,22 @@ void Scrollback::clear() {
     impl_->clear();
 }
 
+void Scrollback::enable_background_reflow(bool enabled) {
+    if(!impl_) return;
+    impl_->background_reflow = enabled;
+    if(!enabled)
+        impl_->finish_reflow();
+}
+
+bool Scrollback::reflow_pending() const {
+    if(!impl_) return false;
+    impl_->poll_reflow();
+    return impl_->pending != nullptr;
+}
+
+void Scrollback::wait_reflow() {
+    if(!impl_) return;
+    impl_->finish_reflow();
+}
+
 } // namespace vterm
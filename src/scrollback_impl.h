@@ -3,22 +3,225 @@
 
 #include "vterm/scrollback.h"
 
+#include <atomic>
 #include <deque>
+#include <memory>
 #include <span>
+#include <string_view>
+#include <thread>
 
 namespace vterm {
 
+// Packed scrollback rows. Each row is encoded into a shared block: text as
+// UTF-8 with the blank tail stripped, attributes run-length encoded. Rows are
+// indexed through a ring, so pushing and evicting do not allocate per line.
+class ScrollbackStore {
+public:
+    static constexpr size_t block_size = 64 * 1024;
+
+    [[nodiscard]] size_t size() const { return count; }
+    [[nodiscard]] bool empty() const { return count == 0; }
+
+    void push_back(std::span<const ScreenCell> cells, size_t cols, bool continuation);
+    // A row of single-width ASCII glyphs in `glyph_style`, 0 for a blank
+    // cell in `blank_style`; one cell per char
+    void push_back_ascii(std::string_view chars, const ScreenCell& glyph_style, const ScreenCell& blank_style,
+                         bool continuation);
+    void pop_front();
+    void pop_back();
+    void erase(size_t first, size_t last);
+    void clear();
+
+    struct RowInfo {
+        size_t cols = 0;        // width the row was pushed with
+        size_t text_cells = 0;  // cells up to the last non-blank one
+        bool continuation = false;
+        bool wide = false;      // holds a glyph wider than one cell
+    };
+    [[nodiscard]] RowInfo info(size_t index) const;
+
+    // Width the row was pushed with
+    [[nodiscard]] size_t cols(size_t index) const;
+    // Decodes row `index` into `cells`, padding past its width with blanks
+    void decode(size_t index, std::span<ScreenCell> cells, bool& continuation) const;
+
+    // Bytes held by blocks and the row index
+    [[nodiscard]] size_t memory_usage() const;
+
+private:
+    struct RowRef {
+        uint32_t block;  // sequence number; blocks[block - first_block]
+        uint32_t offset;
+    };
+
+public:
+    // Read-only access to the rows stored when it was made, for another
+    // thread. It stays valid while the store is pinned; a pinned store may
+    // only push rows and pop or erase the rows pushed since.
+    class View {
+    public:
+        [[nodiscard]] RowInfo info(size_t index) const;
+        [[nodiscard]] size_t cols(size_t index) const;
+        void decode(size_t index, std::span<ScreenCell> cells, bool& continuation) const;
+
+    private:
+        friend class ScrollbackStore;
+        const RowRef* ring = nullptr;
+        size_t mask = 0;
+        size_t head = 0;
+        uint32_t first_block = 0;
+        std::vector<const char*> block_data;
+
+        [[nodiscard]] const char* row_data(size_t index) const;
+    };
+
+    [[nodiscard]] View pin();
+    void unpin();
+
+private:
+    struct Block {
+        std::vector<char> data;
+        size_t used = 0;
+        size_t live = 0;  // rows still referring into this block
+    };
+
+    std::vector<RowRef> rows;  // ring, size is a power of two
+    size_t head = 0;
+    size_t count = 0;
+
+    std::deque<Block> blocks;
+    uint32_t first_block = 0;
+    std::vector<Block> spare;  // at most one, reused before allocating
+
+    std::vector<char> scratch;  // encode buffer
+
+    bool pinned = false;
+    std::vector<std::vector<RowRef>> retired;  // rings a View may still read
+
+    [[nodiscard]] RowRef& row(size_t index) { return rows[(head + index) & (rows.size() - 1)]; }
+    [[nodiscard]] const RowRef& row(size_t index) const { return rows[(head + index) & (rows.size() - 1)]; }
+    [[nodiscard]] Block& block_of(const RowRef& ref) { return blocks[ref.block - first_block]; }
+    [[nodiscard]] const Block& block_of(const RowRef& ref) const { return blocks[ref.block - first_block]; }
+
+    void append_scratch(size_t need);
+    void release(const RowRef& ref);
+    void recycle(Block&& block);
+};
+
+// FIFO on one vector. pop_front() only advances the head; the dead front is
+// reclaimed when the vector fills with at least half of it dead, so a queue
+// that churns at a steady length stops allocating.
+template<typename T>
+class VectorQueue {
+public:
+    [[nodiscard]] size_t size() const { return items.size() - head; }
+    [[nodiscard]] bool empty() const { return size() == 0; }
+
+    [[nodiscard]] T& operator[](size_t i) { return items[head + i]; }
+    [[nodiscard]] const T& operator[](size_t i) const { return items[head + i]; }
+    [[nodiscard]] T& front() { return items[head]; }
+    [[nodiscard]] T& back() { return items.back(); }
+    [[nodiscard]] const T& back() const { return items.back(); }
+    [[nodiscard]] auto begin() const { return items.begin() + static_cast<ptrdiff_t>(head); }
+    [[nodiscard]] auto end() const { return items.end(); }
+
+    void assign(std::vector<T>&& from) {
+        items = std::move(from);
+        head = 0;
+    }
+    void push_back(const T& item) {
+        if(items.size() == items.capacity() && head >= items.size() / 2) {
+            items.erase(items.begin(), items.begin() + static_cast<ptrdiff_t>(head));
+            head = 0;
+        }
+        items.push_back(item);
+    }
+    void pop_front() {
+        if(++head == items.size())
+            clear();
+    }
+    void pop_back() {
+        items.pop_back();
+        if(head == items.size())
+            clear();
+    }
+    void clear() {
+        items.clear();
+        head = 0;
+    }
+
+private:
+    std::vector<T> items;
+    size_t head = 0;
+};
+
+// Rows are stored as they were pushed. Rows pushed before the last width
+// change are shown joined into logical lines and re-wrapped at the current
+// width; rows pushed since are shown as they are. A width change only moves
+// the rows pushed since the previous one into `wrapped`; the row index for the
+// new width is built on first use, and only the rows read are decoded.
 struct Scrollback::Impl {
-    std::deque<Line> lines;
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    // A logical line made of stored rows pushed before the last width change
+    struct WrappedLine {
+        size_t first = 0;        // stored row number, counting evicted rows
+        size_t rows_stored = 0;
+        size_t cols = 0;         // cells in those rows
+        size_t length = 0;       // cells up to the last non-blank one
+        bool wide = false;       // wrapping has to look at the cells
+        mutable size_t end = 0;  // rows shown up to and including it
+    };
+
+    ScrollbackStore store;
     size_t capacity = 0;  // 0 = disabled (no scrollback storage)
 
+    VectorQueue<WrappedLine> wrapped;
+    size_t clean = 0;          // newest stored rows, shown as pushed
+    size_t base = 0;           // row number of the oldest stored row
+    int32_t wrap_cols = 0;     // width `wrapped` is shown at
+    size_t front_cells = 0;    // cells of the oldest line already evicted
+    bool front_cont = false;   // its first shown row is a continuation
+
+    // Row index for wrap_cols: `WrappedLine::end`, offset by row_shift
+    mutable bool index_valid = true;
+    mutable size_t row_shift = 0;
+
+    // The logical line last decoded and where its rows start
+    mutable std::vector<ScreenCell> logical_line;
+    mutable std::vector<size_t> row_starts;
+    mutable size_t loaded_first = npos;
+    mutable size_t loaded_skip = 0;
+
     // Resize compensation state
     size_t push_track_start = 0;
     size_t push_track_count = 0;
     size_t sb_before_resize = 0;  // snapshot from begin_resize()
 
+    // A width change being wrapped on a worker thread. Until it is applied the
+    // rows are shown as before the change; the store is pinned, and no row
+    // before `clean_end` is dropped or popped.
+    struct Pending {
+        int32_t cols = 0;
+        size_t clean_end = 0;            // stored row number; rows before it join `wrapped`
+        size_t hidden = 0;               // rows past the capacity since it started
+        std::vector<WrappedLine> lines;  // `wrapped` at cols, with the row index
+        std::atomic<bool> done = false;
+        std::jthread worker;             // last, so it is stopped and joined first
+    };
+    bool background_reflow = false;
+    std::unique_ptr<Pending> pending;  // last, so it goes before the store
+
+    [[nodiscard]] size_t size() const;
+    [[nodiscard]] bool empty() const { return store.empty(); }
+    [[nodiscard]] Line line(size_t index) const;
+    size_t read_line(size_t index, std::span<ScreenCell> cells, bool& continuation) const;
+
     // Internal operations (called by Screen and Terminal)
     void push_line(std::span<const ScreenCell> cells, bool continuation);
+    void push_lines(std::span<const PushedLine> lines);
+    void push_ascii_line(std::string_view chars, const ScreenCell& glyph_style, const ScreenCell& blank_style,
+                         bool continuation);
     bool pop_line(std::span<ScreenCell> cells, bool& continuation);
     void clear();
     void reflow(int32_t new_cols);
@@ -27,6 +230,25 @@ struct Scrollback::Impl {
                        int32_t old_cols, int32_t new_cols);
 
     void enforce_capacity();
+    void note_evicted();
+
+    // Background reflow
+    void start_reflow(int32_t new_cols);
+    void poll_reflow();
+    void finish_reflow();
+    void cancel_reflow();
+    void apply_reflow();
+
+    // Row index and logical line access
+    void update_index() const;
+    [[nodiscard]] size_t shown_rows() const;
+    [[nodiscard]] size_t wrapped_rows() const;
+    void load_line(size_t k) const;
+    // Drops rows past the capacity that size() already hides
+    void settle();
+    void drop_front(size_t rows, bool evicted);
+    void store_last_line();
+    void erase_rows(size_t first, size_t last);
 };
 
 } // namespace vterm
@@ -0,0 +1,165 @@
+#ifndef VTERM_SIMD_H
+#define VTERM_SIMD_H
+
+#include <bit>
+#include <cstdint>
+#include <cstddef>
+#include <span>
+
+#if defined(__AVX2__)
+# include <immintrin.h>
+# define VTERM_SIMD_AVX2 1
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+# include <emmintrin.h>
+# define VTERM_SIMD_SSE2 1
+#endif
+
+namespace vterm {
+
+// Byte classes used by the parser's text fast path. A byte is plain text if
+// it is not a C0 control (0x00-0x1f), not DEL (0x7f), and — when 8-bit C1
+// controls are recognised — not in 0x80-0x9f.
+[[nodiscard]] constexpr bool is_plain_text_byte(uint8_t c, bool c1_allowed) {
+    if(c < 0x20 || c == 0x7f)
+        return false;
+    if(c1_allowed && c >= 0x80 && c < 0xa0)
+        return false;
+    return true;
+}
+
+namespace simd_detail {
+
+#ifdef VTERM_SIMD_AVX2
+// Bitmask of bytes in `v` that are not plain text
+[[nodiscard]] inline uint32_t non_text_mask32(__m256i v, bool c1_allowed) {
+    const __m256i c0_max = _mm256_set1_epi8(0x1f);
+    // b <= 0x1f (unsigned) <=> max(b, 0x1f) == 0x1f
+    __m256i special = _mm256_cmpeq_epi8(_mm256_max_epu8(v, c0_max), c0_max);
+    special = _mm256_or_si256(special, _mm256_cmpeq_epi8(v, _mm256_set1_epi8(0x7f)));
+    if(c1_allowed) {
+        // 0x80 <= b <= 0x9f <=> (b ^ 0x80) <= 0x1f
+        __m256i flipped = _mm256_xor_si256(v, _mm256_set1_epi8(static_cast<char>(0x80)));
+        special = _mm256_or_si256(special, _mm256_cmpeq_epi8(_mm256_max_epu8(flipped, c0_max), c0_max));
+    }
+    return static_cast<uint32_t>(_mm256_movemask_epi8(special));
+}
+
+// Bitmask of bytes in `v` outside printable ASCII (0x20-0x7e)
+[[nodiscard]] inline uint32_t non_ascii_text_mask32(__m256i v) {
+    // Signed compares: bytes >= 0x80 are negative and fail the first test
+    __m256i printable = _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8(0x1f)),
+                                         _mm256_cmpgt_epi8(_mm256_set1_epi8(0x7f), v));
+    return ~static_cast<uint32_t>(_mm256_movemask_epi8(printable));
+}
+
+// Zero-extend 32 bytes to 32 uint32_t
+inline void widen32(__m256i v, uint32_t* out) {
+    __m128i lo = _mm256_castsi256_si128(v);
+    __m128i hi = _mm256_extracti128_si256(v, 1);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out),      _mm256_cvtepu8_epi32(lo));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 8),  _mm256_cvtepu8_epi32(_mm_srli_si128(lo, 8)));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 16), _mm256_cvtepu8_epi32(hi));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 24), _mm256_cvtepu8_epi32(_mm_srli_si128(hi, 8)));
+}
+#endif
+
+#ifdef VTERM_SIMD_SSE2
+[[nodiscard]] inline uint32_t non_text_mask16(__m128i v, bool c1_allowed) {
+    const __m128i c0_max = _mm_set1_epi8(0x1f);
+    __m128i special = _mm_cmpeq_epi8(_mm_max_epu8(v, c0_max), c0_max);
+    special = _mm_or_si128(special, _mm_cmpeq_epi8(v, _mm_set1_epi8(0x7f)));
+    if(c1_allowed) {
+        __m128i flipped = _mm_xor_si128(v, _mm_set1_epi8(static_cast<char>(0x80)));
+        special = _mm_or_si128(special, _mm_cmpeq_epi8(_mm_max_epu8(flipped, c0_max), c0_max));
+    }
+    return static_cast<uint32_t>(_mm_movemask_epi8(special));
+}
+
+[[nodiscard]] inline uint32_t non_ascii_text_mask16(__m128i v) {
+    __m128i printable = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(0x1f)),
+                                      _mm_cmplt_epi8(v, _mm_set1_epi8(0x7f)));
+    return ~static_cast<uint32_t>(_mm_movemask_epi8(printable)) & 0xffff;
+}
+
+// Zero-extend 16 bytes to 16 uint32_t
+inline void widen16(__m128i v, uint32_t* out) {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i lo = _mm_unpacklo_epi8(v, zero);
+    __m128i hi = _mm_unpackhi_epi8(v, zero);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out),      _mm_unpacklo_epi16(lo, zero));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 4),  _mm_unpackhi_epi16(lo, zero));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 8),  _mm_unpacklo_epi16(hi, zero));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 12), _mm_unpackhi_epi16(hi, zero));
+}
+#endif
+
+} // namespace simd_detail
+
+// Length of the run of plain text bytes at the start of `bytes`
+[[nodiscard]] inline size_t scan_plain_text(std::span<const char> bytes, bool c1_allowed) {
+    const char* data = bytes.data();
+    const size_t len = bytes.size();
+    size_t pos = 0;
+
+#ifdef VTERM_SIMD_AVX2
+    for(; pos + 32 <= len; pos += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos));
+        if(uint32_t mask = simd_detail::non_text_mask32(v, c1_allowed))
+            return pos + static_cast<size_t>(std::countr_zero(mask));
+    }
+#endif
+#ifdef VTERM_SIMD_SSE2
+    for(; pos + 16 <= len; pos += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+        if(uint32_t mask = simd_detail::non_text_mask16(v, c1_allowed))
+            return pos + static_cast<size_t>(std::countr_zero(mask));
+    }
+#endif
+
+    for(; pos < len; pos++)
+        if(!is_plain_text_byte(static_cast<uint8_t>(data[pos]), c1_allowed))
+            break;
+
+    return pos;
+}
+
+// Copy the run of printable ASCII bytes (0x20-0x7e) at the start of `bytes`
+// into `out` as codepoints and return its length. Stops when either span is
+// exhausted. Entries of `out` past the returned length may be overwritten.
+[[nodiscard]] inline size_t widen_printable_ascii(std::span<const char> bytes, std::span<uint32_t> out) {
+    const char* data = bytes.data();
+    uint32_t* dst = out.data();
+    const size_t len = bytes.size() < out.size() ? bytes.size() : out.size();
+    size_t pos = 0;
+
+#ifdef VTERM_SIMD_AVX2
+    for(; pos + 32 <= len; pos += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos));
+        simd_detail::widen32(v, dst + pos);
+        if(uint32_t mask = simd_detail::non_ascii_text_mask32(v))
+            return pos + static_cast<size_t>(std::countr_zero(mask));
+    }
+#endif
+#ifdef VTERM_SIMD_SSE2
+    for(; pos + 16 <= len; pos += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+        simd_detail::widen16(v, dst + pos);
+        if(uint32_t mask = simd_detail::non_ascii_text_mask16(v))
+            return pos + static_cast<size_t>(std::countr_zero(mask));
+    }
+#endif
+
+    for(; pos < len; pos++) {
+        uint8_t c = static_cast<uint8_t>(data[pos]);
+        if(c < 0x20 || c >= 0x7f)
+            break;
+        dst[pos] = c;
+    }
+
+    return pos;
+}
+
+} // namespace vterm
+
+#endif // VTERM_SIMD_H
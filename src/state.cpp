@@ -35,6 +35,18 @@ void State::Impl::putglyph(std::span<const uint32_t> chars, int32_t width, Pos p
     DEBUG_LOG("libvterm: Unhandled putglyph U+{:04x} at ({},{})\n", chars[0], pos.col, pos.row);
 }
 
+// A run of single-width, single-codepoint glyphs on an unprotected
+// single-width row, left to right from pos
+void State::Impl::putglyphs(std::span<const uint32_t> chars, Pos pos)
+{
+    if(callbacks)
+        if(callbacks->on_putglyphs(chars, pos))
+            return;
+
+    for(size_t i = 0; i < chars.size(); i++)
+        putglyph(chars.subspan(i, 1), 1, {.row = pos.row, .col = pos.col + static_cast<int32_t>(i)});
+}
+
 void State::Impl::updatecursor(const Pos& oldpos, bool cancel_phantom)
 {
     if(pos.col == oldpos.col && pos.row == oldpos.row)
@@ -357,6 +369,42 @@ int32_t State::Impl::on_text(std::span<const char> bytes)
     }
 
     for(; i < npoints; i++) {
+        // Fast path: a run of plain narrow glyphs that fits on this row
+        if(!mode.insert && !at_phantom && !protected_cell &&
+           unicode_is_simple_narrow(codepoints[i])) {
+            const LineInfo& lineinfo = get_lineinfo(pos.row);
+            int32_t room = this_row_width() - pos.col;
+            int32_t run = 0;
+            if(!lineinfo.doublewidth && !lineinfo.doubleheight)
+                while(i + run < npoints && run < room && unicode_is_simple_narrow(codepoints[i + run]))
+                    run++;
+            // A combining char after the run belongs to its last glyph
+            if(run > 0 && i + run < npoints && unicode_is_combining(codepoints[i + run]))
+                run--;
+
+            if(run > 1) {
+                putglyphs(std::span{codepoints}.subspan(i, run), pos);
+                i += run - 1;
+                pos.col += run - 1;
+
+                if(i == npoints - 1) {
+                    combine_chars[0] = codepoints[i];
+                    combine_count = 1;
+                    combine_width = 1;
+                    combine_pos = pos;
+                }
+
+                if(pos.col + 1 >= this_row_width()) {
+                    if(mode.autowrap)
+                        at_phantom = true;
+                }
+                else {
+                    pos.col++;
+                }
+                continue;
+            }
+        }
+
         // Try to find combining characters following this
         int32_t glyph_starts = i;
         int32_t glyph_ends;
@@ -797,6 +845,10 @@ void State::Impl::set_dec_mode(int32_t num, bool val)
         mode.bracketpaste = val;
         break;
 
+    case 2026: // synchronized output
+        (void)settermprop_bool(Prop::SyncOutput, val);
+        break;
+
     default:
         DEBUG_LOG("libvterm: Unknown DEC mode {}\n", num);
         return;
@@ -872,6 +924,10 @@ void State::Impl::request_dec_mode(int32_t num)
             reply = mode.bracketpaste;
             break;
 
+        case 2026:
+            reply = mode.sync_output;
+            break;
+
         default:
             vt.push_output_ctrl( C1::CSI, "?{};{}$y", num, 0);
             return;
@@ -1888,21 +1944,17 @@ bool State::Impl::on_resize(int32_t rows, int32_t cols)
     Pos oldpos = pos;
 
     if(cols != this->cols) {
-        std::vector<uint8_t> newtabstops((cols + tabstop_bit_mask) / (tabstop_bit_mask + 1));
-
-        size_t common_bytes = std::min(tabstops.size(), newtabstops.size());
-        std::copy_n(tabstops.begin(), common_bytes, newtabstops.begin());
+        // Resized in place so a width change back and forth reuses the storage
+        tabstops.resize((cols + tabstop_bit_mask) / (tabstop_bit_mask + 1));
 
         int32_t col;
         for(col = this->cols; col < cols; col++) {
             uint8_t mask = 1 << (col & tabstop_bit_mask);
             if(col % default_tabstop_interval == 0)
-                newtabstops[col >> tabstop_byte_shift] |= mask;
+                tabstops[col >> tabstop_byte_shift] |= mask;
             else
-                newtabstops[col >> tabstop_byte_shift] &= ~mask;
+                tabstops[col >> tabstop_byte_shift] &= ~mask;
         }
-
-        tabstops = std::move(newtabstops);
     }
 
     int32_t old_rows = this->rows;
@@ -2113,6 +2165,11 @@ void State::Impl::reset(bool hard)
 
     protected_cell = false;
 
+    // Release any held synchronized update
+    if(mode.sync_output)
+        (void)settermprop_bool(Prop::SyncOutput, false);
+    mode.sync_output = false;
+
     // Initialise the props
     (void)settermprop_bool(Prop::CursorVisible, true);
     (void)settermprop_bool(Prop::CursorBlink,   true);
@@ -2175,6 +2232,9 @@ bool State::Impl::set_termprop_internal(Prop prop, const Value& val)
     case Prop::FocusReport:
         mode.report_focus = val.boolean;
         return true;
+    case Prop::SyncOutput:
+        mode.sync_output = val.boolean;
+        return true;
 
     case Prop::NProps:
         return false;
@@ -15,6 +15,9 @@ Terminal::Terminal(int32_t rows, int32_t cols)
     impl_->parser.state = ParserState::Normal;
     impl_->parser.callbacks = nullptr;
     impl_->parser.emit_nul = false;
+#ifdef VTERM_DEFAULT_PARSER_TABLE
+    impl_->parser.engine = ParserEngine::Table;
+#endif
 
     static constexpr size_t default_outbuffer_size = 4096;
     impl_->outbuffer.resize(default_outbuffer_size);
@@ -34,29 +37,76 @@ void Terminal::set_size(int32_t rows, int32_t cols) {
     if(rows < 1 || cols < 1)
         return;
 
-    int32_t old_rows = impl_->rows;
-    int32_t old_cols = impl_->cols;
+    if(impl_->defer_resize) {
+        impl_->pending_rows = rows;
+        impl_->pending_cols = cols;
+        return;
+    }
+
+    impl_->apply_size(rows, cols);
+}
+
+void Terminal::enable_deferred_resize(bool enabled) {
+    if(!enabled)
+        impl_->commit_pending_size();
+    impl_->defer_resize = enabled;
+}
+
+void Terminal::commit_resize() {
+    impl_->commit_pending_size();
+}
 
-    auto* sb = impl_->scrollback_impl.get();
+void Terminal::Impl::commit_pending_size() {
+    if(pending_rows == 0)
+        return;
+
+    int32_t new_rows = std::exchange(pending_rows, 0);
+    int32_t new_cols = std::exchange(pending_cols, 0);
+
+    // A drag that ends where it started costs nothing
+    if(new_rows != rows || new_cols != cols)
+        apply_size(new_rows, new_cols);
+}
+
+void Terminal::Impl::apply_size(int32_t new_rows, int32_t new_cols) {
+    int32_t old_rows = rows;
+    int32_t old_cols = cols;
+
+    auto* sb = scrollback_impl.get();
     if(sb && sb->capacity > 0)
         sb->begin_resize();
 
-    impl_->rows = rows;
-    impl_->cols = cols;
+    rows = new_rows;
+    cols = new_cols;
 
-    if(impl_->parser.callbacks && impl_->parser.callbacks->on_resize(rows, cols)) {
+    if(parser.callbacks && parser.callbacks->on_resize(new_rows, new_cols)) {
         // callback handled it
     }
 
     if(sb && sb->capacity > 0)
-        sb->commit_resize(old_rows, rows, old_cols, cols);
+        sb->commit_resize(old_rows, new_rows, old_cols, new_cols);
 }
 
 bool Terminal::utf8() const { return impl_->mode.utf8; }
 void Terminal::set_utf8(bool enabled) { impl_->mode.utf8 = enabled; }
 
+ParserEngine Terminal::parser_engine() const { return impl_->parser.engine; }
+void Terminal::set_parser_engine(ParserEngine engine) { impl_->parser.engine = engine; }
+
 size_t Terminal::write(std::span<const char> data) {
-    return impl_->input_write(data);
+    impl_->commit_pending_size();
+    if(impl_->scrollback_impl)
+        impl_->scrollback_impl->poll_reflow();
+
+    size_t written = 0;
+    while(written < data.size()) {
+        size_t parse = 0;
+        written += impl_->write_direct(data.subspan(written), parse);
+        if(parse > 0)
+            written += impl_->input_write(data.subspan(written, parse));
+    }
+    impl_->sync_output_wrote(written);
+    return written;
 }
 
 void Terminal::set_output_callback(std::function<void(std::span<const char>)> cb) {
@@ -0,0 +1,192 @@
+#include "internal.h"
+
+namespace vterm {
+
+namespace {
+
+constexpr uint32_t stage1_size = unicode_table_end >> unicode_stage1_shift;
+
+// Upper bounds for the shared blocks and leaves; ids are stored as uint8_t
+constexpr uint32_t max_blocks = 32;
+constexpr uint32_t max_leaves = 256;
+
+// Deduplicated fixed-size chunks, looked up by a cheap hash first. Plain
+// arrays keep the constexpr evaluation cost down.
+template<size_t Chunk, size_t MaxChunks>
+struct ChunkStore {
+    uint8_t data[Chunk * MaxChunks]{};
+    uint32_t hashes[MaxChunks]{};
+    uint32_t count = 0;
+    bool overflow = false;
+
+    // Id of `chunk`, appending it if not already present
+    constexpr uint8_t intern(const uint8_t* chunk) {
+        uint32_t h = 0;
+        for(size_t i = 0; i < Chunk; i++)
+            h = h * 31 + chunk[i];
+
+        for(uint32_t id = 0; id < count; id++) {
+            if(hashes[id] != h)
+                continue;
+            bool same = true;
+            for(size_t i = 0; i < Chunk && same; i++)
+                same = data[id * Chunk + i] == chunk[i];
+            if(same)
+                return static_cast<uint8_t>(id);
+        }
+
+        if(count == MaxChunks) {
+            overflow = true;
+            return 0;
+        }
+
+        for(size_t i = 0; i < Chunk; i++)
+            data[count * Chunk + i] = chunk[i];
+        hashes[count] = h;
+        return static_cast<uint8_t>(count++);
+    }
+};
+
+// Tracks a position in a sorted interval table while codepoints are visited
+// in ascending order, so each membership test is amortised O(1)
+struct IntervalCursor {
+    const UnicodeInterval* table;
+    size_t size;
+    size_t idx = 0;
+
+    constexpr bool contains(uint32_t codepoint) {
+        while(idx < size && table[idx].last < codepoint)
+            idx++;
+        return idx < size && table[idx].first <= codepoint;
+    }
+
+    // True if [first, last] lies wholly inside or wholly outside the table;
+    // `inside` says which
+    constexpr bool uniform(uint32_t first, uint32_t last, bool& inside) {
+        inside = contains(first);
+        if(inside)
+            return table[idx].last >= last;
+        return idx == size || table[idx].first > last;
+    }
+};
+
+// Same result as unicode_interval_width() / unicode_interval_is_combining()
+constexpr uint8_t encode_entry(uint32_t codepoint, bool fullwidth, bool combining) {
+    int32_t width = 1;
+    if(fullwidth)
+        width = 2;
+    else if(codepoint == 0)
+        width = 0;
+    else if(codepoint < c0_end || (codepoint >= ctrl_del && codepoint < c1_end))
+        width = -1;
+    else if(combining)
+        width = 0;
+
+    return static_cast<uint8_t>((width + 1) | (combining ? unicode_entry_combining : 0));
+}
+
+// Most of the codepoint space is long uniform stretches. Those ranges are
+// encoded once, which keeps the build well inside compiler constexpr limits.
+struct TableBuilder {
+    uint8_t stage1[stage1_size]{};
+    ChunkStore<unicode_block_size, max_blocks> blocks;
+    ChunkStore<unicode_leaf_size, max_leaves> leaves;
+
+    IntervalCursor fullwidth{unicode_fullwidth.data(), unicode_fullwidth.size()};
+    IntervalCursor combining{unicode_combining.data(), unicode_combining.size()};
+
+    // Leaf and block ids for each uniform entry value, -1 until first used
+    int32_t uniform_leaves[8]{-1, -1, -1, -1, -1, -1, -1, -1};
+    int32_t uniform_blocks[8]{-1, -1, -1, -1, -1, -1, -1, -1};
+
+    // Returns the entry shared by every codepoint in [first, last], or -1
+    constexpr int32_t uniform_entry(uint32_t first, uint32_t last) {
+        if(first < c1_end)
+            return -1;
+        bool in_fullwidth = false;
+        bool in_combining = false;
+        if(!fullwidth.uniform(first, last, in_fullwidth) || !combining.uniform(first, last, in_combining))
+            return -1;
+        return encode_entry(first, in_fullwidth, in_combining);
+    }
+
+    constexpr uint8_t uniform_leaf(int32_t entry) {
+        if(uniform_leaves[entry] < 0) {
+            uint8_t leaf[unicode_leaf_size]{};
+            for(uint32_t e = 0; e < unicode_leaf_size; e++)
+                leaf[e] = static_cast<uint8_t>(entry);
+            uniform_leaves[entry] = leaves.intern(leaf);
+        }
+        return static_cast<uint8_t>(uniform_leaves[entry]);
+    }
+
+    constexpr uint8_t build_leaf(uint32_t first) {
+        int32_t entry = uniform_entry(first, first + unicode_leaf_size - 1);
+        if(entry >= 0)
+            return uniform_leaf(entry);
+
+        uint8_t leaf[unicode_leaf_size]{};
+        for(uint32_t e = 0; e < unicode_leaf_size; e++)
+            leaf[e] = encode_entry(first + e, fullwidth.contains(first + e), combining.contains(first + e));
+        return leaves.intern(leaf);
+    }
+
+    constexpr uint8_t build_block(uint32_t first) {
+        int32_t entry = uniform_entry(first, first + (unicode_block_size << unicode_leaf_bits) - 1);
+        if(entry >= 0 && uniform_blocks[entry] >= 0)
+            return static_cast<uint8_t>(uniform_blocks[entry]);
+
+        uint8_t block[unicode_block_size]{};
+        for(uint32_t l = 0; l < unicode_block_size; l++)
+            block[l] = entry >= 0 ? uniform_leaf(entry) : build_leaf(first + (l << unicode_leaf_bits));
+
+        uint8_t id = blocks.intern(block);
+        if(entry >= 0)
+            uniform_blocks[entry] = id;
+        return id;
+    }
+
+    constexpr TableBuilder() {
+        for(uint32_t b = 0; b < stage1_size; b++)
+            stage1[b] = build_block(b << unicode_stage1_shift);
+    }
+};
+
+constexpr TableBuilder built;
+static_assert(!built.blocks.overflow && !built.leaves.overflow,
+              "unicode table exceeds max_blocks / max_leaves");
+
+template<size_t N>
+constexpr std::array<uint8_t, N> trim(const uint8_t* src) {
+    std::array<uint8_t, N> out{};
+    for(size_t i = 0; i < N; i++)
+        out[i] = src[i];
+    return out;
+}
+
+constexpr auto stage2 = trim<built.blocks.count * unicode_block_size>(built.blocks.data);
+constexpr auto leaves = trim<built.leaves.count * unicode_leaf_size>(built.leaves.data);
+
+// Spot checks against the interval tables; test_03 covers every codepoint
+static_assert([] {
+    for(uint32_t c : {0x0u, 0x7u, 0x41u, 0x9fu, 0xe9u, 0x300u, 0x36fu, 0x1100u, 0x1160u,
+                      0x302au, 0x4e00u, 0xac00u, 0xfe0fu, 0xff01u, 0x1f600u, 0x20000u, 0xe0100u, 0x10ffffu}) {
+        uint32_t block = built.stage1[c >> unicode_stage1_shift];
+        uint32_t leaf  = stage2[(block << unicode_block_bits) | ((c >> unicode_leaf_bits) & (unicode_block_size - 1))];
+        uint8_t entry  = leaves[(leaf << unicode_leaf_bits) | (c & (unicode_leaf_size - 1))];
+        if((entry & unicode_entry_width_mask) - 1 != unicode_interval_width(c) ||
+           ((entry & unicode_entry_combining) != 0) != unicode_interval_is_combining(c))
+            return false;
+    }
+    return true;
+}(), "unicode table disagrees with the interval tables");
+
+} // anonymous namespace
+
+const UnicodeTable unicode_table{
+    .stage1 = trim<stage1_size>(built.stage1),
+    .stage2 = stage2.data(),
+    .leaves = leaves.data(),
+};
+
+} // namespace vterm
@@ -2,9 +2,25 @@
 
 #include "test.h"
 
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
 std::array<test_entry, TEST_MAX> g_tests{};
 int32_t g_test_count = 0;
 
+std::atomic<size_t> g_alloc_count = 0;
+
+void* operator new(size_t size) {
+    g_alloc_count.fetch_add(1, std::memory_order_relaxed);
+    if(void* p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
 int main(int argc, char** argv) {
     return test_run_all(argc, argv);
 }
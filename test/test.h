@@ -13,6 +13,7 @@
 #define TEST_H
 
 #include <array>
+#include <atomic>
 #include <cstdlib>
 #include <format>
 #include <iostream>
@@ -44,6 +45,12 @@ extern int32_t g_test_count;
     }                                                                       \
     static void test_##name([[maybe_unused]] int32_t *_test_failures)
 
+// --- Allocation counting ---
+
+// Calls to the global operator new so far, from any thread; main.cpp
+// replaces it to count
+extern std::atomic<size_t> g_alloc_count;
+
 // --- Assertions ---
 
 #define ASSERT_TRUE(expr)                                                   \
@@ -225,3 +225,199 @@ TEST(parser_c1_8bit)
     ASSERT_EQ(g_parser.csi[0].args[0], 3);
     ASSERT_EQ(g_parser.csi[0].args[1], 4);
 }
+
+// Long run of text is delivered in a single callback, stopping at the control
+TEST(parser_long_text_run)
+{
+    Terminal vt(25, 80);
+    vt.set_utf8(false);
+    vt.parser_set_callbacks(parser_cbs);
+    parser_clear();
+
+    std::string input(100, 'x');
+    input += '\x03';
+    input += "yz";
+    push(vt, input);
+    ASSERT_EQ(g_parser.text_count, 2);
+    ASSERT_EQ(g_parser.text[0].len, 100);
+    ASSERT_EQ(g_parser.control_count, 1);
+    ASSERT_EQ(g_parser.control[0].control, 0x03);
+    ASSERT_EQ(g_parser.text[1].len, 2);
+    ASSERT_EQ(g_parser.text[1].bytes[0], 'y');
+}
+
+// Text run is ended by a C1 control in non-UTF8 mode
+TEST(parser_text_run_stops_at_c1)
+{
+    Terminal vt(25, 80);
+    vt.set_utf8(false);
+    vt.parser_set_callbacks(parser_cbs);
+    parser_clear();
+
+    std::string input(40, 'a');
+    input += '\x85'; // NEL
+    input += "bc";
+    push(vt, input);
+    ASSERT_EQ(g_parser.text_count, 2);
+    ASSERT_EQ(g_parser.text[0].len, 40);
+    ASSERT_EQ(g_parser.control_count, 1);
+    ASSERT_EQ(g_parser.control[0].control, 0x85);
+    ASSERT_EQ(g_parser.text[1].len, 2);
+}
+
+// In UTF-8 mode 0x80-0x9F are continuation bytes, not C1 controls, so they
+// stay inside the text run
+TEST(parser_text_run_utf8_high_bytes)
+{
+    struct RunRecorder : ParserCallbacks {
+        int32_t calls = 0;
+        size_t first_len = 0;
+        int32_t on_text(std::span<const char> bytes) override {
+            if(calls++ == 0)
+                first_len = bytes.size();
+            return static_cast<int32_t>(bytes.size());
+        }
+    } recorder;
+
+    Terminal vt(25, 80);
+    vt.set_utf8(true);
+    vt.parser_set_callbacks(recorder);
+
+    // 36 bytes of text with an embedded U+00C5 (0xC3 0x85)
+    std::string input(20, 'a');
+    input += "\xC3\x85";
+    input += std::string(14, 'b');
+    push(vt, input);
+    ASSERT_EQ(recorder.calls, 1);
+    ASSERT_EQ(recorder.first_len, 36);
+}
+
+// The table-driven engine can be selected at runtime
+TEST(parser_engine_table_selectable)
+{
+    Terminal vt(25, 80);
+    vt.set_utf8(false);
+    vt.set_parser_engine(ParserEngine::Table);
+    ASSERT_TRUE(vt.parser_engine() == ParserEngine::Table);
+    vt.parser_set_callbacks(parser_cbs);
+    parser_clear();
+
+    push(vt, "AB\e[?3;4c\e]1;Hi\e\\");
+    ASSERT_EQ(g_parser.text_count, 1);
+    ASSERT_EQ(g_parser.text[0].len, 2);
+    ASSERT_EQ(g_parser.csi_count, 1);
+    ASSERT_EQ(g_parser.csi[0].command, 'c');
+    ASSERT_STR_EQ(g_parser.csi[0].leader.data(), "?");
+    ASSERT_EQ(g_parser.csi[0].argcount, 2);
+    ASSERT_EQ(g_parser.osc_count, 1);
+    ASSERT_EQ(g_parser.osc[0].command, 1);
+    ASSERT_EQ(g_parser.osc[0].final_, true);
+    ASSERT_TRUE(std::string_view(g_parser.osc[0].data.data(), g_parser.osc[0].datalen) == "Hi");
+}
+
+// Both engines must report identical callbacks for arbitrary input, however
+// it is split across writes
+TEST(parser_table_engine_matches_switch)
+{
+    struct Transcript : ParserCallbacks {
+        std::string log;
+
+        void fragment(char kind, StringFragment frag) {
+            log += kind;
+            log += frag.initial ? '[' : '(';
+            log += frag.str;
+            log += frag.final_ ? ']' : ')';
+        }
+        int32_t on_text(std::span<const char> bytes) override {
+            size_t len = 0;
+            while(len < bytes.size()) {
+                auto b = static_cast<uint8_t>(bytes[len]);
+                if(b < 0x20 || b == 0x7f || (b >= 0x80 && b < 0xa0))
+                    break;
+                len++;
+            }
+            log += "T(";
+            log.append(bytes.data(), len);
+            log += ')';
+            return static_cast<int32_t>(len);
+        }
+        bool on_control(uint8_t control) override {
+            log += "C" + std::to_string(control);
+            return true;
+        }
+        bool on_escape(std::string_view bytes) override {
+            log += "E(";
+            log += bytes;
+            log += ')';
+            return true;
+        }
+        bool on_csi(std::string_view leader, std::span<const int64_t> args, std::string_view intermed, char command) override {
+            log += "S(";
+            log += leader;
+            for(int64_t arg : args)
+                log += std::to_string(arg) + ",";
+            log += intermed;
+            log += command;
+            log += ')';
+            return true;
+        }
+        bool on_osc(int32_t command, StringFragment frag) override {
+            log += "O" + std::to_string(command);
+            fragment('o', frag);
+            return true;
+        }
+        bool on_dcs(std::string_view command, StringFragment frag) override {
+            log += "D";
+            log += command;
+            fragment('d', frag);
+            return true;
+        }
+        bool on_apc(StringFragment frag) override { fragment('A', frag); return true; }
+        bool on_pm(StringFragment frag) override { fragment('P', frag); return true; }
+        bool on_sos(StringFragment frag) override { fragment('X', frag); return true; }
+    };
+
+    // Weighted towards bytes that steer the state machine
+    static constexpr char alphabet_bytes[] =
+        "\x00\x07\x08\x0a\x18\x1a\x1b\x1b\x1b\x1b\x7f"
+        " !#$0123456789:;;<=>?@AHPX[[\\\\]]^_`amq~"
+        "\x84\x85\x90\x98\x9b\x9c\x9d\x9e\x9f\xa0\xc3\xe2";
+    constexpr std::string_view alphabet{alphabet_bytes, sizeof(alphabet_bytes) - 1};
+
+    uint64_t seed = 0x9E3779B97F4A7C15ULL;
+    auto next = [&](uint32_t n) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        return static_cast<uint32_t>(seed >> 33) % n;
+    };
+
+    for(int32_t round = 0; round < 400; round++) {
+        std::string input;
+        int32_t len = 1 + static_cast<int32_t>(next(200));
+        for(int32_t i = 0; i < len; i++)
+            input += alphabet[next(static_cast<uint32_t>(alphabet.size()))];
+
+        bool utf8 = round & 1;
+        std::string logs[2];
+        for(int32_t engine = 0; engine < 2; engine++) {
+            Terminal vt(25, 80);
+            vt.set_utf8(utf8);
+            vt.set_parser_engine(engine ? ParserEngine::Table : ParserEngine::Switch);
+            Transcript transcript;
+            vt.parser_set_callbacks(transcript);
+
+            // Same chunking for both engines
+            uint64_t saved = seed;
+            size_t pos = 0;
+            while(pos < input.size()) {
+                size_t chunk = (round % 3 == 0) ? input.size() : 1 + next(8);
+                chunk = std::min(chunk, input.size() - pos);
+                push(vt, std::string_view(input).substr(pos, chunk));
+                pos += chunk;
+            }
+            if(engine == 0)
+                seed = saved;
+            logs[engine] = transcript.log;
+        }
+        ASSERT_TRUE(logs[0] == logs[1]);
+    }
+}
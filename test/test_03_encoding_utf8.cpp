@@ -234,3 +234,83 @@ TEST(encoding_utf8_split_write)
     ASSERT_EQ(n, 1);
     ASSERT_EQ(cp[0], 0x10000);
 }
+
+// Long runs go through the bulk paths; limits and errors inside them
+TEST(encoding_utf8_bulk_runs)
+{
+    auto ei = make_utf8();
+    std::array<uint32_t, 64> cp{};
+
+    // 40 printable bytes stop at the C0 byte without consuming it
+    std::string input(40, 'x');
+    input[37] = 'Z';
+    input += "\r\n";
+    auto result = ei->decode(cp, std::span{input.data(), input.size()});
+    ASSERT_EQ(result.codepoints_produced, 40);
+    ASSERT_EQ(result.bytes_consumed, 40u);
+    ASSERT_EQ(cp[37], 'Z');
+
+    // Output limit in the middle of an ASCII run
+    result = ei->decode(std::span{cp}.subspan(0, 5), std::span{input.data(), input.size()});
+    ASSERT_EQ(result.codepoints_produced, 5);
+    ASSERT_EQ(result.bytes_consumed, 5u);
+
+    // Back-to-back multibyte sequences, with an overlong, a surrogate and a
+    // noncharacter among them
+    std::string_view mixed = "a\xC3\xA9\xE4\xB8\xAD\xF0\x9F\x9A\x80\xC0\x80\xED\xA0\x80\xEF\xBF\xBFz";
+    result = ei->decode(cp, std::span{mixed.data(), mixed.size()});
+    ASSERT_EQ(result.codepoints_produced, 8);
+    ASSERT_EQ(cp[0], 'a');
+    ASSERT_EQ(cp[1], 0xE9);
+    ASSERT_EQ(cp[2], 0x4E2D);
+    ASSERT_EQ(cp[3], 0x1F680);
+    ASSERT_EQ(cp[4], 0xFFFD);
+    ASSERT_EQ(cp[5], 0xFFFD);
+    ASSERT_EQ(cp[6], 0xFFFD);
+    ASSERT_EQ(cp[7], 'z');
+
+    // A lead byte followed by ASCII yields U+FFFD then the ASCII
+    result = ei->decode(cp, std::span{"\xE4\xB8" "AB", 4});
+    ASSERT_EQ(result.codepoints_produced, 3);
+    ASSERT_EQ(cp[0], 0xFFFD);
+    ASSERT_EQ(cp[1], 'A');
+    ASSERT_EQ(cp[2], 'B');
+}
+
+// Splitting the input at arbitrary points gives the same codepoints
+TEST(encoding_utf8_chunking_invariant)
+{
+    static constexpr std::string_view pieces[] = {
+        "hello ", "\xC3\xA9", "\xE4\xB8\xAD\xE6\x96\x87", "\xF0\x9F\x98\x80", "\xED\xA0\x80",
+        "\xC0\xAF", "\x80", "\xFE", "\xE4\xB8", "0123456789abcdefghijklmnopqrstuvwxyz", "\xF8\x88\x80\x80\x80",
+    };
+
+    uint32_t seed = 12345;
+    auto next = [&] { seed = seed * 1103515245u + 12345u; return (seed >> 16) & 0x7fff; };
+
+    for(int32_t round = 0; round < 50; round++) {
+        std::string input;
+        for(int32_t i = 0; i < 40; i++)
+            input += pieces[next() % std::size(pieces)];
+
+        std::array<uint32_t, 2048> whole{};
+        auto ei = make_utf8();
+        int32_t nwhole = ei->decode(whole, std::span{input.data(), input.size()}).codepoints_produced;
+
+        std::array<uint32_t, 2048> split{};
+        int32_t nsplit = 0;
+        ei = make_utf8();
+        size_t pos = 0;
+        while(pos < input.size()) {
+            size_t len = std::min<size_t>(1 + next() % 7, input.size() - pos);
+            auto result = ei->decode(std::span{split}.subspan(nsplit), std::span{input.data() + pos, len});
+            ASSERT_EQ(result.bytes_consumed, len);
+            nsplit += result.codepoints_produced;
+            pos += len;
+        }
+
+        ASSERT_EQ(nsplit, nwhole);
+        for(int32_t i = 0; i < nwhole; i++)
+            ASSERT_EQ(split[i], whole[i]);
+    }
+}
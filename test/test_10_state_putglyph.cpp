@@ -271,3 +271,51 @@ TEST(state_putglyph_decsca_protected)
     ASSERT_EQ(g_cb.putglyph[2].col, 2);
     ASSERT_EQ(g_cb.putglyph[2].protected_cell, false);
 }
+
+// Runs of plain narrow glyphs arrive through on_putglyphs
+TEST(state_putglyph_bulk_run)
+{
+    struct RunRecorder : StateCallbacks {
+        std::vector<std::vector<uint32_t>> runs;
+        std::vector<Pos> positions;
+        int32_t putglyph_count = 0;
+        bool on_putglyphs(std::span<const uint32_t> chars, Pos pos) override {
+            runs.emplace_back(chars.begin(), chars.end());
+            positions.push_back(pos);
+            return true;
+        }
+        bool on_putglyph(const GlyphInfo&, Pos) override {
+            putglyph_count++;
+            return true;
+        }
+    } recorder;
+
+    Terminal vt(25, 10);
+    vt.set_utf8(true);
+    State& state = vt.state();
+    state.set_callbacks(recorder);
+    state.reset(true);
+
+    // Run is split at the right margin; the 'e' before U+0301 stays single
+    push(vt, "Hello, world!!\n\rcafe\xCC\x81!");
+    ASSERT_EQ(static_cast<int32_t>(recorder.runs.size()), 3);
+    ASSERT_EQ(static_cast<int32_t>(recorder.runs[0].size()), 10);
+    ASSERT_EQ(recorder.positions[0].row, 0);
+    ASSERT_EQ(recorder.positions[0].col, 0);
+    ASSERT_EQ(static_cast<int32_t>(recorder.runs[1].size()), 3);
+    ASSERT_EQ(recorder.runs[1][0], 'd');
+    ASSERT_EQ(recorder.positions[1].row, 1);
+    ASSERT_EQ(recorder.positions[1].col, 1);
+    ASSERT_EQ(static_cast<int32_t>(recorder.runs[2].size()), 3);
+    ASSERT_EQ(recorder.positions[2].row, 2);
+    ASSERT_EQ(recorder.positions[2].col, 0);
+    // The wrapped 'l', the accented e and the trailing "!" go through on_putglyph
+    ASSERT_EQ(recorder.putglyph_count, 3);
+
+    // A combining char in the next write still attaches to the run's last glyph
+    recorder.putglyph_count = 0;
+    push(vt, "\e[HAB");
+    push(vt, "\xCC\x81");
+    ASSERT_EQ(recorder.putglyph_count, 1);
+    ASSERT_EQ(state.cursor_pos().col, 2);
+}
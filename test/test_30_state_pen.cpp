@@ -286,3 +286,76 @@ TEST(state_pen_decstr_reset)
     ASSERT_PEN_BOOL(state, Attr::Bold, false);
     ASSERT_PEN_INT(state, Attr::Underline, 0);
 }
+
+// A whole SGR sequence is delivered as one batched pen update
+TEST(state_pen_batched_setpen)
+{
+    struct PenRecorder : StateCallbacks {
+        int32_t setpen_count = 0;
+        int32_t setpenattr_count = 0;
+        Pen pen{};
+        AttrMask changed{};
+        bool on_setpen(const Pen& p, AttrMask mask) override {
+            setpen_count++;
+            pen = p;
+            changed = mask;
+            return true;
+        }
+        bool on_setpenattr(Attr, const Value&) override {
+            setpenattr_count++;
+            return true;
+        }
+    } recorder;
+
+    Terminal vt(25, 80);
+    vt.set_utf8(true);
+    State& state = vt.state();
+    state.set_callbacks(recorder);
+    state.reset(true);
+    recorder.setpen_count = 0;
+
+    push(vt, "\e[1;3;38;2;10;20;30;48;5;200m");
+    ASSERT_EQ(recorder.setpen_count, 1);
+    ASSERT_EQ(recorder.setpenattr_count, 0);
+    ASSERT_TRUE(recorder.changed == (AttrMask::Bold | AttrMask::Italic | AttrMask::Foreground | AttrMask::Background));
+    ASSERT_EQ(recorder.pen.bold, 1);
+    ASSERT_EQ(recorder.pen.italic, 1);
+    ASSERT_TRUE(recorder.pen.fg.is_rgb());
+    ASSERT_EQ(recorder.pen.fg.rgb.green, 20);
+    ASSERT_TRUE(recorder.pen.bg.is_indexed());
+    ASSERT_EQ(recorder.pen.bg.indexed.idx, 200);
+
+    push(vt, "\e[0;4m");
+    ASSERT_EQ(recorder.setpen_count, 2);
+    ASSERT_TRUE(recorder.changed == AttrMask::All);
+    ASSERT_EQ(recorder.pen.bold, 0);
+    ASSERT_TRUE(recorder.pen.underline == Underline::Single);
+}
+
+// Callbacks that do not handle on_setpen still see each touched attribute
+TEST(state_pen_setpenattr_fallback)
+{
+    struct AttrRecorder : StateCallbacks {
+        std::array<int32_t, static_cast<size_t>(Attr::NAttrs)> seen{};
+        bool bold = false;
+        bool on_setpenattr(Attr attr, const Value& val) override {
+            seen[static_cast<size_t>(attr)]++;
+            if(attr == Attr::Bold)
+                bold = val.boolean;
+            return true;
+        }
+    } recorder;
+
+    Terminal vt(25, 80);
+    vt.set_utf8(true);
+    State& state = vt.state();
+    state.set_callbacks(recorder);
+    state.reset(true);
+    recorder.seen = {};
+
+    push(vt, "\e[1;22;1;7m");
+    ASSERT_EQ(recorder.seen[static_cast<size_t>(Attr::Bold)], 1);
+    ASSERT_EQ(recorder.seen[static_cast<size_t>(Attr::Reverse)], 1);
+    ASSERT_EQ(recorder.seen[static_cast<size_t>(Attr::Italic)], 0);
+    ASSERT_TRUE(recorder.bold);
+}
@@ -3,6 +3,9 @@
 
 #include "harness.h"
 
+#include <random>
+#include <utility>
+
 // Get
 TEST(screen_ascii_get)
 {
@@ -393,3 +396,76 @@ TEST(screen_ascii_altscreen)
     // ?screen_row 0 = "P"
     ASSERT_SCREEN_ROW(vt, screen, 0, "P");
 }
+
+// is_eol and get_text answer from cached row extents; check them against
+// the cells after every kind of edit
+TEST(screen_ascii_row_extent_tracking)
+{
+    Terminal vt(12, 30);
+    vt.set_utf8(true);
+    Screen& screen = vt.screen();
+    screen.enable_altscreen(true);
+    screen.enable_reflow(true);
+    screen.reset(true);
+
+    static constexpr std::string_view edits[] = {
+        "hello world", "\xc3\xa9t\xc3\xa9", "\xe4\xb8\xad\xe6\x96\x87", "e\xcc\x81",
+        "\e[K", "\e[1K", "\e[2K", "\e[J", "\e[1J", "\e[3X", "\e[2@", "\e[3P",
+        "\e[2L", "\e[M", "\e[S", "\e[2T", "\e[3;8r\n\n\n\e[r", "\e[?69h\e[5;20s\e[2@\e[3P\e[S\e[?69l",
+        "\e#8", "\e[?1049h", "\e[?1049l", "\e[1\"q\e[2K\e[1\"q\e[?2K",
+    };
+
+    auto encode = [](std::string& out, uint32_t c) {
+        if(c < 0x80)
+            out += static_cast<char>(c);
+        else if(c < 0x800) {
+            out += static_cast<char>(0xc0 | (c >> 6));
+            out += static_cast<char>(0x80 | (c & 0x3f));
+        }
+        else {
+            out += static_cast<char>(0xe0 | (c >> 12));
+            out += static_cast<char>(0x80 | ((c >> 6) & 0x3f));
+            out += static_cast<char>(0x80 | (c & 0x3f));
+        }
+    };
+
+    std::mt19937 rng(17);
+    std::array<char, 4096> text{};
+    for(int32_t step = 0; step < 3000; step++) {
+        if(step % 500 == 499)
+            vt.set_size(10 + static_cast<int32_t>(rng() % 6), 20 + static_cast<int32_t>(rng() % 20));
+        else
+            push(vt, std::format("\e[{};{}H{}", rng() % 14, rng() % 32, edits[rng() % std::size(edits)]));
+
+        int32_t rows = vt.rows(), cols = vt.cols();
+        for(int32_t row = 0; row < rows; row++) {
+            int32_t end = cols;
+            ScreenCell cell{};
+            while(end > 0 && screen.get_cell({.row = row, .col = end - 1}, cell) && cell.chars[0] == 0)
+                end--;
+            for(int32_t col = 0; col <= cols; col++)
+                ASSERT_EQ(screen.is_eol({.row = row, .col = col}), col >= end);
+
+            // Cell by cell: blanks become spaces unless nothing follows them
+            int32_t start_col = static_cast<int32_t>(rng() % cols);
+            int32_t end_col = start_col + static_cast<int32_t>(rng() % (cols - start_col + 1));
+            std::string expect, pad;
+            for(int32_t col = start_col; col < end_col; col++) {
+                (void)screen.get_cell({.row = row, .col = col}, cell);
+                if(cell.chars[0] == 0)
+                    pad += ' ';
+                else if(cell.chars[0] != glyph_continuation) {
+                    expect += std::exchange(pad, {});
+                    for(uint32_t c : cell.chars) {
+                        if(!c)
+                            break;
+                        encode(expect, c);
+                    }
+                }
+            }
+            size_t len = screen.get_text(text, {.start_row = row, .end_row = row + 1, .start_col = start_col, .end_col = end_col});
+            std::string got(text.data(), len);
+            ASSERT_STR_EQ(got.c_str(), expect.c_str());
+        }
+    }
+}
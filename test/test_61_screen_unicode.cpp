@@ -368,3 +368,123 @@ TEST(screen_unicode_cjk_col80_wraparound)
         ASSERT_EQ(bg.rgb.blue, 0);
     }
 }
+
+// A control interrupting a partial UTF-8 sequence produces U+FFFD before
+// the control takes effect
+TEST(screen_unicode_partial_sequence_then_control)
+{
+    Terminal vt(25, 80);
+    vt.set_utf8(true);
+    Screen& screen = vt.screen();
+    screen.set_callbacks(screen_cbs);
+    screen.reset(true);
+
+    push(vt, "ab\xC3\r\ncd");
+
+    ASSERT_SCREEN_CELL_CHAR(screen, 0, 0, 'a');
+    ASSERT_SCREEN_CELL_CHAR(screen, 0, 1, 'b');
+    ASSERT_SCREEN_CELL_CHAR(screen, 0, 2, 0xFFFD);
+    ASSERT_SCREEN_CELL_CHAR(screen, 1, 0, 'c');
+    ASSERT_SCREEN_CELL_CHAR(screen, 1, 1, 'd');
+}
+
+// The lookup table agrees with the interval tables for every codepoint
+TEST(screen_unicode_width_table_matches_intervals)
+{
+    int32_t mismatches = 0;
+    for(uint32_t c = 0; c < unicode_table_end + 0x100; c++)
+        if(unicode_width(c) != unicode_interval_width(c) ||
+           unicode_is_combining(c) != unicode_interval_is_combining(c))
+            mismatches++;
+    ASSERT_EQ(mismatches, 0);
+
+    ASSERT_EQ(unicode_width(0x7fffffff), 1);
+    ASSERT_EQ(unicode_is_combining(0x7fffffff), false);
+}
+
+// Raw glyph access: single codepoints inline, combined glyphs by cluster id
+TEST(screen_unicode_cluster_glyphs)
+{
+    Terminal vt(25, 80);
+    vt.set_utf8(true);
+    Screen& screen = vt.screen();
+    screen.reset(true);
+
+    // a, e + U+0301, U+4E00 (wide), e + U+0301 again
+    push(vt, "ae\xCC\x81\xE4\xB8\x80" "e\xCC\x81");
+
+    uint32_t glyph = 0;
+    ASSERT_TRUE(screen.get_cell_glyph({ .row = 0, .col = 0 }, glyph));
+    ASSERT_EQ(glyph, 0x61u);
+    ASSERT_TRUE(screen.get_cluster(glyph).empty());
+
+    uint32_t cluster = 0;
+    ASSERT_TRUE(screen.get_cell_glyph({ .row = 0, .col = 1 }, cluster));
+    ASSERT_TRUE((cluster & glyph_cluster_flag) != 0);
+    std::span<const uint32_t> chars = screen.get_cluster(cluster);
+    ASSERT_EQ(chars.size(), 2u);
+    ASSERT_EQ(chars[0], 0x65u);
+    ASSERT_EQ(chars[1], 0x301u);
+
+    ASSERT_TRUE(screen.get_cell_glyph({ .row = 0, .col = 2 }, glyph));
+    ASSERT_EQ(glyph, 0x4e00u);
+    ASSERT_TRUE(screen.get_cell_glyph({ .row = 0, .col = 3 }, glyph));
+    ASSERT_EQ(glyph, glyph_continuation);
+
+    // The same cluster is stored once
+    ASSERT_TRUE(screen.get_cell_glyph({ .row = 0, .col = 4 }, glyph));
+    ASSERT_EQ(glyph, cluster);
+
+    ASSERT_TRUE(screen.get_cell_glyph({ .row = 0, .col = 5 }, glyph));
+    ASSERT_EQ(glyph, 0u);
+    ASSERT_TRUE(!screen.get_cell_glyph({ .row = 25, .col = 0 }, glyph));
+
+    // A combining sequence split across writes is kept past max_chars_per_cell
+    push(vt, "\r\ne\xCC\x81\xCC\x82\xCC\x83\xCC\x84\xCC\x85");
+    push(vt, "\xCC\x86\xCC\x87");
+    {
+        ScreenCell cell;
+        (void)screen.get_cell({ .row = 1, .col = 0 }, cell);
+        ASSERT_EQ(cell.chars[0], 0x65u);
+        ASSERT_EQ(cell.chars[5], 0x305u);
+
+        std::array<uint32_t, 16> text{};
+        size_t len = screen.get_chars(text, { .start_row = 1, .end_row = 2, .start_col = 0, .end_col = 80 });
+        ASSERT_EQ(len, 8u);
+        ASSERT_EQ(text[7], 0x307u);
+    }
+}
+
+// Clusters that scroll away are dropped without disturbing visible ones
+TEST(screen_unicode_cluster_compaction)
+{
+    Terminal vt(25, 80);
+    vt.set_utf8(true);
+    Screen& screen = vt.screen();
+    screen.reset(true);
+
+    auto combiner = [](int32_t i) { return static_cast<uint32_t>(0x300 + i % 0x70); };
+
+    // 3000 distinct base + 2 combining char clusters; the first 13 rows scroll off
+    auto put_combiner = [](std::string& out, uint32_t c) {
+        out += static_cast<char>(0xC0 | (c >> 6));
+        out += static_cast<char>(0x80 | (c & 0x3F));
+    };
+
+    std::string out;
+    for(int32_t i = 0; i < 3000; i++) {
+        out += 'a';
+        put_combiner(out, combiner(i / 0x70));
+        put_combiner(out, combiner(i));
+    }
+    push(vt, out);
+
+    for(int32_t i = 13 * 80; i < 3000; i += 23) {
+        ScreenCell cell;
+        (void)screen.get_cell({ .row = i / 80 - 13, .col = i % 80 }, cell);
+        ASSERT_EQ(cell.chars[0], 0x61u);
+        ASSERT_EQ(cell.chars[1], combiner(i / 0x70));
+        ASSERT_EQ(cell.chars[2], combiner(i));
+        ASSERT_EQ(cell.chars[3], 0u);
+    }
+}
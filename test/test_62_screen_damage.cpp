@@ -509,3 +509,353 @@ TEST(screen_damage_merge_scroll2_with_damage)
     // ?screen_row 23 = "ABE"
     ASSERT_SCREEN_ROW(vt, screen, 23, "ABE");
 }
+
+// A plain ASCII run damages the whole span at once
+TEST(screen_damage_ascii_run)
+{
+    Terminal vt(25, 80);
+    vt.set_utf8(true);
+    Screen& screen = vt.screen();
+    screen.set_callbacks(screen_cbs);
+    screen.reset(true);
+    callbacks_clear();
+
+    screen.set_damage_merge(DamageSize::Screen);
+    push(vt, "\e[1mHello\e[m");
+    ASSERT_EQ(g_cb.damage_count, 0);
+    screen.flush_damage();
+    ASSERT_EQ(g_cb.damage_count, 1);
+    ASSERT_DAMAGE(0, 0, 1, 0, 5);
+
+    ScreenCell cell{};
+    ASSERT_TRUE(screen.get_cell({.row = 0, .col = 4}, cell));
+    ASSERT_EQ(cell.chars[0], 'o');
+    ASSERT_EQ(cell.chars[1], 0);
+    ASSERT_EQ(cell.attrs.bold, 1);
+
+    // Cell-level damage still reports one rect per glyph
+    callbacks_clear();
+    screen.set_damage_merge(DamageSize::Cell);
+    push(vt, "abc");
+    ASSERT_EQ(g_cb.damage_count, 3);
+    ASSERT_DAMAGE(2, 0, 1, 7, 8);
+}
+
+// Polling renderers: collect_dirty_rows reports rows changed since a generation
+TEST(screen_dirty_rows_collect)
+{
+    Terminal vt(25, 80);
+    vt.set_utf8(true);
+    Screen& screen = vt.screen();
+    screen.reset(true);
+
+    std::array<int32_t, 25> rows{};
+
+    // Generation 0 means "everything"
+    auto dirty = screen.collect_dirty_rows(0, rows);
+    ASSERT_EQ(dirty.count, 25u);
+    ASSERT_EQ(rows[0], 0);
+    ASSERT_EQ(rows[24], 24);
+    uint64_t first = dirty.generation;
+
+    dirty = screen.collect_dirty_rows(first, rows);
+    ASSERT_EQ(dirty.count, 0u);
+
+    push(vt, "\e[4;1Hab\e[11;5Hc");
+    dirty = screen.collect_dirty_rows(dirty.generation, rows);
+    ASSERT_EQ(dirty.count, 2u);
+    ASSERT_EQ(rows[0], 3);
+    ASSERT_EQ(rows[1], 10);
+    uint64_t second = dirty.generation;
+
+    push(vt, "\e[7;1H\e[K");
+    dirty = screen.collect_dirty_rows(dirty.generation, rows);
+    ASSERT_EQ(dirty.count, 1u);
+    ASSERT_EQ(rows[0], 6);
+
+    // A consumer that fell behind still sees everything since its generation
+    dirty = screen.collect_dirty_rows(second, rows);
+    ASSERT_EQ(dirty.count, 1u);
+    ASSERT_EQ(rows[0], 6);
+    dirty = screen.collect_dirty_rows(first, rows);
+    ASSERT_EQ(dirty.count, 3u);
+    ASSERT_EQ(rows[0], 3);
+    ASSERT_EQ(rows[1], 6);
+    ASSERT_EQ(rows[2], 10);
+
+    // A short span is filled and the full count still reported
+    push(vt, "\e[2J");
+    std::array<int32_t, 4> few{};
+    dirty = screen.collect_dirty_rows(dirty.generation, few);
+    ASSERT_EQ(dirty.count, 25u);
+    ASSERT_EQ(few[3], 3);
+}
+
+TEST(screen_dirty_rows_scroll_resize)
+{
+    Terminal vt(25, 80);
+    vt.set_utf8(true);
+    Screen& screen = vt.screen();
+    screen.reset(true);
+
+    std::array<int32_t, 40> rows{};
+    auto dirty = screen.collect_dirty_rows(0, rows);
+
+    // Scrolling inside a region marks only that region
+    push(vt, "\e[5;10r\e[10;1H\n");
+    dirty = screen.collect_dirty_rows(dirty.generation, rows);
+    ASSERT_EQ(dirty.count, 6u);
+    ASSERT_EQ(rows[0], 4);
+    ASSERT_EQ(rows[5], 9);
+
+    // Full-screen scroll moves every row
+    push(vt, "\e[r\e[25;1H\n");
+    dirty = screen.collect_dirty_rows(dirty.generation, rows);
+    ASSERT_EQ(dirty.count, 25u);
+
+    vt.set_size(30, 80);
+    dirty = screen.collect_dirty_rows(dirty.generation, rows);
+    ASSERT_EQ(dirty.count, 30u);
+    ASSERT_EQ(rows[29], 29);
+}
+
+// DamageSize::Region keeps distant updates apart and reports them in one batch
+struct TestScreenCallbacksBatch : ScreenCallbacks {
+    std::vector<std::vector<Rect>> batches;
+    bool on_damage_batch(std::span<const Rect> rects) override {
+        batches.emplace_back(rects.begin(), rects.end());
+        return true;
+    }
+};
+
+TEST(screen_damage_region_batch)
+{
+    Terminal vt(25, 80);
+    vt.set_utf8(true);
+    Screen& screen = vt.screen();
+    TestScreenCallbacksBatch cbs;
+    screen.set_callbacks(cbs);
+    screen.reset(true);
+    screen.set_damage_merge(DamageSize::Region);
+    cbs.batches.clear();
+
+    // A cell at the top and a status line at the bottom stay separate
+    push(vt, "\e[1;80Hx\e[25;1Hstatus");
+    ASSERT_EQ(cbs.batches.size(), 0u);
+    screen.flush_damage();
+    ASSERT_EQ(cbs.batches.size(), 1u);
+    ASSERT_EQ(cbs.batches[0].size(), 2u);
+    ASSERT_TRUE(cbs.batches[0][0] == (Rect{.start_row = 0, .end_row = 1, .start_col = 79, .end_col = 80}));
+    ASSERT_TRUE(cbs.batches[0][1] == (Rect{.start_row = 24, .end_row = 25, .start_col = 0, .end_col = 6}));
+
+    // Adjacent and overlapping updates join into one rect
+    push(vt, "\e[5;1Hhello\e[6;1Hworld\e[5;3Hxyz");
+    screen.flush_damage();
+    ASSERT_EQ(cbs.batches.size(), 2u);
+    ASSERT_EQ(cbs.batches[1].size(), 1u);
+    ASSERT_TRUE(cbs.batches[1][0] == (Rect{.start_row = 4, .end_row = 6, .start_col = 0, .end_col = 5}));
+
+    screen.flush_damage();
+    ASSERT_EQ(cbs.batches.size(), 2u);
+}
+
+TEST(screen_damage_region_bounded)
+{
+    Terminal vt(25, 80);
+    vt.set_utf8(true);
+    Screen& screen = vt.screen();
+    TestScreenCallbacksBatch cbs;
+    screen.set_callbacks(cbs);
+    screen.reset(true);
+    screen.set_damage_merge(DamageSize::Region);
+    cbs.batches.clear();
+
+    // 40 scattered cells: more than the region holds
+    std::vector<Pos> cells;
+    for(int32_t i = 0; i < 40; i++) {
+        Pos pos{.row = (i * 7) % 25, .col = (i * 37) % 80};
+        cells.push_back(pos);
+        push(vt, std::format("\e[{};{}H#", pos.row + 1, pos.col + 1));
+    }
+    screen.flush_damage();
+    ASSERT_EQ(cbs.batches.size(), 1u);
+    const auto& rects = cbs.batches[0];
+    ASSERT_TRUE(rects.size() <= 16u);
+
+    for(size_t a = 0; a < rects.size(); a++)
+        for(size_t b = a + 1; b < rects.size(); b++)
+            ASSERT_TRUE(!rects[a].intersects(rects[b]));
+    for(const Pos& pos : cells)
+        ASSERT_TRUE(std::ranges::any_of(rects, [&](const Rect& r) { return r.contains(pos); }));
+}
+
+// Without on_damage_batch the rects arrive through on_damage
+TEST(screen_damage_region_fallback)
+{
+    Terminal vt(25, 80);
+    vt.set_utf8(true);
+    Screen& screen = vt.screen();
+    screen.set_callbacks(screen_cbs);
+    screen.reset(true);
+    screen.set_damage_merge(DamageSize::Region);
+    callbacks_clear();
+
+    push(vt, "\e[25;1Habc\e[1;1Hd");
+    ASSERT_EQ(g_cb.damage_count, 0);
+    screen.flush_damage();
+    ASSERT_EQ(g_cb.damage_count, 2);
+    ASSERT_DAMAGE(0, 0, 1, 0, 1);
+    ASSERT_DAMAGE(1, 24, 25, 0, 3);
+}
+
+// Terminal::begin_batch holds damage and cursor moves until end_batch
+TEST(screen_damage_batch_coalesce)
+{
+    Terminal vt(25, 80);
+    vt.set_utf8(true);
+    Screen& screen = vt.screen();
+    screen.set_callbacks(screen_cbs);
+    screen.reset(true);
+    callbacks_clear();
+
+    vt.begin_batch();
+    push(vt, "hello\e[20;1Hworld");
+    ASSERT_EQ(g_cb.damage_count, 0);
+    ASSERT_EQ(g_cb.movecursor_count, 0);
+    vt.end_batch();
+
+    ASSERT_EQ(g_cb.damage_count, 2);
+    ASSERT_DAMAGE(0, 0, 1, 0, 5);
+    ASSERT_DAMAGE(1, 19, 20, 0, 5);
+    ASSERT_EQ(g_cb.movecursor_count, 1);
+    ASSERT_EQ(g_cb.movecursor[0].oldpos.row, 0);
+    ASSERT_EQ(g_cb.movecursor[0].oldpos.col, 0);
+    ASSERT_EQ(g_cb.movecursor[0].pos.row, 19);
+    ASSERT_EQ(g_cb.movecursor[0].pos.col, 5);
+
+    // Nothing is left over, and an empty batch delivers nothing
+    callbacks_clear();
+    vt.begin_batch();
+    vt.end_batch();
+    vt.end_batch();
+    ASSERT_EQ(g_cb.damage_count, 0);
+    ASSERT_EQ(g_cb.movecursor_count, 0);
+}
+
+// Scrolls inside a batch are delivered as one net moverect
+TEST(screen_damage_batch_net_scroll)
+{
+    Terminal vt(25, 80);
+    vt.set_utf8(true);
+    Screen& screen = vt.screen();
+    screen.set_callbacks(screen_cbs);
+    screen.reset(true);
+    callbacks_clear();
+
+    vt.begin_batch();
+    push(vt, "\e[25;1H\n\n\n\n\e[1Tx");
+    ASSERT_EQ(g_cb.moverect_count, 0);
+    vt.end_batch();
+
+    ASSERT_EQ(g_cb.moverect_count, 1);
+    ASSERT_MOVERECT(0, 0, 22, 0, 80, 3, 25, 0, 80);
+    // The top row SD exposed was moved down with the rest of the region
+    ASSERT_EQ(g_cb.damage_count, 2);
+    ASSERT_DAMAGE(0, 0, 1, 0, 80);
+    ASSERT_DAMAGE(1, 22, 25, 0, 80);
+
+    // Scrolls that cancel out become plain damage
+    callbacks_clear();
+    vt.begin_batch();
+    push(vt, "\e[5;10r\e[2S\e[2T\e[r");
+    vt.end_batch();
+    ASSERT_EQ(g_cb.moverect_count, 0);
+    ASSERT_EQ(g_cb.damage_count, 1);
+    ASSERT_DAMAGE(0, 4, 10, 0, 80);
+}
+
+TEST(screen_damage_batch_termprops)
+{
+    Terminal vt(25, 80);
+    vt.set_utf8(true);
+    Screen& screen = vt.screen();
+    screen.set_callbacks(screen_cbs);
+    screen.reset(true);
+    callbacks_clear();
+
+    vt.begin_batch();
+    vt.begin_batch();
+    push(vt, "\e[?25l\e[?25h\e[?25l\e]2;title\a");
+    // Strings cannot be held, so the title goes out straight away
+    ASSERT_EQ(g_cb.settermprop_count, 1);
+    ASSERT_EQ(g_cb.settermprop[0].prop, Prop::Title);
+    vt.end_batch();
+    ASSERT_EQ(g_cb.settermprop_count, 1);
+    vt.end_batch();
+
+    ASSERT_EQ(g_cb.settermprop_count, 2);
+    ASSERT_EQ(g_cb.settermprop[1].prop, Prop::CursorVisible);
+    ASSERT_EQ(g_cb.settermprop[1].val.boolean, false);
+}
+
+// A renderer that only applies what a batch delivers ends up showing the screen
+struct MirrorScreenCallbacks : ScreenCallbacks {
+    Screen* screen = nullptr;
+    std::array<std::array<uint32_t, 40>, 12> cells{};
+
+    void repaint(Rect rect) {
+        for(int32_t row = rect.start_row; row < rect.end_row; row++)
+            for(int32_t col = rect.start_col; col < rect.end_col; col++) {
+                ScreenCell cell{};
+                (void)screen->get_cell({.row = row, .col = col}, cell);
+                cells[row][col] = cell.chars[0];
+            }
+    }
+    bool on_damage(Rect rect) override { repaint(rect); return true; }
+    bool on_moverect(Rect dest, Rect src) override {
+        auto old = cells;
+        for(int32_t row = 0; row < dest.end_row - dest.start_row; row++)
+            for(int32_t col = 0; col < dest.end_col - dest.start_col; col++)
+                cells[dest.start_row + row][dest.start_col + col] = old[src.start_row + row][src.start_col + col];
+        return true;
+    }
+};
+
+TEST(screen_damage_batch_mirror)
+{
+    Terminal vt(12, 40);
+    vt.set_utf8(true);
+    Screen& screen = vt.screen();
+    MirrorScreenCallbacks mirror;
+    mirror.screen = &screen;
+    screen.set_callbacks(mirror);
+    screen.reset(true);
+    mirror.repaint({.start_row = 0, .end_row = 12, .start_col = 0, .end_col = 40});
+
+    uint32_t seed = 1;
+    auto next = [&](uint32_t n) { seed = seed * 1103515245 + 12345; return (seed >> 16) % n; };
+    static constexpr std::string_view ops[] = {
+        "\n", "\e[S", "\e[2T", "\e[3;8r", "\e[r", "\eM", "\e[2L", "\e[M", "\e[K", "\e[J",
+        "\e[?69h\e[5;20s", "\e[?69l", "\e[2@", "\e[P",
+    };
+
+    for(int32_t frame = 0; frame < 300; frame++) {
+        vt.begin_batch();
+        for(int32_t i = 0, n = static_cast<int32_t>(next(12)); i < n; i++) {
+            push(vt, std::format("\e[{};{}H", next(12) + 1, next(40) + 1));
+            push(vt, std::string(10 + next(30), static_cast<char>('a' + next(26))));
+            push(vt, ops[next(std::size(ops))]);
+        }
+        vt.end_batch();
+
+        for(int32_t row = 0; row < 12; row++)
+            for(int32_t col = 0; col < 40; col++) {
+                ScreenCell cell{};
+                (void)screen.get_cell({.row = row, .col = col}, cell);
+                if(mirror.cells[row][col] != cell.chars[0]) {
+                    std::cerr << std::format("  frame {} differs at {},{}\n", frame, row, col);
+                    ASSERT_EQ(mirror.cells[row][col], cell.chars[0]);
+                }
+            }
+    }
+}
@@ -3,6 +3,9 @@
 
 #include "harness.h"
 
+#include <format>
+#include <string>
+
 // Resize wider preserves cells
 TEST(screen_resize_wider_preserves_cells)
 {
@@ -338,3 +341,139 @@ TEST(screen_resize_can_operate_on_altscreen)
 
     ASSERT_SCREEN_ROW(vt, screen, 0, "Main screen");
 }
+
+// Deferred resize is silent until committed, and a drag back home is free
+TEST(screen_resize_deferred_until_commit)
+{
+    Terminal vt(25, 80);
+    vt.set_utf8(false);
+    Screen& screen = vt.screen();
+    screen.set_callbacks(screen_cbs);
+    screen.reset(true);
+    vt.enable_deferred_resize(true);
+
+    push(vt, "AB\r\nCD");
+    callbacks_clear();
+
+    vt.set_size(20, 60);
+    vt.set_size(30, 100);
+    vt.set_size(25, 80);
+    vt.commit_resize();
+    ASSERT_EQ(g_cb.damage_count, 0);
+
+    vt.set_size(20, 60);
+    vt.set_size(30, 100);
+    ASSERT_EQ(g_cb.damage_count, 0);
+    ASSERT_EQ(vt.rows(), 25);
+
+    vt.commit_resize();
+    ASSERT_TRUE(g_cb.damage_count > 0);
+    ASSERT_EQ(vt.rows(), 30);
+    ASSERT_EQ(vt.cols(), 100);
+    ASSERT_SCREEN_ROW(vt, screen, 0, "AB");
+    ASSERT_SCREEN_ROW(vt, screen, 1, "CD");
+}
+
+// A row-only shrink pushes a wrapped line whole; growing pops it back
+TEST(screen_resize_rows_wrapped_line_moves_whole)
+{
+    Terminal vt(6, 10);
+    vt.set_utf8(false);
+    Screen& screen = vt.screen();
+    screen.enable_reflow(true);
+    Scrollback& sb = vt.scrollback();
+    sb.set_capacity(100);
+    screen.reset(true);
+    State& state = vt.state();
+
+    push(vt, "0123456789ABCDEFGHIJKL\r\nx\r\ny");
+
+    vt.set_size(4, 10);
+
+    ASSERT_EQ(sb.size(), 3);
+    ASSERT_SCREEN_ROW(vt, screen, 0, "x");
+    ASSERT_SCREEN_ROW(vt, screen, 1, "y");
+    ASSERT_SCREEN_ROW(vt, screen, 2, "");
+    ASSERT_CURSOR(state, 1, 1);
+
+    vt.set_size(7, 10);
+
+    ASSERT_EQ(sb.size(), 0);
+    ASSERT_SCREEN_ROW(vt, screen, 0, "0123456789");
+    ASSERT_SCREEN_ROW(vt, screen, 1, "ABCDEFGHIJ");
+    ASSERT_SCREEN_ROW(vt, screen, 2, "KL");
+    ASSERT_SCREEN_ROW(vt, screen, 3, "x");
+    ASSERT_SCREEN_ROW(vt, screen, 4, "y");
+    ASSERT_SCREEN_ROW(vt, screen, 6, "");
+    ASSERT_LINEINFO(state, 1, continuation, 1);
+    ASSERT_LINEINFO(state, 2, continuation, 1);
+    ASSERT_LINEINFO(state, 3, continuation, 0);
+    ASSERT_CURSOR(state, 4, 1);
+}
+
+// Blank rows below the cursor go first when shrinking; growing adds blank rows
+TEST(screen_resize_rows_drops_trailing_blank_rows)
+{
+    Terminal vt(6, 10);
+    vt.set_utf8(false);
+    Screen& screen = vt.screen();
+    screen.set_callbacks(screen_cbs);
+    screen.reset(true);
+    State& state = vt.state();
+
+    push(vt, "a\r\nb");
+    callbacks_clear();
+
+    vt.set_size(2, 10);
+
+    ASSERT_EQ(g_cb.sb_pushline_count, 0);
+    ASSERT_SCREEN_ROW(vt, screen, 0, "a");
+    ASSERT_SCREEN_ROW(vt, screen, 1, "b");
+    ASSERT_CURSOR(state, 1, 1);
+
+    vt.set_size(5, 10);
+
+    ASSERT_SCREEN_ROW(vt, screen, 0, "a");
+    ASSERT_SCREEN_ROW(vt, screen, 1, "b");
+    ASSERT_SCREEN_ROW(vt, screen, 4, "");
+    ASSERT_CURSOR(state, 1, 1);
+
+    push(vt, "\x1b[5;1Hend\r\nc");
+
+    ASSERT_SCREEN_ROW(vt, screen, 3, "end");
+    ASSERT_SCREEN_ROW(vt, screen, 4, "c");
+    ASSERT_EQ(g_cb.sb_pushline_count, 1);
+    ASSERT_EQ(g_cb.sb_pushline[0].chars[0], 'a');
+}
+
+// Once warmed up, resizing allocates nothing
+TEST(screen_resize_no_steady_state_allocations)
+{
+    for(bool reflow : {false, true}) {
+        Terminal vt(24, 80);
+        vt.set_utf8(true);
+        Screen& screen = vt.screen();
+        screen.enable_reflow(reflow);
+        screen.enable_altscreen(true);
+        vt.scrollback().set_capacity(500);
+        screen.reset(true);
+
+        std::string text;
+        for(int i = 0; i < 300; i++)
+            text += std::format("line {} {}\x1b[41mred\x1b[m\r\n", i, std::string(static_cast<size_t>(i % 150), 'x'));
+        push(vt, text);
+
+        auto cycle = [&] {
+            vt.set_size(24, 60);
+            vt.set_size(30, 100);
+            vt.set_size(24, 80);
+            vt.set_size(27, 80);
+        };
+        for(int i = 0; i < 40; i++)
+            cycle();
+
+        size_t before = g_alloc_count.load();
+        cycle();
+        ASSERT_EQ(g_alloc_count.load() - before, 0);
+    }
+}
@@ -3,6 +3,10 @@
 
 #include "harness.h"
 
+#include <format>
+#include <string>
+#include <vector>
+
 // Plain through DECSCNM
 TEST(screen_pen_attrs)
 {
@@ -576,3 +580,188 @@ TEST(screen_pen_default_colors)
         ASSERT_EQ(bg.rgb.blue, 30);
     }
 }
+
+// Cells keep their colours once the pen table is compacted
+TEST(screen_pen_table_compaction)
+{
+    Terminal vt(25, 80);
+    vt.set_utf8(false);
+    Screen& screen = vt.screen();
+    screen.reset(true);
+
+    // 3000 distinct truecolor pens; the first 13 rows scroll off the screen
+    std::string out;
+    for(int32_t i = 0; i < 3000; i++)
+        out += std::format("\x1b[38;2;{};{};{}mX", i & 0xff, (i >> 8) & 0xff, 7);
+    push(vt, out);
+
+    for(int32_t i = 13 * 80; i < 3000; i += 37) {
+        Pos pos = { .row = i / 80 - 13, .col = i % 80 };
+        ScreenCell cell;
+        (void)screen.get_cell(pos, cell);
+        ASSERT_EQ(cell.chars[0], 0x58);
+        ASSERT_EQ(cell.fg.rgb.red, i & 0xff);
+        ASSERT_EQ(cell.fg.rgb.green, (i >> 8) & 0xff);
+        ASSERT_EQ(cell.fg.rgb.blue, 7);
+    }
+
+    // Cells written with one pen still share an extent after compaction
+    push(vt, "\x1b[H\x1b[m\x1b[1mABC\x1b[22;3mD");
+    {
+        Rect rect = { .start_row = 0, .end_row = 0, .start_col = -1, .end_col = -1 };
+        ASSERT_TRUE(screen.get_attrs_extent(rect, { .row = 0, .col = 1 }, AttrMask::All));
+        ASSERT_EQ(rect.start_col, 0);
+        ASSERT_EQ(rect.end_col, 3);
+
+        // Bold and italic differ, but the colours match
+        rect = { .start_row = 0, .end_row = 0, .start_col = -1, .end_col = -1 };
+        ASSERT_TRUE(screen.get_attrs_extent(rect, { .row = 0, .col = 1 }, AttrMask::Foreground | AttrMask::Background));
+        ASSERT_EQ(rect.start_col, 0);
+        ASSERT_EQ(rect.end_col, 4);
+    }
+}
+
+// SETDEFAULTCOL recolours both buffers, including erased cells
+TEST(screen_pen_default_colors_both_buffers)
+{
+    Terminal vt(25, 80);
+    vt.set_utf8(false);
+    Screen& screen = vt.screen();
+    screen.enable_altscreen(true);
+    screen.reset(true);
+
+    push(vt, "A\x1b[31mB\x1b[m");
+    push(vt, "\x1b[?1049hC");
+
+    screen.set_default_colors(Color::from_rgb(250, 250, 250), Color::from_rgb(10, 20, 30));
+
+    // Altscreen: the glyph and an erased cell both pick up the new defaults
+    for(int32_t col : { 2, 5 }) {
+        ScreenCell cell;
+        (void)screen.get_cell({ .row = 0, .col = col }, cell);
+        Color fg = cell.fg, bg = cell.bg;
+        screen.convert_color_to_rgb(fg);
+        screen.convert_color_to_rgb(bg);
+        ASSERT_EQ(fg.rgb.red, 250);
+        ASSERT_EQ(bg.rgb.blue, 30);
+    }
+
+    push(vt, "\x1b[?1049l");
+    {
+        ScreenCell cell;
+        (void)screen.get_cell({ .row = 0, .col = 0 }, cell);
+        ASSERT_EQ(cell.chars[0], 0x41);
+        Color fg = cell.fg;
+        screen.convert_color_to_rgb(fg);
+        ASSERT_EQ(fg.rgb.red, 250);
+
+        (void)screen.get_cell({ .row = 0, .col = 1 }, cell);
+        ASSERT_EQ(cell.chars[0], 0x42);
+        fg = cell.fg;
+        Color bg = cell.bg;
+        screen.convert_color_to_rgb(fg);
+        screen.convert_color_to_rgb(bg);
+        ASSERT_EQ(fg.rgb.red, 224);
+        ASSERT_EQ(bg.rgb.green, 20);
+    }
+}
+
+namespace {
+
+struct BlankRuns : RunSink {
+    std::vector<ScreenRun> runs;
+    std::vector<std::string> text;
+    bool on_run(const ScreenRun& run) override {
+        runs.push_back(run);
+        text.emplace_back(run.text);
+        return true;
+    }
+};
+
+bool row_has_bg(const Screen& screen, int32_t row, int32_t cols, uint8_t idx)
+{
+    for(int32_t col = 0; col < cols; col++) {
+        ScreenCell cell;
+        if(!screen.get_cell({ .row = row, .col = col }, cell))
+            return false;
+        if(cell.chars[0] != 0 || !cell.bg.is_indexed() || cell.bg.indexed.idx != idx)
+            return false;
+    }
+    return true;
+}
+
+} // anonymous namespace
+
+// Full-width erases leave rows blank with the erasing pen until written to
+TEST(screen_pen_blank_rows)
+{
+    Terminal vt(10, 20);
+    vt.set_utf8(true);
+    Screen& screen = vt.screen();
+    screen.reset(true);
+
+    push(vt, "hello\r\nworld\x1b[44m\x1b[2J");
+    for(int32_t row = 0; row < 10; row++) {
+        ASSERT_TRUE(row_has_bg(screen, row, 20, 4));
+        ASSERT_TRUE(screen.is_eol({ .row = row, .col = 0 }));
+    }
+
+    std::vector<char> text(64);
+    ASSERT_EQ(screen.get_text(text, { .start_row = 0, .end_row = 10, .start_col = 0, .end_col = 20 }), 9u);
+
+    BlankRuns sink;
+    ASSERT_TRUE(screen.get_row_runs(1, sink));
+    ASSERT_EQ(sink.runs.size(), 1u);
+    ASSERT_EQ(sink.runs[0].cols, 20);
+    ASSERT_EQ(sink.runs[0].bg.indexed.idx, 4);
+    ASSERT_STR_EQ(sink.text[0].c_str(), "                    ");
+
+    ScreenSnapshot snap = screen.snapshot();
+    ScreenCell cell;
+    ASSERT_TRUE(snap.get_cell({ .row = 5, .col = 7 }, cell));
+    ASSERT_EQ(cell.bg.indexed.idx, 4);
+
+    // Writing fills in the rest of the row from the blank pen
+    push(vt, "\x1b[m\x1b[3;5HX");
+    (void)screen.get_cell({ .row = 2, .col = 4 }, cell);
+    ASSERT_EQ(cell.chars[0], 'X');
+    ASSERT_TRUE(!cell.bg.is_indexed() || cell.bg.indexed.idx != 4);
+    (void)screen.get_cell({ .row = 2, .col = 3 }, cell);
+    ASSERT_EQ(cell.bg.indexed.idx, 4);
+    (void)screen.get_cell({ .row = 2, .col = 19 }, cell);
+    ASSERT_EQ(cell.bg.indexed.idx, 4);
+
+    // Partial erase, insert and double-width lines on blank rows
+    push(vt, "\x1b[41m\x1b[4;3H\x1b[1K\x1b[5;1H\x1b[2@\x1b[6;1H\x1b#6");
+    (void)screen.get_cell({ .row = 3, .col = 2 }, cell);
+    ASSERT_EQ(cell.bg.indexed.idx, 1);
+    (void)screen.get_cell({ .row = 3, .col = 3 }, cell);
+    ASSERT_EQ(cell.bg.indexed.idx, 4);
+    (void)screen.get_cell({ .row = 4, .col = 0 }, cell);
+    ASSERT_EQ(cell.bg.indexed.idx, 1);
+    (void)screen.get_cell({ .row = 4, .col = 2 }, cell);
+    ASSERT_EQ(cell.bg.indexed.idx, 4);
+    // DECDWL erases the right half with the current pen
+    (void)screen.get_cell({ .row = 5, .col = 9 }, cell);
+    ASSERT_EQ(cell.bg.indexed.idx, 4);
+    (void)screen.get_cell({ .row = 5, .col = 10 }, cell);
+    ASSERT_EQ(cell.bg.indexed.idx, 1);
+
+    // Scrolling rotates blank rows along with the rest
+    push(vt, "\x1b[m\x1b[10;1H\n");
+    ASSERT_TRUE(row_has_bg(screen, 0, 20, 4));
+    ASSERT_TRUE(row_has_bg(screen, 8, 20, 4));
+
+    // Compaction keeps the blank pen alive
+    std::string out;
+    for(int32_t i = 0; i < 3000; i++)
+        out += std::format("\x1b[38;2;{};{};9m\x1b[10;1HY", i & 0xff, (i >> 8) & 0xff);
+    push(vt, out);
+    ASSERT_TRUE(row_has_bg(screen, 0, 20, 4));
+
+    // Resize fills blank rows in before moving them
+    push(vt, "\x1b[m");
+    vt.set_size(12, 25);
+    (void)screen.get_cell({ .row = 1, .col = 3 }, cell);
+    ASSERT_EQ(cell.bg.indexed.idx, 4);
+}
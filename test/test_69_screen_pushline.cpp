@@ -3,6 +3,9 @@
 
 #include "harness.h"
 
+#include <format>
+#include <string>
+
 // Spillover text marks continuation on second line
 TEST(screen_pushline_continuation_lineinfo)
 {
@@ -79,3 +82,62 @@ TEST(screen_pushline_continuation_scrollback)
     ASSERT_EQ(g_cb.sb_pushline[1].chars[3], 0x41);
     ASSERT_EQ(g_cb.sb_pushline[1].chars[4], 0x41);
 }
+
+// Rows scrolled off together arrive as one block, oldest first
+TEST(screen_pushlines_block)
+{
+    struct Recorder : ScreenCallbacks {
+        int32_t calls = 0;
+        std::string text;
+        bool on_sb_pushlines(std::span<const PushedLine> lines) override {
+            calls++;
+            for(const PushedLine& line : lines)
+                text += static_cast<char>(line.cells[0].chars[0]);
+            return true;
+        }
+        bool on_sb_pushline(std::span<const ScreenCell>, bool) override {
+            text += '!';
+            return true;
+        }
+    } recorder;
+
+    Terminal vt(25, 80);
+    vt.set_utf8(false);
+    Screen& screen = vt.screen();
+    screen.set_callbacks(recorder);
+    screen.reset(true);
+
+    for(int32_t row = 0; row < 25; row++)
+        push(vt, std::format("\x1b[{}H{}", row + 1, static_cast<char>('A' + row)));
+    push(vt, "\x1b[100S");
+
+    ASSERT_EQ(recorder.calls, 1);
+    ASSERT_STR_EQ(recorder.text.c_str(), "ABCDEFGHIJKLMNOPQRSTUVWXY");
+}
+
+// Without on_sb_pushlines every row still reaches on_sb_pushline
+TEST(screen_pushlines_fallback)
+{
+    struct Recorder : ScreenCallbacks {
+        std::string text;
+        std::string continuation;
+        bool on_sb_pushline(std::span<const ScreenCell> cells, bool cont) override {
+            text += static_cast<char>(cells[0].chars[0]);
+            continuation += cont ? '+' : '-';
+            return true;
+        }
+    } recorder;
+
+    Terminal vt(10, 5);
+    vt.set_utf8(false);
+    Screen& screen = vt.screen();
+    screen.set_callbacks(recorder);
+    screen.reset(true);
+
+    push(vt, "abcdefgh\r\nij\r\nkl");
+    vt.set_size(1, 5);
+
+    ASSERT_STR_EQ(recorder.text.c_str(), "afi");
+    ASSERT_STR_EQ(recorder.continuation.c_str(), "-+-");
+    ASSERT_SCREEN_ROW(vt, screen, 0, "kl");
+}
@@ -0,0 +1,153 @@
+// test_70_screen_snapshot.cpp — immutable screen snapshots
+
+#include "harness.h"
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+// A snapshot keeps the screen as it was, whatever is written afterwards
+TEST(screen_snapshot_immutable)
+{
+    Terminal vt(25, 80);
+    vt.set_utf8(true);
+    Screen& screen = vt.screen();
+    screen.reset(true);
+
+    push(vt, "hello\e[3;5H\e[?25l");
+    ScreenSnapshot snap = screen.snapshot();
+    ASSERT_TRUE(!snap.empty());
+    ASSERT_EQ(snap.rows(), 25);
+    ASSERT_EQ(snap.cols(), 80);
+    ASSERT_EQ(snap.cursor_pos().row, 2);
+    ASSERT_EQ(snap.cursor_pos().col, 4);
+    ASSERT_TRUE(!snap.cursor_visible());
+
+    push(vt, "\e[1;1Hjello\e[2J\e[?25h");
+
+    ScreenCell cell{};
+    ASSERT_TRUE(snap.get_cell({.row = 0, .col = 0}, cell));
+    ASSERT_EQ(cell.chars[0], 'h');
+    ASSERT_EQ(snap.get_row(0)[4].chars[0], 'o');
+    ASSERT_TRUE(!snap.cursor_visible());
+    ASSERT_TRUE(!snap.get_cell({.row = 25, .col = 0}, cell));
+
+    ScreenSnapshot now = screen.snapshot();
+    ASSERT_TRUE(now.get_cell({.row = 0, .col = 0}, cell));
+    ASSERT_EQ(cell.chars[0], 0u);
+    ASSERT_TRUE(now.cursor_visible());
+
+    ScreenSnapshot none;
+    ASSERT_TRUE(none.empty());
+    ASSERT_EQ(none.rows(), 0);
+    ASSERT_TRUE(none.get_row(0).empty());
+}
+
+// Untouched rows are shared between snapshots; only written rows are copied
+TEST(screen_snapshot_shares_rows)
+{
+    Terminal vt(25, 80);
+    vt.set_utf8(true);
+    Screen& screen = vt.screen();
+    screen.reset(true);
+
+    push(vt, "\e[1;1Htop\e[4;1Hmiddle");
+    ScreenSnapshot first = screen.snapshot();
+    push(vt, "\e[4;1HMIDDLE");
+    ScreenSnapshot second = screen.snapshot();
+
+    ASSERT_TRUE(first.get_row(0).data() == second.get_row(0).data());
+    ASSERT_TRUE(first.get_row(3).data() != second.get_row(3).data());
+    ASSERT_EQ(first.get_row(3)[0].chars[0], 'm');
+    ASSERT_EQ(second.get_row(3)[0].chars[0], 'M');
+
+    // Once no snapshot holds a row, rewriting it reuses its storage
+    const ScreenCell* row3 = second.get_row(3).data();
+    first = {};
+    second = {};
+    push(vt, "\e[4;1Hmid");
+    ScreenSnapshot third = screen.snapshot();
+    ASSERT_TRUE(third.get_row(3).data() == row3);
+    ASSERT_EQ(third.get_row(3)[0].chars[0], 'm');
+    ASSERT_EQ(third.get_row(3)[3].chars[0], 'D');
+}
+
+TEST(screen_snapshot_resize_palette_altscreen)
+{
+    Terminal vt(25, 80);
+    vt.set_utf8(true);
+    Screen& screen = vt.screen();
+    screen.enable_altscreen(true);
+    screen.reset(true);
+
+    push(vt, "\e#6primary");
+    ScreenSnapshot before = screen.snapshot();
+    ASSERT_EQ(before.get_lineinfo(0).doublewidth, 1u);
+
+    vt.set_size(30, 100);
+    vt.state().set_palette_color(1, Color::from_rgb(1, 2, 3));
+    push(vt, "\e[?1049h\e[Halt");
+    ScreenSnapshot after = screen.snapshot();
+    ASSERT_EQ(after.rows(), 30);
+    ASSERT_EQ(after.cols(), 100);
+    ASSERT_EQ(after.get_row(29).size(), 100u);
+    ASSERT_EQ(after.get_row(0)[0].chars[0], 'a');
+    ASSERT_EQ(after.get_lineinfo(0).doublewidth, 0u);
+
+    Color red = Color::from_index(1);
+    after.convert_color_to_rgb(red);
+    ASSERT_EQ(red.rgb.red, 1);
+    ASSERT_EQ(red.rgb.blue, 3);
+
+    Color old_red = Color::from_index(1);
+    before.convert_color_to_rgb(old_red);
+    ASSERT_TRUE(old_red.rgb.red != 1);
+    ASSERT_EQ(before.rows(), 25);
+    ASSERT_EQ(before.get_row(0)[0].chars[0], 'p');
+}
+
+// A reader thread works on snapshots while the terminal keeps writing
+TEST(screen_snapshot_concurrent_reader)
+{
+    Terminal vt(25, 80);
+    vt.set_utf8(true);
+    Screen& screen = vt.screen();
+    screen.reset(true);
+
+    // Only the handoff is locked; reading a snapshot needs no lock
+    std::mutex handoff;
+    ScreenSnapshot published = screen.snapshot();
+    std::atomic<bool> done{false};
+    std::atomic<int32_t> bad{0};
+
+    std::thread reader([&] {
+        while(!done.load()) {
+            ScreenSnapshot snap;
+            {
+                std::lock_guard lock(handoff);
+                snap = published;
+            }
+            // Every row is a run of one letter, so a torn row would show up
+            for(int32_t row = 0; row < snap.rows(); row++) {
+                auto cells = snap.get_row(row);
+                for(const ScreenCell& cell : cells)
+                    if(cell.chars[0] != cells[0].chars[0])
+                        bad++;
+            }
+        }
+    });
+
+    for(int32_t i = 0; i < 2000; i++) {
+        char letter = static_cast<char>('A' + i % 26);
+        push(vt, std::format("\e[{};1H{}", i % 25 + 1, std::string(80, letter)));
+        if(i % 7 == 0) {
+            ScreenSnapshot snap = screen.snapshot();
+            std::lock_guard lock(handoff);
+            published = std::move(snap);
+        }
+    }
+    done = true;
+    reader.join();
+
+    ASSERT_EQ(bad.load(), 0);
+}
@@ -0,0 +1,109 @@
+// test_71_screen_row_runs.cpp — rows as attribute runs
+
+#include "harness.h"
+
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Run {
+    int32_t start_col;
+    int32_t cols;
+    CellAttrs attrs;
+    Color fg, bg;
+    std::string text;
+};
+
+struct RunCollector : RunSink {
+    std::vector<Run> runs;
+    size_t stop_after = SIZE_MAX;
+
+    bool on_run(const ScreenRun& run) override {
+        runs.push_back({run.start_col, run.cols, run.attrs, run.fg, run.bg, std::string(run.text)});
+        return runs.size() < stop_after;
+    }
+};
+
+} // anonymous namespace
+
+TEST(screen_row_runs_attrs)
+{
+    Terminal vt(25, 20);
+    vt.set_utf8(true);
+    Screen& screen = vt.screen();
+    screen.reset(true);
+
+    push(vt, "ab\e[1mcd\e[31mef\e[m  g");
+
+    RunCollector sink;
+    ASSERT_TRUE(screen.get_row_runs(0, sink));
+    ASSERT_EQ(sink.runs.size(), 4u);
+
+    ASSERT_EQ(sink.runs[0].start_col, 0);
+    ASSERT_EQ(sink.runs[0].cols, 2);
+    ASSERT_STR_EQ(sink.runs[0].text.c_str(), "ab");
+    ASSERT_EQ(sink.runs[0].attrs.bold, 0u);
+
+    ASSERT_EQ(sink.runs[1].start_col, 2);
+    ASSERT_STR_EQ(sink.runs[1].text.c_str(), "cd");
+    ASSERT_EQ(sink.runs[1].attrs.bold, 1u);
+
+    ASSERT_EQ(sink.runs[2].start_col, 4);
+    ASSERT_STR_EQ(sink.runs[2].text.c_str(), "ef");
+    ASSERT_TRUE(sink.runs[2].fg.is_indexed());
+    ASSERT_EQ(sink.runs[2].fg.indexed.idx, 1);
+
+    // Erased cells are spaces, through to the end of the row
+    ASSERT_EQ(sink.runs[3].start_col, 6);
+    ASSERT_EQ(sink.runs[3].cols, 14);
+    ASSERT_STR_EQ(sink.runs[3].text.c_str(), "  g           ");
+
+    ASSERT_TRUE(!screen.get_row_runs(25, sink));
+    ASSERT_TRUE(!screen.get_row_runs(-1, sink));
+}
+
+// Text matches what get_cell reports, cell by cell
+TEST(screen_row_runs_unicode)
+{
+    Terminal vt(25, 10);
+    vt.set_utf8(true);
+    Screen& screen = vt.screen();
+    screen.reset(true);
+
+    // é, a wide char, e + combining acute, then reverse video
+    push(vt, "\xc3\xa9\xef\xbc\x90" "e\xcc\x81\e[7mx");
+
+    RunCollector sink;
+    ASSERT_TRUE(screen.get_row_runs(0, sink));
+    ASSERT_EQ(sink.runs.size(), 3u);
+    ASSERT_EQ(sink.runs[0].cols, 4);
+    ASSERT_STR_EQ(sink.runs[0].text.c_str(), "\xc3\xa9\xef\xbc\x90" "e\xcc\x81");
+    ASSERT_EQ(sink.runs[1].start_col, 4);
+    ASSERT_EQ(sink.runs[1].attrs.reverse, 1u);
+    ASSERT_STR_EQ(sink.runs[1].text.c_str(), "x");
+    ASSERT_STR_EQ(sink.runs[2].text.c_str(), "     ");
+
+    // DECSCNM flips reverse on the way out, as get_cell does
+    push(vt, "\e[?5h");
+    sink.runs.clear();
+    ASSERT_TRUE(screen.get_row_runs(0, sink));
+    ASSERT_EQ(sink.runs[0].attrs.reverse, 1u);
+    ASSERT_EQ(sink.runs[1].attrs.reverse, 0u);
+}
+
+TEST(screen_row_runs_stop)
+{
+    Terminal vt(25, 20);
+    vt.set_utf8(true);
+    Screen& screen = vt.screen();
+    screen.reset(true);
+
+    push(vt, "\e[1ma\e[4mb\e[3mc");
+
+    RunCollector sink;
+    sink.stop_after = 2;
+    ASSERT_TRUE(screen.get_row_runs(0, sink));
+    ASSERT_EQ(sink.runs.size(), 2u);
+    ASSERT_STR_EQ(sink.runs[1].text.c_str(), "b");
+}
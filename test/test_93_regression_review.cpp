@@ -34,8 +34,8 @@ static std::vector<ScreenCell> make_row(std::string_view text, int32_t padto = 0
 static bool assert_no_split_wide_chars_sb(int32_t* _test_failures,
                                            const Scrollback::Impl& impl,
                                            int32_t cols) {
-    for(size_t i = 0; i < impl.lines.size(); i++) {
-        const auto& line = impl.lines[i];
+    for(size_t i = 0; i < impl.size(); i++) {
+        const auto line = impl.line(i);
         if(static_cast<int32_t>(line.cells.size()) >= cols &&
            line.cells[static_cast<size_t>(cols - 1)].width == 2) {
             std::cerr << std::format("  FAIL {}:{}: scrollback row {}: width-2 cell at last column {}\n",
@@ -254,8 +254,8 @@ TEST(regression_wide_char_scrollback_reflow)
     // Verify all content survived
     bool found_cjk = false;
     int ascii_count = 0;
-    for(const auto& line : impl.lines) {
-        for(const auto& cell : line.cells) {
+    for(size_t i = 0; i < impl.size(); i++) {
+        for(const auto& cell : impl.line(i).cells) {
             if(cell.chars[0] == 0x4E00) found_cjk = true;
             if(cell.chars[0] >= 'A' && cell.chars[0] <= 'H') ascii_count++;
         }
@@ -534,13 +534,13 @@ TEST(regression_scrollback_evict_resize_tracking)
     impl.push_line(make_row("OLD1", 10), false);
     impl.push_line(make_row("OLD2", 10), false);
     impl.push_line(make_row("OLD3", 10), false);
-    ASSERT_EQ(impl.lines.size(), 3);
+    ASSERT_EQ(impl.size(), 3);
 
     impl.begin_resize();
 
     impl.push_line(make_row("NEW1", 10), false);
     impl.push_line(make_row("NEW2", 10), false);
-    ASSERT_EQ(impl.lines.size(), 3);
+    ASSERT_EQ(impl.size(), 3);
 
     impl.commit_resize(5, 3, 10, 10);
     ASSERT_EQ(impl.push_track_count, 2);
@@ -548,12 +548,12 @@ TEST(regression_scrollback_evict_resize_tracking)
     impl.begin_resize();
     impl.commit_resize(3, 5, 10, 10);
 
-    ASSERT_EQ(impl.lines.size(), 1);
+    ASSERT_EQ(impl.size(), 1);
 
-    ASSERT_EQ(impl.lines[0].cells[0].chars[0], 'O');
-    ASSERT_EQ(impl.lines[0].cells[1].chars[0], 'L');
-    ASSERT_EQ(impl.lines[0].cells[2].chars[0], 'D');
-    ASSERT_EQ(impl.lines[0].cells[3].chars[0], '3');
+    ASSERT_EQ(impl.line(0).cells[0].chars[0], 'O');
+    ASSERT_EQ(impl.line(0).cells[1].chars[0], 'L');
+    ASSERT_EQ(impl.line(0).cells[2].chars[0], 'D');
+    ASSERT_EQ(impl.line(0).cells[3].chars[0], '3');
 
     ASSERT_EQ(impl.push_track_count, 0);
     ASSERT_EQ(impl.push_track_start, 0);
@@ -813,18 +813,18 @@ TEST(regression_scrollback_resize_contiguity)
     impl.push_line(make_row("LINE1", 10), false);
     impl.push_line(make_row("LINE2", 10), false);
     impl.push_line(make_row("LINE3", 10), false);
-    ASSERT_EQ(impl.lines.size(), 3);
+    ASSERT_EQ(impl.size(), 3);
 
     // First shrink: pushes 1 line (simulating screen pushing to scrollback)
     impl.begin_resize();
     impl.push_line(make_row("SHRK1", 10), false);
     impl.commit_resize(5, 4, 10, 10);  // shrink by 1 row
     ASSERT_EQ(impl.push_track_count, 1);
-    ASSERT_EQ(impl.lines.size(), 4);
+    ASSERT_EQ(impl.size(), 4);
 
     // Normal push between resizes — breaks contiguity
     impl.push_line(make_row("NORM1", 10), false);
-    ASSERT_EQ(impl.lines.size(), 5);
+    ASSERT_EQ(impl.size(), 5);
 
     // Second shrink: pushes 1 more line
     impl.begin_resize();
@@ -834,17 +834,18 @@ TEST(regression_scrollback_resize_contiguity)
     // Bug: push_track_count = 1 + 1 = 2, spanning across NORM1.
     // Fix: contiguity broken → reset, push_track_count = 1 (only SHRK2).
     ASSERT_EQ(impl.push_track_count, 1);
-    ASSERT_EQ(impl.lines.size(), 6);
+    ASSERT_EQ(impl.size(), 6);
 
     // Grow: should only erase SHRK2, not NORM1
     impl.begin_resize();
     impl.commit_resize(3, 4, 10, 10);  // grow by 1 row
 
-    ASSERT_EQ(impl.lines.size(), 5);
+    ASSERT_EQ(impl.size(), 5);
 
     // NORM1 must survive — it's real content, not a resize artifact
     bool found_norm = false;
-    for(const auto& line : impl.lines) {
+    for(size_t i = 0; i < impl.size(); i++) {
+        const auto line = impl.line(i);
         if(line.cells.size() >= 4 &&
            line.cells[0].chars[0] == 'N' &&
            line.cells[1].chars[0] == 'O' &&
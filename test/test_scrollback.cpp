@@ -10,6 +10,7 @@
 #include <array>
 #include <cstdlib>
 #include <filesystem>
+#include <format>
 #include <fstream>
 #include <random>
 #include <sstream>
@@ -169,7 +170,7 @@ TEST(scrollback_push_pop) {
     impl.push_line(make_row("BBBB", 10), true);
     impl.push_line(make_row("CCCC", 10), false);
 
-    ASSERT_EQ(impl.lines.size(), 3);
+    ASSERT_EQ(impl.size(), 3);
 
     // Pop in LIFO order
     std::vector<ScreenCell> buf(10);
@@ -187,7 +188,7 @@ TEST(scrollback_push_pop) {
     ASSERT_EQ(buf[0].chars[0], 'A');
     ASSERT_EQ(cont, false);
 
-    ASSERT_TRUE(impl.lines.empty());
+    ASSERT_TRUE(impl.empty());
     ASSERT_TRUE(!impl.pop_line(buf, cont));
 }
 
@@ -201,9 +202,9 @@ TEST(scrollback_capacity_eviction) {
     }
 
     // Should have evicted oldest 3 (A, B, C)
-    ASSERT_EQ(impl.lines.size(), 5);
-    ASSERT_EQ(impl.lines[0].cells[0].chars[0], 'D'); // oldest remaining
-    ASSERT_EQ(impl.lines[4].cells[0].chars[0], 'H'); // newest
+    ASSERT_EQ(impl.size(), 5);
+    ASSERT_EQ(impl.line(0).cells[0].chars[0], 'D'); // oldest remaining
+    ASSERT_EQ(impl.line(4).cells[0].chars[0], 'H'); // newest
 }
 
 TEST(scrollback_clear) {
@@ -212,10 +213,10 @@ TEST(scrollback_clear) {
 
     impl.push_line(make_row("A", 10), false);
     impl.push_line(make_row("B", 10), false);
-    ASSERT_EQ(impl.lines.size(), 2);
+    ASSERT_EQ(impl.size(), 2);
 
     impl.clear();
-    ASSERT_TRUE(impl.lines.empty());
+    ASSERT_TRUE(impl.empty());
 }
 
 TEST(scrollback_line_access) {
@@ -227,16 +228,16 @@ TEST(scrollback_line_access) {
     impl.push_line(make_row("LAST", 10), false);
 
     // [0] = oldest
-    ASSERT_EQ(impl.lines[0].cells[0].chars[0], 'F');
-    ASSERT_EQ(impl.lines[0].continuation, false);
+    ASSERT_EQ(impl.line(0).cells[0].chars[0], 'F');
+    ASSERT_EQ(impl.line(0).continuation, false);
 
     // [1] = middle
-    ASSERT_EQ(impl.lines[1].cells[0].chars[0], 'M');
-    ASSERT_EQ(impl.lines[1].continuation, true);
+    ASSERT_EQ(impl.line(1).cells[0].chars[0], 'M');
+    ASSERT_EQ(impl.line(1).continuation, true);
 
     // [2] = newest
-    ASSERT_EQ(impl.lines[2].cells[0].chars[0], 'L');
-    ASSERT_EQ(impl.lines[2].continuation, false);
+    ASSERT_EQ(impl.line(2).cells[0].chars[0], 'L');
+    ASSERT_EQ(impl.line(2).continuation, false);
 }
 
 TEST(scrollback_reflow_wider) {
@@ -247,14 +248,14 @@ TEST(scrollback_reflow_wider) {
     impl.push_line(make_row("ABCDE", 5), false);
     impl.push_line(make_row("FGH", 5), true);
 
-    ASSERT_EQ(impl.lines.size(), 2);
+    ASSERT_EQ(impl.size(), 2);
 
     impl.reflow(10);
 
     // Should be single line now
-    ASSERT_EQ(impl.lines.size(), 1);
-    ASSERT_EQ(impl.lines[0].continuation, false);
-    ASSERT_TRUE(sb_line_text(impl.lines[0]) == "ABCDEFGH");
+    ASSERT_EQ(impl.size(), 1);
+    ASSERT_EQ(impl.line(0).continuation, false);
+    ASSERT_TRUE(sb_line_text(impl.line(0)) == "ABCDEFGH");
 }
 
 TEST(scrollback_reflow_narrower) {
@@ -266,11 +267,11 @@ TEST(scrollback_reflow_narrower) {
     impl.reflow(4);
 
     // Should be 2 lines: "ABCD" + "EFGH" (continuation)
-    ASSERT_EQ(impl.lines.size(), 2);
-    ASSERT_EQ(impl.lines[0].continuation, false);
-    ASSERT_EQ(impl.lines[1].continuation, true);
-    ASSERT_TRUE(sb_line_text(impl.lines[0]) == "ABCD");
-    ASSERT_TRUE(sb_line_text(impl.lines[1]) == "EFGH");
+    ASSERT_EQ(impl.size(), 2);
+    ASSERT_EQ(impl.line(0).continuation, false);
+    ASSERT_EQ(impl.line(1).continuation, true);
+    ASSERT_TRUE(sb_line_text(impl.line(0)) == "ABCD");
+    ASSERT_TRUE(sb_line_text(impl.line(1)) == "EFGH");
 }
 
 TEST(scrollback_reflow_empty_line) {
@@ -282,10 +283,91 @@ TEST(scrollback_reflow_empty_line) {
 
     impl.reflow(5);
 
-    ASSERT_EQ(impl.lines.size(), 2);
-    ASSERT_TRUE(sb_line_text(impl.lines[0]).empty());
-    ASSERT_EQ(impl.lines[0].continuation, false);
-    ASSERT_TRUE(sb_line_text(impl.lines[1]) == "HELLO");
+    ASSERT_EQ(impl.size(), 2);
+    ASSERT_TRUE(sb_line_text(impl.line(0)).empty());
+    ASSERT_EQ(impl.line(0).continuation, false);
+    ASSERT_TRUE(sb_line_text(impl.line(1)) == "HELLO");
+}
+
+// Rows popped from a re-wrapped line come back at the new width
+TEST(scrollback_reflow_pop) {
+    Scrollback::Impl impl;
+    impl.capacity = 100;
+
+    impl.push_line(make_row("XY", 8), false);
+    impl.push_line(make_row("ABCDEFGH", 8), false);
+    impl.reflow(3);
+
+    ASSERT_EQ(impl.size(), 4);
+    std::vector<ScreenCell> buf(3);
+    bool cont = false;
+    ASSERT_TRUE(impl.pop_line(buf, cont));
+    ASSERT_EQ(buf[0].chars[0], 'G');
+    ASSERT_EQ(buf[2].chars[0], 0);
+    ASSERT_EQ(cont, true);
+
+    ASSERT_EQ(impl.size(), 3);
+    ASSERT_TRUE(sb_line_text(impl.line(1)) == "ABC");
+    ASSERT_TRUE(sb_line_text(impl.line(2)) == "DEF");
+    ASSERT_EQ(impl.line(2).continuation, true);
+
+    // The rows left behind re-wrap as one line again
+    impl.reflow(8);
+    ASSERT_EQ(impl.size(), 2);
+    ASSERT_TRUE(sb_line_text(impl.line(1)) == "ABCDEF");
+}
+
+// Capacity applies to rows at the new width; a line cut by it keeps its tail
+TEST(scrollback_reflow_capacity_cut) {
+    Scrollback::Impl impl;
+    impl.capacity = 2;
+
+    impl.push_line(make_row("ABCDEFGHIJ", 10), false);
+    impl.push_line(make_row("KL", 10), true);
+    impl.reflow(4);
+
+    ASSERT_EQ(impl.size(), 2);
+    ASSERT_TRUE(sb_line_text(impl.line(0)) == "EFGH");
+    ASSERT_EQ(impl.line(0).continuation, true);
+    ASSERT_TRUE(sb_line_text(impl.line(1)) == "IJKL");
+
+    impl.push_line(make_row("MNOP", 4), false);
+    ASSERT_EQ(impl.size(), 2);
+    ASSERT_TRUE(sb_line_text(impl.line(0)) == "IJKL");
+    ASSERT_EQ(impl.line(0).continuation, true);
+
+    impl.reflow(6);
+    ASSERT_EQ(impl.size(), 2);
+    ASSERT_TRUE(sb_line_text(impl.line(0)) == "IJKL");
+    ASSERT_EQ(impl.line(0).continuation, false);
+    ASSERT_TRUE(sb_line_text(impl.line(1)) == "MNOP");
+}
+
+// Rows pushed after a width change are shown as pushed, after the re-wrapped
+// ones, until the next width change joins them in
+TEST(scrollback_reflow_then_push) {
+    Scrollback::Impl impl;
+    impl.capacity = 100;
+
+    impl.push_line(make_row("ABCDEF", 6), false);
+    impl.reflow(4);
+    impl.push_line(make_row("GHIJ", 4), false);
+
+    ASSERT_EQ(impl.size(), 3);
+    ASSERT_TRUE(sb_line_text(impl.line(0)) == "ABCD");
+    ASSERT_TRUE(sb_line_text(impl.line(1)) == "EF");
+    ASSERT_TRUE(sb_line_text(impl.line(2)) == "GHIJ");
+
+    std::vector<ScreenCell> cells(4);
+    bool cont = false;
+    ASSERT_EQ(impl.read_line(1, cells, cont), 4);
+    ASSERT_EQ(cells[1].chars[0], 'F');
+    ASSERT_EQ(cont, true);
+
+    impl.reflow(10);
+    ASSERT_EQ(impl.size(), 2);
+    ASSERT_TRUE(sb_line_text(impl.line(0)) == "ABCDEF");
+    ASSERT_TRUE(sb_line_text(impl.line(1)) == "GHIJ");
 }
 
 TEST(scrollback_resize_comp_shrink_grow) {
@@ -297,14 +379,14 @@ TEST(scrollback_resize_comp_shrink_grow) {
     impl.push_line(make_row("PUSHED2", 10), false);
     impl.commit_resize(4, 2, 10, 10);
 
-    ASSERT_EQ(impl.lines.size(), 2);
+    ASSERT_EQ(impl.size(), 2);
 
     // Grow back
     impl.begin_resize();
     impl.commit_resize(2, 4, 10, 10);
 
     // Tracked lines should be erased
-    ASSERT_EQ(impl.lines.size(), 0);
+    ASSERT_EQ(impl.size(), 0);
 }
 
 TEST(scrollback_resize_comp_width_change_resets) {
@@ -332,19 +414,291 @@ TEST(scrollback_resize_comp_capacity_eviction) {
     impl.push_line(make_row("OLD1", 10), false);
     impl.push_line(make_row("OLD2", 10), false);
     impl.push_line(make_row("OLD3", 10), false);
-    ASSERT_EQ(impl.lines.size(), 3);
+    ASSERT_EQ(impl.size(), 3);
 
     // Begin tracking, push more (triggers eviction)
     impl.begin_resize();
     impl.push_line(make_row("NEW1", 10), false);
-    ASSERT_EQ(impl.lines.size(), 3);
+    ASSERT_EQ(impl.size(), 3);
 
     impl.push_line(make_row("NEW2", 10), false);
-    ASSERT_EQ(impl.lines.size(), 3);
+    ASSERT_EQ(impl.size(), 3);
 
     impl.commit_resize(4, 2, 10, 10);
 
-    ASSERT_TRUE(impl.lines.size() <= 3);
+    ASSERT_TRUE(impl.size() <= 3);
+}
+
+// A block larger than the capacity ends like the same rows pushed one by one
+TEST(scrollback_push_lines_block) {
+    std::vector<std::vector<ScreenCell>> rows;
+    std::vector<PushedLine> block;
+    for(int i = 0; i < 8; i++)
+        rows.push_back(make_row(std::string(1, static_cast<char>('A' + i)), 10));
+    for(int i = 0; i < 8; i++)
+        block.push_back({.cells = rows[i], .continuation = i % 2 == 1});
+
+    Scrollback::Impl single;
+    Scrollback::Impl bulk;
+    for(Scrollback::Impl* impl : {&single, &bulk}) {
+        impl->capacity = 5;
+        impl->push_line(make_row("OLD1", 10), false);
+        impl->push_line(make_row("OLD2", 10), false);
+        impl->begin_resize();
+    }
+    for(const PushedLine& line : block)
+        single.push_line(line.cells, line.continuation);
+    bulk.push_lines(block);
+
+    ASSERT_EQ(bulk.size(), 5);
+    ASSERT_EQ(bulk.line(0).cells[0].chars[0], 'D');
+    ASSERT_EQ(bulk.line(0).continuation, true);
+    ASSERT_EQ(bulk.line(4).cells[0].chars[0], 'H');
+    ASSERT_EQ(bulk.sb_before_resize, single.sb_before_resize);
+
+    single.commit_resize(12, 4, 10, 10);
+    bulk.commit_resize(12, 4, 10, 10);
+    ASSERT_EQ(bulk.push_track_start, single.push_track_start);
+    ASSERT_EQ(bulk.push_track_count, single.push_track_count);
+}
+
+// A deferred drag lands on the same state as one direct resize to the end size
+TEST(scrollback_deferred_resize_matches_direct) {
+    SB_SETUP(24, 80, 500);
+    Terminal ref(25, 80);
+    ref.set_utf8(false);
+    ref.state().set_callbacks(state_cbs_no_scrollrect);
+    ref.state().reset(true);
+    Scrollback& ref_sb = ref.scrollback();
+    ref_sb.set_capacity(500);
+    ref.screen().enable_reflow(true);
+    ref.set_size(24, 80);
+    ref.screen().reset(true);
+
+    for(int i = 0; i < 200; i++) {
+        std::string line = "Line" + std::to_string(i) + std::string(static_cast<size_t>(i % 90), 'x') + "\r\n";
+        push(vt, line);
+        push(ref, line);
+    }
+
+    vt.enable_deferred_resize(true);
+    for(int step = 0; step < 30; step++)
+        vt.set_size(24 - step / 3, 80 - step * 2);
+    for(int step = 0; step < 30; step++)
+        vt.set_size(14 + step / 2, 20 + step * 3);
+    ASSERT_EQ(vt.rows(), 24);
+    ASSERT_EQ(vt.cols(), 80);
+
+    vt.commit_resize();
+    ref.set_size(28, 107);
+    ASSERT_EQ(vt.rows(), 28);
+    ASSERT_EQ(vt.cols(), 107);
+    ASSERT_TRUE(capture_state(vt, sb) == capture_state(ref, ref_sb));
+}
+
+// The next write applies the pending size before parsing
+TEST(scrollback_deferred_resize_commits_on_write) {
+    SB_SETUP(24, 80, 100);
+    vt.enable_deferred_resize(true);
+
+    vt.set_size(24, 40);
+    ASSERT_EQ(vt.cols(), 80);
+
+    push(vt, std::string(50, 'A'));
+    ASSERT_EQ(vt.cols(), 40);
+    std::string full_row(40, 'A');
+    ASSERT_SCREEN_ROW(vt, screen, 0, full_row.c_str());
+    ASSERT_SCREEN_ROW(vt, screen, 1, "AAAAAAAAAA");
+
+    vt.set_size(24, 60);
+    vt.enable_deferred_resize(false);
+    ASSERT_EQ(vt.cols(), 60);
+    vt.set_size(24, 70);
+    ASSERT_EQ(vt.cols(), 70);
+}
+
+// Background reflow ends in the same state as reflowing on the spot, with
+// output and row-only resizes while it runs
+TEST(scrollback_background_reflow_matches_sync) {
+    SB_SETUP(24, 80, 5000);
+    vt.set_utf8(true);
+    sb.enable_background_reflow(true);
+    Terminal ref(25, 80);
+    ref.set_utf8(true);
+    ref.state().set_callbacks(state_cbs_no_scrollrect);
+    ref.state().reset(true);
+    Scrollback& ref_sb = ref.scrollback();
+    ref_sb.set_capacity(5000);
+    ref.screen().enable_reflow(true);
+    ref.set_size(24, 80);
+    ref.screen().reset(true);
+
+    auto both = [&](const std::string& text) {
+        push(vt, text);
+        push(ref, text);
+    };
+    for(int i = 0; i < 300; i++)
+        both("Line" + std::to_string(i) + std::string(static_cast<size_t>(i % 70), 'x') +
+             (i % 3 == 0 ? "\xe4\xb8\x80\xe4\xb8\x80 wide\r\n" : "\r\n"));
+
+    const std::array<std::pair<int32_t, int32_t>, 8> sizes = {{
+        {24, 50}, {20, 50}, {30, 50}, {30, 97}, {18, 61}, {18, 61}, {26, 61}, {24, 80},
+    }};
+    for(size_t i = 0; i < sizes.size(); i++) {
+        vt.set_size(sizes[i].first, sizes[i].second);
+        ref.set_size(sizes[i].first, sizes[i].second);
+        if(i % 2 == 0)
+            both("more output " + std::to_string(i) + "\r\n");
+    }
+
+    sb.wait_reflow();
+    ASSERT_TRUE(!sb.reflow_pending());
+    ASSERT_TRUE(capture_state(vt, sb) == capture_state(ref, ref_sb));
+}
+
+// Until the worker is done, lines read as they were before the width change
+TEST(scrollback_background_reflow_shows_old_width) {
+    SB_SETUP(24, 80, 1000);
+    sb.enable_background_reflow(true);
+    push(vt, std::string(100, 'A') + "\r\n");
+    for(int i = 0; i < 30; i++)
+        push(vt, "line\r\n");
+    ASSERT_EQ(sb.size(), 9u);
+
+    vt.set_size(24, 40);
+    bool continuation = true;
+    std::vector<ScreenCell> cells(80);
+    ASSERT_EQ(sb.read_line(0, cells, continuation), 80u);
+    ASSERT_TRUE(!continuation);
+    ASSERT_EQ(sb.line(1).cells.size(), 80u);
+    ASSERT_TRUE(sb.line(1).continuation);
+
+    sb.wait_reflow();
+    ASSERT_TRUE(!sb.reflow_pending());
+    ASSERT_EQ(sb.size(), 10u);
+    ASSERT_EQ(sb.read_line(2, cells, continuation), 40u);
+    ASSERT_TRUE(continuation);
+    ASSERT_EQ(cells[19].chars[0], static_cast<uint32_t>('A'));
+    ASSERT_EQ(cells[20].chars[0], 0u);
+}
+
+// Packed rows decode to exactly the cells that were pushed
+TEST(scrollback_packed_roundtrip) {
+    Scrollback::Impl impl;
+    impl.capacity = 1000;
+
+    std::mt19937 rng(7);
+    const std::array<uint32_t, 8> glyphs = { 'a', 0, 0xe9, 0x4e00, 0x1f600, 0x7fffffff, 0x80000001, 0x301 };
+
+    std::vector<std::vector<ScreenCell>> pushed;
+    for(int32_t n = 0; n < 300; n++) {
+        std::vector<ScreenCell> row(static_cast<size_t>(1 + rng() % 120));
+        for(size_t i = 0; i < row.size(); i++) {
+            ScreenCell& cell = row[i];
+            cell.width = 1;
+            if(rng() % 4 == 0)
+                continue;  // blank
+            cell.chars[0] = glyphs[rng() % glyphs.size()];
+            if(rng() % 8 == 0)
+                cell.chars[1] = 0x300 + rng() % 0x70;
+            if(cell.chars[0] == 0x4e00 && i + 1 < row.size()) {
+                cell.width = 2;
+                row[++i].chars[0] = 0xffffffff;
+                row[i].width = 1;
+            }
+            if(rng() % 16 == 0)
+                cell.width = 0;  // not inferable from the text
+        }
+        // Style runs, including a coloured blank tail
+        ScreenCell style{};
+        for(size_t i = 0; i < row.size(); i++) {
+            if(rng() % 10 == 0) {
+                style.attrs.bold = rng() % 2;
+                style.attrs.underline = static_cast<Underline>(rng() % 3);
+                style.attrs.font = rng() % 10;
+                style.fg = Color::from_index(static_cast<uint8_t>(rng()));
+                style.bg = Color::from_rgb(static_cast<uint8_t>(rng()), 2, 3);
+            }
+            row[i].attrs = style.attrs;
+            row[i].fg = style.fg;
+            row[i].bg = style.bg;
+        }
+        impl.push_line(row, n % 3 == 1);
+        pushed.push_back(std::move(row));
+    }
+
+    auto same_cell = [](const ScreenCell& a, const ScreenCell& b) {
+        return a.chars == b.chars && a.width == b.width && a.fg == b.fg && a.bg == b.bg &&
+               a.attrs.bold == b.attrs.bold && a.attrs.underline == b.attrs.underline &&
+               a.attrs.font == b.attrs.font;
+    };
+
+    ASSERT_EQ(impl.size(), pushed.size());
+    for(size_t n = 0; n < pushed.size(); n++) {
+        Scrollback::Line line = impl.line(n);
+        ASSERT_EQ(line.cells.size(), pushed[n].size());
+        ASSERT_EQ(line.continuation, n % 3 == 1);
+        for(size_t i = 0; i < line.cells.size(); i++)
+            ASSERT_TRUE(same_cell(line.cells[i], pushed[n][i]));
+    }
+
+    // Popping into a narrower or wider buffer truncates or pads with blanks
+    std::vector<ScreenCell> buf(200);
+    bool cont = false;
+    for(size_t n = pushed.size(); n-- > 250; ) {
+        std::span<ScreenCell> cells = std::span(buf).first(n % 2 ? 200 : 5);
+        ASSERT_TRUE(impl.pop_line(cells, cont));
+        ASSERT_EQ(cont, n % 3 == 1);
+        for(size_t i = 0; i < cells.size(); i++) {
+            if(i < pushed[n].size())
+                ASSERT_TRUE(same_cell(cells[i], pushed[n][i]));
+            else
+                ASSERT_TRUE(same_cell(cells[i], ScreenCell{ .width = 1 }));
+        }
+    }
+    ASSERT_EQ(impl.size(), 250);
+}
+
+// At capacity, blocks are recycled rather than growing
+TEST(scrollback_packed_steady_state) {
+    Scrollback::Impl impl;
+    impl.capacity = 5000;
+
+    auto row = make_row("the quick brown fox jumps over the lazy dog", 200);
+    // Fill, then cycle once so a spare block exists
+    for(int32_t i = 0; i < 10000; i++)
+        impl.push_line(row, false);
+    size_t full = impl.store.memory_usage();
+
+    for(int32_t i = 0; i < 50000; i++)
+        impl.push_line(row, false);
+    ASSERT_EQ(impl.size(), 5000);
+    ASSERT_EQ(impl.store.memory_usage(), full);
+
+    // Far smaller than 200 unpacked cells per line
+    ASSERT_TRUE(full < 5000 * 200 * sizeof(ScreenCell) / 20);
+
+    std::vector<ScreenCell> cells(200);
+    bool cont = true;
+    impl.store.decode(4999, cells, cont);
+    ASSERT_EQ(cells[4].chars[0], 'q');
+    ASSERT_EQ(cont, false);
+}
+
+TEST(scrollback_read_line) {
+    SB_SETUP(3, 10, 100);
+
+    push(vt, "LINE1\r\nLINE2\r\nLINE3\r\nLINE4");
+    ASSERT_EQ(sb.size(), 1);
+
+    std::array<ScreenCell, 12> cells{};
+    bool cont = true;
+    ASSERT_EQ(sb.read_line(0, cells, cont), 10);
+    ASSERT_EQ(cont, false);
+    ASSERT_EQ(cells[0].chars[0], 'L');
+    ASSERT_EQ(cells[4].chars[0], '1');
+    ASSERT_EQ(cells[5].chars[0], 0);
+    ASSERT_EQ(cells[11].width, 1);
 }
 
 // ============================================================================
@@ -461,6 +815,117 @@ TEST(scrollback_screen_callback_still_fires) {
     ASSERT_EQ(g_scrollback[0].cells[0].chars[0], 'L');
 }
 
+// capture_state() plus continuation marks and background colours
+static std::string capture_direct(Terminal& vt, Scrollback& sb) {
+    std::ostringstream os;
+    os << capture_state(vt, sb);
+    auto bg_of = [](const ScreenCell& cell) {
+        return cell.bg.is_indexed() ? static_cast<char>('0' + cell.bg.indexed.idx % 10) : '.';
+    };
+    for(size_t i = 0; i < sb.size(); i++) {
+        const auto line = sb.line(i);
+        for(const auto& cell : line.cells)
+            os << bg_of(cell);
+        os << "\n";
+    }
+    Screen& screen = vt.screen();
+    State& state = vt.state();
+    for(int32_t r = 0; r < vt.rows(); r++) {
+        os << (state.get_lineinfo(r).continuation ? '+' : ' ');
+        for(int32_t c = 0; c < vt.cols(); c++) {
+            ScreenCell cell{};
+            (void)screen.get_cell({r, c}, cell);
+            os << bg_of(cell);
+        }
+        os << "\n";
+    }
+    return os.str();
+}
+
+// Plain text written in one go, straight into scrollback, ends up exactly as
+// when every byte goes through the parser
+TEST(scrollback_screen_direct_matches_parsed) {
+    constexpr std::array<std::string_view, 6> endings = {"\r\n", "\n", "\r\r\n", "\r\n", "\n\n", "\r\n"};
+
+    std::mt19937 rng(7);
+    std::string text;
+    for(int i = 0; i < 4000; i++) {
+        int len = static_cast<int>(rng() % 26);
+        for(int j = 0; j < len; j++)
+            text += static_cast<char>('a' + (i + j) % 26);
+        text += endings[rng() % endings.size()];
+        // Colour changes, a UTF-8 glyph and newline mode break up the runs
+        switch(rng() % 200) {
+        case 0: text += std::format("\x1b[4{}m", rng() % 8); break;
+        case 1: text += "\xc3\xa9"; break;
+        case 2: text += "\x1b[20h"; break;
+        case 3: text += "\x1b[20l"; break;
+        }
+    }
+
+    Terminal direct(6, 10), parsed(6, 10);
+    for(Terminal* vt : {&direct, &parsed}) {
+        vt->set_utf8(true);
+        vt->screen().reset(true);
+        vt->scrollback().set_capacity(100000);
+    }
+    direct.screen().enable_direct_scrollback(true);
+
+    for(size_t pos = 0; pos < text.size(); ) {
+        size_t len = std::min<size_t>(1 + rng() % 3000, text.size() - pos);
+        push(direct, std::string_view(text).substr(pos, len));
+        for(size_t i = pos; i < pos + len; i++)
+            push(parsed, std::string_view(text).substr(i, 1));
+        pos += len;
+
+        std::string expected = capture_direct(parsed, parsed.scrollback());
+        std::string actual = capture_direct(direct, direct.scrollback());
+        ASSERT_TRUE(actual == expected);
+        ASSERT_EQ(direct.state().cursor_pos().col, parsed.state().cursor_pos().col);
+    }
+    ASSERT_TRUE(direct.scrollback().size() > 4000);
+}
+
+// Skipped scrolls are reported as one damage rect for the screen
+TEST(scrollback_screen_direct_callbacks) {
+    struct Counter : ScreenCallbacks {
+        int32_t damage = 0;
+        int32_t moverect = 0;
+        int32_t pushed = 0;
+        Rect last{};
+        bool on_damage(Rect rect) override { damage++; last = rect; return true; }
+        bool on_moverect(Rect, Rect) override { moverect++; return true; }
+        bool on_sb_pushline(std::span<const ScreenCell> cells, bool) override {
+            pushed += cells[0].chars[0] == 'L';
+            return true;
+        }
+    } counter;
+
+    Terminal vt(5, 20);
+    vt.set_utf8(true);
+    Screen& screen = vt.screen();
+    screen.set_callbacks(counter);
+    screen.set_damage_merge(DamageSize::Screen);
+    screen.enable_direct_scrollback(true);
+    screen.reset(true);
+
+    push(vt, "\x1b[5H\r\n");
+    counter = {};
+    std::string text;
+    for(int i = 0; i < 100; i++)
+        text += std::format("LINE{}\r\n", i);
+    push(vt, text);
+    screen.flush_damage();
+
+    ASSERT_EQ(counter.moverect, 0);
+    ASSERT_EQ(counter.damage, 1);
+    ASSERT_EQ(counter.last.end_row, 5);
+    ASSERT_EQ(counter.pushed, 96);
+    ASSERT_SCREEN_ROW(vt, screen, 0, "LINE96");
+    ASSERT_SCREEN_ROW(vt, screen, 3, "LINE99");
+    ASSERT_SCREEN_ROW(vt, screen, 4, "");
+}
+
 // ============================================================================
 // Stress tests with golden output files
 // ============================================================================
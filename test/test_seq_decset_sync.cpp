@@ -0,0 +1,144 @@
+// test_seq_decset_sync.cpp -- per-sequence tests for synchronized output
+// (DEC private mode 2026)
+//
+// CSI ? 2026 h  begin a synchronized update
+// CSI ? 2026 l  end it
+//
+// While set, the screen holds damage, moverect, cursor and termprop callbacks
+// and delivers them merged when the mode is reset, or early once the frame
+// runs past its byte or time budget.
+
+#include "harness.h"
+
+#include <thread>
+
+// ============================================================================
+// DECSET 2026: reported by DECRQM, passed on as Prop::SyncOutput
+// ============================================================================
+
+TEST(seq_decset_sync_decrqm)
+{
+    Terminal vt(25, 80);
+    vt.set_utf8(false);
+    State& state = vt.state();
+    state.set_callbacks(state_cbs);
+    output_init(vt);
+    state.reset(true);
+    callbacks_clear();
+    output_clear();
+
+    push(vt, "\e[?2026$p");
+    ASSERT_OUTPUT_BYTES("\e[?2026;2$y", 11);
+
+    push(vt, "\e[?2026h");
+    ASSERT_EQ(g_cb.settermprop_count, 1);
+    ASSERT_EQ(g_cb.settermprop[0].prop, Prop::SyncOutput);
+    ASSERT_EQ(g_cb.settermprop[0].val.boolean, true);
+
+    output_clear();
+    push(vt, "\e[?2026$p");
+    ASSERT_OUTPUT_BYTES("\e[?2026;1$y", 11);
+
+    push(vt, "\e[?2026l");
+    output_clear();
+    push(vt, "\e[?2026$p");
+    ASSERT_OUTPUT_BYTES("\e[?2026;2$y", 11);
+}
+
+// ============================================================================
+// DECSET 2026: one merged update per frame
+// ============================================================================
+
+TEST(seq_decset_sync_holds_frame)
+{
+    Terminal vt(25, 80);
+    vt.set_utf8(true);
+    Screen& screen = vt.screen();
+    screen.set_callbacks(screen_cbs);
+    screen.reset(true);
+    callbacks_clear();
+
+    push(vt, "\e[?2026h");
+    push(vt, "\e[1;1Hhello");
+    push(vt, "\e[2;1Hworld");
+    push(vt, "\e[?25l");
+    screen.flush_damage();
+    ASSERT_EQ(g_cb.damage_count, 0);
+    ASSERT_EQ(g_cb.movecursor_count, 0);
+    ASSERT_EQ(g_cb.settermprop_count, 1);
+
+    push(vt, "\e[?2026l");
+    ASSERT_EQ(g_cb.damage_count, 1);
+    ASSERT_EQ(g_cb.damage[0].rect.start_row, 0);
+    ASSERT_EQ(g_cb.damage[0].rect.end_row, 2);
+    ASSERT_EQ(g_cb.damage[0].rect.start_col, 0);
+    ASSERT_EQ(g_cb.damage[0].rect.end_col, 5);
+    ASSERT_EQ(g_cb.movecursor_count, 1);
+    ASSERT_EQ(g_cb.movecursor[0].pos.row, 1);
+    ASSERT_EQ(g_cb.movecursor[0].pos.col, 5);
+    // The held CursorVisible, then the mode reset itself
+    ASSERT_EQ(g_cb.settermprop_count, 3);
+    ASSERT_EQ(g_cb.settermprop[1].prop, Prop::CursorVisible);
+    ASSERT_EQ(g_cb.settermprop[2].prop, Prop::SyncOutput);
+    ASSERT_EQ(g_cb.settermprop[2].val.boolean, false);
+
+    // Outside a frame, callbacks go out as before
+    callbacks_clear();
+    push(vt, "x");
+    ASSERT_EQ(g_cb.damage_count, 1);
+}
+
+// ============================================================================
+// DECSET 2026: a frame that never ends is released by its budget
+// ============================================================================
+
+TEST(seq_decset_sync_budget)
+{
+    Terminal vt(25, 80);
+    vt.set_utf8(true);
+    State& state = vt.state();
+    Screen& screen = vt.screen();
+    screen.set_callbacks(screen_cbs);
+    output_init(vt);
+    screen.reset(true);
+
+    // Bytes: released at the end of the write that crosses the limit
+    screen.set_sync_output_budget(16, std::chrono::milliseconds{0});
+    push(vt, "\e[?2026h");
+    callbacks_clear();
+    push(vt, "abcd");
+    ASSERT_EQ(g_cb.damage_count, 0);
+    push(vt, "efghijklmnop");
+    ASSERT_EQ(g_cb.damage_count, 1);
+    ASSERT_EQ(g_cb.damage[0].rect.end_col, 16);
+
+    // The mode stays set and the next frame is held again
+    push(vt, "q");
+    ASSERT_EQ(g_cb.damage_count, 1);
+    output_clear();
+    push(vt, "\e[?2026$p");
+    ASSERT_OUTPUT_BYTES("\e[?2026;1$y", 11);
+    push(vt, "\e[?2026l");
+    ASSERT_EQ(g_cb.damage_count, 2);
+
+    // Time: checked on write and when the renderer flushes
+    screen.set_sync_output_budget(0, std::chrono::milliseconds{20});
+    push(vt, "\e[?2026h");
+    callbacks_clear();
+    push(vt, "r");
+    std::this_thread::sleep_for(std::chrono::milliseconds{40});
+    ASSERT_EQ(g_cb.damage_count, 0);
+    screen.flush_damage();
+    ASSERT_EQ(g_cb.damage_count, 1);
+
+    // A hard reset ends the frame
+    screen.set_sync_output_budget(0, std::chrono::milliseconds{0});
+    callbacks_clear();
+    push(vt, "s");
+    ASSERT_EQ(g_cb.damage_count, 0);
+    state.reset(true);
+    ASSERT_TRUE(g_cb.damage_count > 0);
+    output_clear();
+    push(vt, "\e[?2026$p");
+    ASSERT_OUTPUT_BYTES("\e[?2026;2$y", 11);
+}
@@ -146,3 +146,48 @@ TEST(seq_decstbm_scroll_within_region)
     // Cursor stays at the bottom margin row
     ASSERT_CURSOR(state, 19, 0);
 }
+
+// Screen contents stay in order across repeated region and full-screen
+// scrolls in both directions, and across a resize afterwards
+TEST(seq_decstbm_screen_scroll_contents)
+{
+    Terminal vt(6, 10);
+    vt.set_utf8(false);
+    Screen& screen = vt.screen();
+    screen.reset(true);
+
+    push(vt, "top\r\n");
+    // Region rows 2-5 (1-based); row 6 stays outside it
+    push(vt, "\e[2;5r\e[2;1H");
+    for(int32_t i = 0; i < 7; i++)
+        push(vt, std::format("line{}\r\n", i));
+    push(vt, "\e[6;1Hbottom");
+
+    ASSERT_SCREEN_ROW(vt, screen, 0, "top");
+    ASSERT_SCREEN_ROW(vt, screen, 1, "line4");
+    ASSERT_SCREEN_ROW(vt, screen, 2, "line5");
+    ASSERT_SCREEN_ROW(vt, screen, 3, "line6");
+    ASSERT_SCREEN_ROW(vt, screen, 4, "");
+    ASSERT_SCREEN_ROW(vt, screen, 5, "bottom");
+
+    // Reverse index at the top margin scrolls the region down
+    push(vt, "\e[2;1H\eM\eMnew");
+    ASSERT_SCREEN_ROW(vt, screen, 1, "new");
+    ASSERT_SCREEN_ROW(vt, screen, 2, "");
+    ASSERT_SCREEN_ROW(vt, screen, 3, "line4");
+    ASSERT_SCREEN_ROW(vt, screen, 4, "line5");
+    ASSERT_SCREEN_ROW(vt, screen, 5, "bottom");
+
+    // Full screen scroll up by two
+    push(vt, "\e[r\e[2S");
+    ASSERT_SCREEN_ROW(vt, screen, 0, "");
+    ASSERT_SCREEN_ROW(vt, screen, 1, "line4");
+    ASSERT_SCREEN_ROW(vt, screen, 2, "line5");
+    ASSERT_SCREEN_ROW(vt, screen, 3, "bottom");
+    ASSERT_SCREEN_ROW(vt, screen, 4, "");
+
+    vt.set_size(7, 12);
+    ASSERT_SCREEN_ROW(vt, screen, 1, "line4");
+    ASSERT_SCREEN_ROW(vt, screen, 2, "line5");
+    ASSERT_SCREEN_ROW(vt, screen, 3, "bottom");
+}